@@ -11,6 +11,7 @@
 
 #include "shader.h"
 #include "texture.h"
+#include "mesh_base.h"
 
 // Edit by: Samuel Zaprazny
 // Adding assimp library
@@ -20,45 +21,44 @@
 
 namespace ppgso {
 
-    class Mesh_Assimp {
-        struct gl_buffer {
-        public:
-            GLuint vao, vbo, tbo, nbo, ibo = 0;
-            GLsizei size = 0;
-        };
+    class Mesh_Assimp : public MeshBase {
+        static void processNode(aiNode *node, const aiScene *pScene, std::vector<ShapeData> &shapes);
 
-        std::vector<gl_buffer> buffers;
-        const aiScene * scene;
-
-        // Loaded materials
-        std::vector<glm::vec3> ambient;
-        std::vector<glm::vec3> diffuse;
-        std::vector<glm::vec3> specular;
+        static ShapeData processMesh(aiMesh *mesh);
 
     public:
+        /*!
+         * Create an empty mesh, geometry is added later using upload.
+         *
+         * @param format - Layout of the vertex buffers.
+         */
+        explicit Mesh_Assimp(VertexFormat format = VertexFormat::Float) : MeshBase{format} {}
 
         /*!
          * Load 3D geometry from a na Wavefront .obj file.
          *
+         * When a .ppmesh file next to the obj file is newer, the geometry is uploaded straight from its memory
+         * mapping instead of importing the obj file. Levels of detail are generated for imported shapes, see
+         * generateLods.
+         *
          * The shader program passed to the object will be bound to the geometry as follows:
          * vec3 Position - Vertex position, position 0
          * vec2 TexCoord - Texture coordinate, position 1
          * vec3 Normal - Normal vector, position 2
+         * Packed meshes need the decoding described in MeshBase.
          *
          * @param obj - File path to the obj file to load.
+         * @param format - Layout of the vertex buffers.
          */
-        Mesh_Assimp(const std::string &obj);
-
-        ~Mesh_Assimp();
-
-        void processNode(aiNode *node, const aiScene *pScene);
-
-        void processMesh(aiMesh *mesh);
+        Mesh_Assimp(const std::string &obj, VertexFormat format = VertexFormat::Float);
 
         /*!
-         * Render the geometry associated with the mesh using glDrawElements.
+         * Import shapes from a Wavefront .obj file without uploading them to the GPU.
+         *
+         * @param obj - File path to the obj file to load.
+         * @return - Imported shapes.
          */
-        void render();
+        static std::vector<ShapeData> loadShapes(const std::string &obj);
     };
 }
 
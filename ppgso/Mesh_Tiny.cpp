@@ -2,16 +2,28 @@
 #include <sstream>
 
 #include "Mesh_Tiny.h"
+#include "mesh_simplifier.h"
 
-ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
+ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file, VertexFormat format) : MeshBase{format} {
+  if (loadBinary(obj_file))
+    return;
+
+  // Initialize OpenGL Buffers
+  for(auto& shape : loadShapes(obj_file)) {
+    generateLods(shape);
+    upload(shape.view());
+  }
+}
+
+std::vector<ppgso::ShapeData> ppgso::Mesh_Tiny::loadShapes(const std::string &obj_file) {
 #ifdef DEBBUG_MODE
     std::cout << "Using Tiny Obj Loader!" << std::endl;
 #endif
 
   // Load OBJ file
-  shapes.clear();
-  materials.clear();
-  std::string err = tinyobj::LoadObj(shapes, materials, obj_file.c_str());
+  std::vector<tinyobj::shape_t> shapes;
+  std::vector<tinyobj::material_t> materials;
+  std::string err = tinyobj::LoadObjFast(shapes, materials, obj_file.c_str());
 
   if (!err.empty()) {
     std::stringstream msg;
@@ -19,73 +31,12 @@ ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
     throw std::runtime_error(msg.str());
   }
 
-  // Initialize OpenGL Buffers
-  for(auto& shape : shapes) {
-    gl_buffer buffer;
-
-    if(!shape.mesh.positions.empty()) {
-      // Generate a vertex array object
-      glGenVertexArrays(1, &buffer.vao);
-      glBindVertexArray(buffer.vao);
-
-      // Generate and upload a buffer with vertex positions to GPU
-      glGenBuffers(1, &buffer.vbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.positions.size() * sizeof(float), shape.mesh.positions.data(),
-                   GL_STATIC_DRAW);
-
-      // Bind the buffer to "Position" attribute in program
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
-
-    if(!shape.mesh.texcoords.empty()) {
-      // Generate and upload a buffer with texture coordinates to GPU
-      glGenBuffers(1, &buffer.tbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.texcoords.size() * sizeof(float), shape.mesh.texcoords.data(),
-                   GL_STATIC_DRAW);
-
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
-
-    if(!shape.mesh.normals.empty()) {
-      // Generate and upload a buffer with texture coordinates to GPU
-      glGenBuffers(1, &buffer.nbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.normals.size() * sizeof(float), shape.mesh.normals.data(),
-                   GL_STATIC_DRAW);
-
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
-
-    // Generate and upload a buffer with indices to GPU
-    glGenBuffers(1, &buffer.ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, shape.mesh.indices.size() * sizeof(unsigned int), shape.mesh.indices.data(), GL_STATIC_DRAW);
-    buffer.size = (GLsizei) shape.mesh.indices.size();
-
-    // Copy it to the end of the buffers vector
-    buffers.push_back(buffer);
-  }
-}
-
-ppgso::Mesh_Tiny::~Mesh_Tiny() {
-  for(auto& buffer : buffers) {
-    glDeleteBuffers(1, &buffer.ibo);
-    glDeleteBuffers(1, &buffer.nbo);
-    glDeleteBuffers(1, &buffer.tbo);
-    glDeleteBuffers(1, &buffer.vbo);
-    glDeleteVertexArrays(1, &buffer.vao);
-  }
-}
-
-void ppgso::Mesh_Tiny::render() {
-  for(auto& buffer : buffers) {
-    // Draw object
-    glBindVertexArray(buffer.vao);
-    glDrawElements(GL_TRIANGLES, buffer.size, GL_UNSIGNED_INT, nullptr);
+  std::vector<ShapeData> result(shapes.size());
+  for (size_t i = 0; i < shapes.size(); i++) {
+    result[i].positions = std::move(shapes[i].mesh.positions);
+    result[i].texcoords = std::move(shapes[i].mesh.texcoords);
+    result[i].normals = std::move(shapes[i].mesh.normals);
+    result[i].indices = std::move(shapes[i].mesh.indices);
   }
+  return result;
 }
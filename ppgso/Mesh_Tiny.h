@@ -11,40 +11,44 @@
 
 #include "shader.h"
 #include "texture.h"
-#include "tiny_obj_loader.h"
+#include "mesh_base.h"
+#include "fast_obj_loader.h"
 
 namespace ppgso {
 
-  class Mesh_Tiny {
-    struct gl_buffer {
-    public:
-      GLuint vao, vbo, tbo, nbo, ibo = 0;
-      GLsizei size = 0;
-    };
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::vector<gl_buffer> buffers;
-
+  class Mesh_Tiny : public MeshBase {
   public:
+    /*!
+     * Create an empty mesh, geometry is added later using upload.
+     *
+     * @param format - Layout of the vertex buffers.
+     */
+    explicit Mesh_Tiny(VertexFormat format = VertexFormat::Float) : MeshBase{format} {}
 
     /*!
      * Load 3D geometry from a na Wavefront .obj file.
      *
+     * When a .ppmesh file next to the obj file is newer, the geometry is uploaded straight from its memory mapping
+     * instead of parsing the obj file. Levels of detail are generated for parsed shapes, see generateLods.
+     *
      * The shader program passed to the object will be bound to the geometry as follows:
      * vec3 Position - Vertex position, position 0
      * vec2 TexCoord - Texture coordinate, position 1
      * vec3 Normal - Normal vector, position 2
+     * Packed meshes need the decoding described in MeshBase.
      *
      * @param obj - File path to the obj file to load.
+     * @param format - Layout of the vertex buffers.
      */
-    Mesh_Tiny(const std::string &obj);
-
-    ~Mesh_Tiny();
+    Mesh_Tiny(const std::string &obj, VertexFormat format = VertexFormat::Float);
 
     /*!
-     * Render the geometry associated with the mesh using glDrawElements.
+     * Parse shapes from a Wavefront .obj file without uploading them to the GPU.
+     *
+     * @param obj - File path to the obj file to load.
+     * @return - Parsed shapes.
      */
-    void render();
+    static std::vector<ShapeData> loadShapes(const std::string &obj);
   };
 }
 
@@ -0,0 +1,104 @@
+#include <iostream>
+
+#include "asset_cache.h"
+
+ppgso::AssetCache &ppgso::AssetCache::instance() {
+  static AssetCache cache;
+  return cache;
+}
+
+void ppgso::AssetCache::setLoader(AssetLoader *assetLoader) {
+  loader = assetLoader;
+}
+
+std::shared_ptr<ppgso::Mesh> ppgso::AssetCache::mesh(const std::string &obj, VertexFormat format) {
+  auto &entry = meshes[{obj, format}];
+
+  // Reuse the mesh while anyone still holds it
+  if (auto mesh = entry.asset.lock()) {
+    entry.hits++;
+    return mesh;
+  }
+
+  entry.loads++;
+  if (loader) {
+    // Map entries never move, so the callback can keep a pointer to this one
+    auto mesh = std::make_shared<Mesh>(format);
+    auto pending = &entry;
+    loader->loadMesh(obj, mesh, [pending] {
+      if (auto loaded = pending->asset.lock())
+        pending->bytes = loaded->getByteSize();
+    });
+    entry.asset = mesh;
+    entry.bytes = 0;
+    return mesh;
+  }
+
+  auto mesh = std::make_shared<Mesh>(obj, format);
+  entry.asset = mesh;
+  entry.bytes = mesh->getByteSize();
+  return mesh;
+}
+
+std::shared_ptr<ppgso::Texture> ppgso::AssetCache::texture(const std::string &bmp) {
+  auto &entry = textures[bmp];
+
+  // Reuse the texture while anyone still holds it
+  if (auto texture = entry.asset.lock()) {
+    entry.hits++;
+    return texture;
+  }
+
+  entry.loads++;
+  if (loader) {
+    // Neutral grey until the image is decoded, 4x4 is the smallest size that holds all mip levels
+    auto texture = std::make_shared<Texture>(4, 4);
+    texture->image.clear({128, 128, 128});
+    texture->update();
+
+    auto pending = &entry;
+    loader->loadTexture(bmp, texture, [pending] {
+      if (auto loaded = pending->asset.lock())
+        pending->bytes = loaded->getByteSize();
+    });
+    entry.asset = texture;
+    entry.bytes = 0;
+    return texture;
+  }
+
+  // Precomputed mipmaps are preferred when the BMP was not changed since they were written
+  std::shared_ptr<Texture> texture;
+  if (TextureFile::isUpToDate(bmp)) {
+    try {
+      texture = std::make_shared<Texture>(TextureFile{TextureFile::getBinaryPath(bmp)});
+    } catch (std::exception &e) {
+      std::cerr << "Ignoring " << TextureFile::getBinaryPath(bmp) << ": " << e.what() << std::endl;
+    }
+  }
+  if (!texture)
+    texture = std::make_shared<Texture>(image::MappedBMP{bmp});
+  entry.asset = texture;
+  entry.bytes = texture->getByteSize();
+  return texture;
+}
+
+template<typename Key, typename T>
+ppgso::AssetCache::Stats ppgso::AssetCache::getStats(const std::map<Key, Entry<T>> &entries) {
+  Stats stats;
+  for (auto &item : entries) {
+    auto &entry = item.second;
+    stats.hits += entry.hits;
+    stats.misses += entry.loads;
+    stats.bytes += entry.loads * entry.bytes;
+    stats.bytesSaved += entry.hits * entry.bytes;
+  }
+  return stats;
+}
+
+ppgso::AssetCache::Stats ppgso::AssetCache::getMeshStats() const {
+  return getStats(meshes);
+}
+
+ppgso::AssetCache::Stats ppgso::AssetCache::getTextureStats() const {
+  return getStats(textures);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "ppgso.h"
+
+namespace ppgso {
+
+  class AssetLoader;
+
+  /*!
+   * Shared cache of meshes and textures keyed by file path.
+   *
+   * Every asset is loaded and uploaded to the GPU only once. The cache hands out shared handles and keeps only weak
+   * references, so an asset is released as soon as the last object using it is destroyed.
+   *
+   * With a loader set, requests return immediately: meshes start empty and textures show a placeholder until the
+   * background loader uploads the real data.
+   */
+  class AssetCache {
+  public:
+    /*!
+     * Load statistics of one asset kind.
+     */
+    struct Stats {
+      // Requests served from the cache
+      size_t hits = 0;
+      // Requests that had to load the asset from disk
+      size_t misses = 0;
+      // Bytes uploaded to the GPU by misses
+      size_t bytes = 0;
+      // Bytes that hits did not have to load and upload again
+      size_t bytesSaved = 0;
+    };
+
+    /*!
+     * Get the cache shared by the whole application.
+     *
+     * @return - Reference to the global cache instance.
+     */
+    static AssetCache &instance();
+
+    /*!
+     * Load assets requested from now on in the background.
+     *
+     * @param loader - Loader to use or nullptr to load synchronously again, must outlive its use by the cache.
+     */
+    void setLoader(AssetLoader *loader);
+
+    /*!
+     * Get a mesh loaded from the Wavefront .obj file, loading it on the first request. Each vertex format of the
+     * same file is a separate mesh.
+     *
+     * @param obj - File path to the obj file.
+     * @param format - Layout of the vertex buffers.
+     * @return - Shared handle to the mesh.
+     */
+    std::shared_ptr<Mesh> mesh(const std::string &obj, VertexFormat format = VertexFormat::Float);
+
+    /*!
+     * Get a texture loaded from the BMP file, loading it on the first request. An up to date .pptex file next to
+     * the BMP is used instead.
+     *
+     * @param bmp - File path to the BMP image.
+     * @return - Shared handle to the texture.
+     */
+    std::shared_ptr<Texture> texture(const std::string &bmp);
+
+    /*!
+     * Get the load statistics of meshes, assets still loading in the background count with 0 bytes.
+     */
+    Stats getMeshStats() const;
+
+    /*!
+     * Get the load statistics of textures, assets still loading in the background count with 0 bytes.
+     */
+    Stats getTextureStats() const;
+
+  private:
+    template<typename T>
+    struct Entry {
+      std::weak_ptr<T> asset;
+      size_t bytes = 0;
+      size_t loads = 0;
+      size_t hits = 0;
+    };
+
+    template<typename Key, typename T>
+    static Stats getStats(const std::map<Key, Entry<T>> &entries);
+
+    std::map<std::pair<std::string, VertexFormat>, Entry<Mesh>> meshes;
+    std::map<std::string, Entry<Texture>> textures;
+    AssetLoader *loader = nullptr;
+  };
+
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "asset_loader.h"
+#include "mesh_file.h"
+#include "mesh_simplifier.h"
+
+struct ppgso::AssetLoader::Job {
+  std::string path;
+  std::function<void()> onReady;
+  // Message of an exception thrown by load, the asset is left untouched
+  std::string error;
+
+  virtual ~Job() = default;
+
+  /*!
+   * Read the asset into CPU memory, runs on a worker thread.
+   */
+  virtual void load() = 0;
+
+  /*!
+   * Move the loaded data to the GPU, runs on the OpenGL thread.
+   */
+  virtual void upload() = 0;
+};
+
+struct ppgso::AssetLoader::MeshJob : Job {
+  std::weak_ptr<Mesh> mesh;
+  std::unique_ptr<MeshFile> binary;
+  std::vector<ShapeData> shapes;
+
+  void load() override {
+    if (MeshFile::isUpToDate(path)) {
+      try {
+        binary = std::make_unique<MeshFile>(MeshFile::getBinaryPath(path));
+        return;
+      } catch (std::exception &e) {
+        std::cerr << "Ignoring " << MeshFile::getBinaryPath(path) << ": " << e.what() << std::endl;
+      }
+    }
+    shapes = Mesh::loadShapes(path);
+    for (auto &shape : shapes)
+      generateLods(shape);
+  }
+
+  void upload() override {
+    auto target = mesh.lock();
+    if (!target) return;
+
+    if (binary) {
+      for (auto &shape : binary->getShapes())
+        target->upload(shape);
+    } else {
+      for (auto &shape : shapes)
+        target->upload(shape.view());
+    }
+    if (onReady) onReady();
+  }
+};
+
+struct ppgso::AssetLoader::TextureJob : Job {
+  std::weak_ptr<Texture> texture;
+  std::unique_ptr<TextureFile> binary;
+  std::unique_ptr<image::MappedBMP> bmp;
+
+  void load() override {
+    // Pixels are read from disk here, the OpenGL thread then only copies them from memory
+    if (TextureFile::isUpToDate(path)) {
+      try {
+        binary = std::make_unique<TextureFile>(TextureFile::getBinaryPath(path));
+        binary->prefault();
+        return;
+      } catch (std::exception &e) {
+        std::cerr << "Ignoring " << TextureFile::getBinaryPath(path) << ": " << e.what() << std::endl;
+      }
+    }
+    bmp = std::make_unique<image::MappedBMP>(path);
+    bmp->prefault();
+  }
+
+  void upload() override {
+    auto target = texture.lock();
+    if (!target) return;
+
+    if (binary)
+      target->setImage(*binary);
+    else
+      target->setImage(*bmp);
+    if (onReady) onReady();
+  }
+};
+
+ppgso::AssetLoader::AssetLoader(unsigned int threads) {
+  if (threads == 0) {
+    // Leave one core to the OpenGL thread, which keeps rendering while assets load
+    threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  }
+
+  for (unsigned int i = 0; i < threads; i++)
+    workers.emplace_back(&AssetLoader::work, this);
+}
+
+ppgso::AssetLoader::~AssetLoader() {
+  {
+    std::lock_guard<std::mutex> lock{requestsMutex};
+    stopping = true;
+  }
+  requestsReady.notify_all();
+
+  for (auto &worker : workers)
+    worker.join();
+}
+
+void ppgso::AssetLoader::loadMesh(const std::string &obj, const std::shared_ptr<Mesh> &mesh,
+                                  std::function<void()> onReady) {
+  auto job = std::make_unique<MeshJob>();
+  job->path = obj;
+  job->onReady = std::move(onReady);
+  job->mesh = mesh;
+  enqueue(std::move(job));
+}
+
+void ppgso::AssetLoader::loadTexture(const std::string &bmp, const std::shared_ptr<Texture> &texture,
+                                     std::function<void()> onReady) {
+  auto job = std::make_unique<TextureJob>();
+  job->path = bmp;
+  job->onReady = std::move(onReady);
+  job->texture = texture;
+  enqueue(std::move(job));
+}
+
+void ppgso::AssetLoader::enqueue(std::unique_ptr<Job> job) {
+  pending++;
+  {
+    std::lock_guard<std::mutex> lock{requestsMutex};
+    requests.push_back(std::move(job));
+  }
+  requestsReady.notify_one();
+}
+
+void ppgso::AssetLoader::work() {
+  while (true) {
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock{requestsMutex};
+      requestsReady.wait(lock, [this] { return stopping || !requests.empty(); });
+      if (stopping) return;
+      job = std::move(requests.front());
+      requests.pop_front();
+    }
+
+    try {
+      job->load();
+    } catch (std::exception &e) {
+      job->error = e.what();
+    }
+    finished.push(std::move(job));
+  }
+}
+
+size_t ppgso::AssetLoader::update(double budget) {
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+
+  size_t uploaded = 0;
+  std::unique_ptr<Job> job;
+  while (finished.pop(job)) {
+    if (job->error.empty())
+      job->upload();
+    else
+      std::cerr << job->error << std::endl;
+
+    job.reset();
+    pending--;
+    uploaded++;
+
+    if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= budget)
+      break;
+  }
+  return uploaded;
+}
+
+size_t ppgso::AssetLoader::getPending() const {
+  return pending;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ppgso.h"
+#include "mpsc_queue.h"
+
+namespace ppgso {
+
+  /*!
+   * Thread pool that loads meshes and textures in the background.
+   *
+   * Worker threads parse obj files and map .ppmesh, .pptex and BMP files into memory. Finished assets are
+   * handed to the OpenGL thread through a lock-free queue and uploaded by update, which the application calls every
+   * frame with a time budget. Until then meshes stay empty and textures keep their placeholder image.
+   */
+  class AssetLoader {
+  public:
+    /*!
+     * Start the worker threads.
+     *
+     * @param threads - Number of worker threads, 0 uses all cores but one.
+     */
+    explicit AssetLoader(unsigned int threads = 0);
+
+    /*!
+     * Stop the worker threads, assets that were not uploaded yet are dropped.
+     */
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader &) = delete;
+    AssetLoader &operator=(const AssetLoader &) = delete;
+
+    /*!
+     * Load geometry from an obj file into an empty mesh.
+     *
+     * @param obj - File path to the obj file.
+     * @param mesh - Mesh to upload the geometry into, it is not kept alive by the loader.
+     * @param onReady - Called on the OpenGL thread after the upload.
+     */
+    void loadMesh(const std::string &obj, const std::shared_ptr<Mesh> &mesh, std::function<void()> onReady = {});
+
+    /*!
+     * Load a BMP image into a texture, or its .pptex file when it is up to date.
+     *
+     * @param bmp - File path to the BMP image.
+     * @param texture - Texture to replace the image of, it is not kept alive by the loader.
+     * @param onReady - Called on the OpenGL thread after the upload.
+     */
+    void loadTexture(const std::string &bmp, const std::shared_ptr<Texture> &texture,
+                     std::function<void()> onReady = {});
+
+    /*!
+     * Upload finished assets to the GPU, must be called from the OpenGL thread.
+     * At least one asset is uploaded per call when any is ready, so loading always progresses.
+     *
+     * @param budget - Time in milliseconds after which no further uploads are started.
+     * @return - Number of assets uploaded.
+     */
+    size_t update(double budget);
+
+    /*!
+     * Get the number of assets that are requested but not uploaded yet.
+     *
+     * @return - Number of pending assets.
+     */
+    size_t getPending() const;
+
+  private:
+    struct Job;
+    struct MeshJob;
+    struct TextureJob;
+
+    void enqueue(std::unique_ptr<Job> job);
+    void work();
+
+    std::vector<std::thread> workers;
+    std::deque<std::unique_ptr<Job>> requests;
+    std::mutex requestsMutex;
+    std::condition_variable requestsReady;
+    bool stopping = false;
+
+    MpscQueue<std::unique_ptr<Job>> finished;
+    std::atomic<size_t> pending{0};
+  };
+
+}
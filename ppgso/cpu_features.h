@@ -0,0 +1,52 @@
+#pragma once
+
+// Runtime detection of SIMD instruction sets on x86 processors.
+//
+// Functions using newer instructions are compiled with PPGSO_TARGET("...") so the rest of the library keeps the
+// baseline instruction set, and they are only called after the matching cpuSupports* check returned true.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define PPGSO_X86 1
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+  #define PPGSO_TARGET(isa) __attribute__((target(isa)))
+#else
+  #define PPGSO_TARGET(isa)
+#endif
+
+#ifdef PPGSO_X86
+namespace ppgso {
+
+#ifdef _MSC_VER
+  inline bool cpuSupportsSSSE3() {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+  }
+
+  inline bool cpuSupportsAVX2() {
+    int info[4];
+    __cpuid(info, 1);
+    // The operating system has to save the AVX registers too
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+  }
+#else
+  inline bool cpuSupportsSSSE3() {
+    return __builtin_cpu_supports("ssse3");
+  }
+
+  inline bool cpuSupportsAVX2() {
+    return __builtin_cpu_supports("avx2");
+  }
+#endif
+
+}
+#endif
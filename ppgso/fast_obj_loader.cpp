@@ -0,0 +1,600 @@
+//
+// Fast path of the tinyobj loader, see fast_obj_loader.h
+//
+// The file is parsed in two passes over the mapped memory. The first pass
+// only counts 'v', 'vn' and 'vt' lines of every chunk, so all attribute
+// arrays can be allocated once and every chunk knows where its vertices
+// start. The second pass parses the chunks in parallel, writing attributes
+// straight into the shared arrays and collecting faces with indices that are
+// already absolute. Faces are then turned into shapes in file order, which
+// gives exactly the shapes LoadObj produces.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "fast_obj_loader.h"
+#include "mapped_file.h"
+
+namespace tinyobj {
+
+namespace {
+
+// Smaller files are not worth starting threads for
+const size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+struct corner {
+  int v_idx, vt_idx, vn_idx;
+};
+
+struct event {
+  enum kind { USEMTL, MTLLIB, GROUP, OBJECT } type;
+  // Number of faces of the chunk that precede the event
+  size_t face;
+  std::string name;
+};
+
+struct chunk {
+  const char *begin, *end;
+
+  size_t v_count = 0, vn_count = 0, vt_count = 0;
+  size_t v_base = 0, vn_base = 0, vt_base = 0;
+
+  std::vector<corner> corners;
+  std::vector<unsigned int> face_sizes;
+  std::vector<event> events;
+};
+
+enum line_type {
+  LINE_OTHER,
+  LINE_V,
+  LINE_VN,
+  LINE_VT,
+  LINE_F,
+  LINE_USEMTL,
+  LINE_MTLLIB,
+  LINE_G,
+  LINE_O
+};
+
+inline bool isSpace(const char c) { return (c == ' ') || (c == '\t'); }
+
+inline bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+
+inline void skipSpace(const char *&p, const char *end) {
+  while (p < end && isSpace(*p))
+    p++;
+}
+
+inline const char *tokenEnd(const char *p, const char *end) {
+  while (p < end && !isSpace(*p))
+    p++;
+  return p;
+}
+
+// Calls fn(begin, end) for every line without the line terminator
+template <typename F>
+void forEachLine(const char *p, const char *end, F fn) {
+  while (p < end) {
+    const char *eol =
+        static_cast<const char *>(memchr(p, '\n', (size_t)(end - p)));
+    if (!eol)
+      eol = end;
+    const char *line_end = eol;
+    if (line_end > p && line_end[-1] == '\r')
+      line_end--;
+    fn(p, line_end);
+    p = eol + 1;
+  }
+}
+
+// Classify the line and move p past the keyword
+inline line_type classify(const char *&p, const char *end) {
+  skipSpace(p, end);
+  size_t n = (size_t)(end - p);
+  if (n < 2)
+    return LINE_OTHER;
+
+  if (p[0] == 'v') {
+    if (isSpace(p[1])) {
+      p += 2;
+      return LINE_V;
+    }
+    if (n >= 3 && p[1] == 'n' && isSpace(p[2])) {
+      p += 3;
+      return LINE_VN;
+    }
+    if (n >= 3 && p[1] == 't' && isSpace(p[2])) {
+      p += 3;
+      return LINE_VT;
+    }
+    return LINE_OTHER;
+  }
+  if (p[0] == 'f' && isSpace(p[1])) {
+    p += 2;
+    return LINE_F;
+  }
+  if (p[0] == 'g' && isSpace(p[1])) {
+    p += 2;
+    return LINE_G;
+  }
+  if (p[0] == 'o' && isSpace(p[1])) {
+    p += 2;
+    return LINE_O;
+  }
+  if (n >= 7 && isSpace(p[6])) {
+    if (memcmp(p, "usemtl", 6) == 0) {
+      p += 7;
+      return LINE_USEMTL;
+    }
+    if (memcmp(p, "mtllib", 6) == 0) {
+      p += 7;
+      return LINE_MTLLIB;
+    }
+  }
+  return LINE_OTHER;
+}
+
+// Same grammar as tryParseDouble in tiny_obj_loader.cpp, but the digits are
+// accumulated as an integer and scaled once, which is faster and rounds
+// correctly.
+bool parseNumber(const char *s, const char *end, double *result) {
+  static const double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+  if (s >= end)
+    return false;
+
+  bool negative = false;
+  if (*s == '+' || *s == '-') {
+    negative = *s == '-';
+    s++;
+  }
+  if (s >= end || !isDigit(*s))
+    return false;
+
+  uint64_t mantissa = 0;
+  int digits = 0, scale = 0;
+  for (; s < end && isDigit(*s); s++) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+      if (mantissa)
+        digits++;
+    } else {
+      scale++;
+    }
+  }
+
+  if (s < end && *s == '.') {
+    for (s++; s < end && isDigit(*s); s++) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+        if (mantissa)
+          digits++;
+        scale--;
+      }
+    }
+  }
+
+  if (s < end && (*s == 'e' || *s == 'E')) {
+    s++;
+    bool exp_negative = false;
+    if (s < end && (*s == '+' || *s == '-')) {
+      exp_negative = *s == '-';
+      s++;
+    }
+    // Empty E is not allowed.
+    if (s >= end || !isDigit(*s))
+      return false;
+    int exponent = 0;
+    for (; s < end && isDigit(*s); s++) {
+      if (exponent < 100000)
+        exponent = exponent * 10 + (*s - '0');
+    }
+    scale += exp_negative ? -exponent : exponent;
+  }
+
+  double value = (double)mantissa;
+  if (scale < 0)
+    value = scale >= -22 ? value / POW10[-scale] : value * pow(10.0, scale);
+  else if (scale > 0)
+    value = scale <= 22 ? value * POW10[scale] : value * pow(10.0, scale);
+
+  *result = negative ? -value : value;
+  return true;
+}
+
+inline float parseFloat(const char *&p, const char *end) {
+  skipSpace(p, end);
+  const char *e = tokenEnd(p, end);
+  double value = 0.0;
+  parseNumber(p, e, &value);
+  p = e;
+  return static_cast<float>(value);
+}
+
+// atoi semantics, stops at the first character that is not a digit
+inline int parseInt(const char *&p, const char *end) {
+  bool negative = false;
+  if (p < end && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    p++;
+  }
+  int value = 0;
+  for (; p < end && isDigit(*p); p++)
+    value = value * 10 + (*p - '0');
+  return negative ? -value : value;
+}
+
+inline void skipIndex(const char *&p, const char *end) {
+  while (p < end && *p != '/' && !isSpace(*p))
+    p++;
+}
+
+// Make index zero-base, and also support relative index.
+inline int fixIndex(int idx, size_t n) {
+  if (idx > 0)
+    return idx - 1;
+  if (idx == 0)
+    return 0;
+  return (int)n + idx; // negative value = relative
+}
+
+// Parse triples: i, i/j/k, i//k, i/j
+corner parseCorner(const char *&p, const char *end, size_t v_count,
+                   size_t vt_count, size_t vn_count) {
+  corner c = {-1, -1, -1};
+
+  c.v_idx = fixIndex(parseInt(p, end), v_count);
+  skipIndex(p, end);
+  if (p >= end || *p != '/')
+    return c;
+  p++;
+
+  // i//k
+  if (p < end && *p == '/') {
+    p++;
+    c.vn_idx = fixIndex(parseInt(p, end), vn_count);
+    skipIndex(p, end);
+    return c;
+  }
+
+  // i/j/k or i/j
+  c.vt_idx = fixIndex(parseInt(p, end), vt_count);
+  skipIndex(p, end);
+  if (p >= end || *p != '/')
+    return c;
+
+  // i/j/k
+  p++;
+  c.vn_idx = fixIndex(parseInt(p, end), vn_count);
+  skipIndex(p, end);
+  return c;
+}
+
+void countChunk(chunk &c) {
+  forEachLine(c.begin, c.end, [&c](const char *p, const char *end) {
+    switch (classify(p, end)) {
+    case LINE_V:
+      c.v_count++;
+      break;
+    case LINE_VN:
+      c.vn_count++;
+      break;
+    case LINE_VT:
+      c.vt_count++;
+      break;
+    default:
+      break;
+    }
+  });
+}
+
+void parseChunk(chunk &c, float *v, float *vn, float *vt) {
+  size_t v_count = c.v_base, vn_count = c.vn_base, vt_count = c.vt_base;
+
+  forEachLine(c.begin, c.end, [&](const char *p, const char *end) {
+    line_type type = classify(p, end);
+    switch (type) {
+    case LINE_V: {
+      float *out = v + 3 * v_count++;
+      out[0] = parseFloat(p, end);
+      out[1] = parseFloat(p, end);
+      out[2] = parseFloat(p, end);
+      break;
+    }
+    case LINE_VN: {
+      float *out = vn + 3 * vn_count++;
+      out[0] = parseFloat(p, end);
+      out[1] = parseFloat(p, end);
+      out[2] = parseFloat(p, end);
+      break;
+    }
+    case LINE_VT: {
+      float *out = vt + 2 * vt_count++;
+      out[0] = parseFloat(p, end);
+      out[1] = parseFloat(p, end);
+      break;
+    }
+    case LINE_F: {
+      unsigned int size = 0;
+      skipSpace(p, end);
+      while (p < end) {
+        c.corners.push_back(parseCorner(p, end, v_count, vt_count, vn_count));
+        size++;
+        skipSpace(p, end);
+      }
+      c.face_sizes.push_back(size);
+      break;
+    }
+    case LINE_USEMTL:
+    case LINE_MTLLIB:
+    case LINE_O: {
+      // First word, same as sscanf "%s"
+      skipSpace(p, end);
+      event e;
+      e.type = type == LINE_USEMTL   ? event::USEMTL
+               : type == LINE_MTLLIB ? event::MTLLIB
+                                     : event::OBJECT;
+      e.face = c.face_sizes.size();
+      e.name.assign(p, tokenEnd(p, end));
+      c.events.push_back(e);
+      break;
+    }
+    case LINE_G: {
+      // Second word of the line including the 'g' itself
+      skipSpace(p, end);
+      event e;
+      e.type = event::GROUP;
+      e.face = c.face_sizes.size();
+      e.name.assign(p, tokenEnd(p, end));
+      c.events.push_back(e);
+      break;
+    }
+    default:
+      break;
+    }
+  });
+}
+
+// Vertex deduplication of one face group with open addressing and linear
+// probing. Slots of previous groups are invalidated by bumping the
+// generation instead of clearing the table.
+class vertex_cache {
+public:
+  void clear() {
+    generation++;
+    count = 0;
+  }
+
+  // Returns the slot of the corner, 'found' tells if it already has a value
+  unsigned int &find(const corner &c, bool &found) {
+    if (slots.empty() || 2 * (count + 1) > slots.size())
+      grow();
+
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash(c) & mask;; i = (i + 1) & mask) {
+      slot &s = slots[i];
+      if (s.generation != generation) {
+        s.generation = generation;
+        s.key = c;
+        count++;
+        found = false;
+        return s.value;
+      }
+      if (s.key.v_idx == c.v_idx && s.key.vt_idx == c.vt_idx &&
+          s.key.vn_idx == c.vn_idx) {
+        found = true;
+        return s.value;
+      }
+    }
+  }
+
+private:
+  struct slot {
+    corner key;
+    unsigned int value;
+    uint32_t generation;
+  };
+
+  static size_t hash(const corner &c) {
+    uint32_t h = (uint32_t)c.v_idx * 0x9E3779B1u;
+    h ^= (uint32_t)c.vt_idx * 0x85EBCA77u;
+    h ^= (uint32_t)c.vn_idx * 0xC2B2AE3Du;
+    return h ^ (h >> 16);
+  }
+
+  void grow() {
+    std::vector<slot> old;
+    old.swap(slots);
+    slots.resize(std::max<size_t>(old.size() * 2, 1024), slot{{0, 0, 0}, 0, 0});
+
+    uint32_t live = generation;
+    generation++;
+    count = 0;
+    for (auto &s : old) {
+      if (s.generation != live)
+        continue;
+      bool found;
+      find(s.key, found) = s.value;
+    }
+  }
+
+  std::vector<slot> slots;
+  size_t count = 0;
+  uint32_t generation = 1;
+};
+
+} // namespace
+
+std::string LoadObjFast(std::vector<shape_t> &shapes,
+                        std::vector<material_t> &materials,
+                        const char *filename, const char *mtl_basepath,
+                        unsigned int threads) {
+  shapes.clear();
+
+  std::stringstream err;
+
+  std::unique_ptr<ppgso::MappedFile> file;
+  try {
+    file.reset(new ppgso::MappedFile(filename));
+  } catch (std::exception &) {
+    err << "Cannot open file [" << filename << "]" << std::endl;
+    return err.str();
+  }
+
+  const char *data = reinterpret_cast<const char *>(file->data());
+  size_t size = file->size();
+
+  // Split into chunks at line boundaries
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  size_t chunk_count =
+      std::max<size_t>(1, std::min<size_t>(threads, size / MIN_CHUNK_SIZE));
+
+  std::vector<chunk> chunks(chunk_count);
+  const char *begin = data;
+  for (size_t i = 0; i < chunk_count; i++) {
+    const char *end = data + size * (i + 1) / chunk_count;
+    if (i + 1 < chunk_count) {
+      end = static_cast<const char *>(
+          memchr(end, '\n', (size_t)(data + size - end)));
+      end = end ? end + 1 : data + size;
+    }
+    chunks[i].begin = begin;
+    chunks[i].end = std::max(begin, end);
+    begin = chunks[i].end;
+  }
+
+  auto forEachChunk = [&chunks](std::function<void(chunk &)> fn) {
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunks.size(); i++)
+      workers.emplace_back(fn, std::ref(chunks[i]));
+    fn(chunks[0]);
+    for (auto &worker : workers)
+      worker.join();
+  };
+
+  // Pass 1: attribute counts give every chunk its offset into the arrays
+  forEachChunk(countChunk);
+
+  size_t v_total = 0, vn_total = 0, vt_total = 0;
+  for (auto &c : chunks) {
+    c.v_base = v_total;
+    c.vn_base = vn_total;
+    c.vt_base = vt_total;
+    v_total += c.v_count;
+    vn_total += c.vn_count;
+    vt_total += c.vt_count;
+  }
+
+  std::vector<float> v(3 * v_total), vn(3 * vn_total), vt(2 * vt_total);
+
+  // Pass 2: parse attributes in place and collect faces
+  forEachChunk([&](chunk &c) { parseChunk(c, v.data(), vn.data(), vt.data()); });
+
+  // Build shapes in file order, a new shape starts at every usemtl, g and o
+  std::map<std::string, int> material_map;
+  MaterialFileReader readMatFn(mtl_basepath ? mtl_basepath : "");
+  int material = -1;
+  std::string name;
+
+  shape_t shape;
+  vertex_cache cache;
+
+  auto flush = [&]() {
+    if (shape.mesh.indices.empty())
+      return;
+    shape.name = name;
+    shapes.push_back(std::move(shape));
+    shape = shape_t();
+    cache.clear();
+  };
+
+  auto vertex = [&](const corner &c, unsigned int &index) -> bool {
+    bool found;
+    unsigned int &slot = cache.find(c, found);
+    if (found) {
+      index = slot;
+      return true;
+    }
+
+    if (c.v_idx < 0 || (size_t)c.v_idx >= v_total ||
+        (c.vn_idx >= 0 && (size_t)c.vn_idx >= vn_total) ||
+        (c.vt_idx >= 0 && (size_t)c.vt_idx >= vt_total))
+      return false;
+
+    mesh_t &mesh = shape.mesh;
+    mesh.positions.insert(mesh.positions.end(), &v[3 * c.v_idx],
+                          &v[3 * c.v_idx] + 3);
+    if (c.vn_idx >= 0)
+      mesh.normals.insert(mesh.normals.end(), &vn[3 * c.vn_idx],
+                          &vn[3 * c.vn_idx] + 3);
+    if (c.vt_idx >= 0)
+      mesh.texcoords.insert(mesh.texcoords.end(), &vt[2 * c.vt_idx],
+                            &vt[2 * c.vt_idx] + 2);
+
+    slot = index = static_cast<unsigned int>(mesh.positions.size() / 3 - 1);
+    return true;
+  };
+
+  for (auto &c : chunks) {
+    size_t next_event = 0;
+    size_t first_corner = 0;
+
+    for (size_t f = 0; f <= c.face_sizes.size(); f++) {
+      for (; next_event < c.events.size() && c.events[next_event].face == f;
+           next_event++) {
+        const event &e = c.events[next_event];
+        if (e.type == event::MTLLIB) {
+          std::string err_mtl = readMatFn(e.name, materials, material_map);
+          if (!err_mtl.empty())
+            return err_mtl;
+          continue;
+        }
+
+        // Create face group per material, group and object.
+        flush();
+        if (e.type == event::USEMTL) {
+          auto it = material_map.find(e.name);
+          material = it != material_map.end() ? it->second : -1;
+        } else {
+          name = e.name;
+        }
+      }
+
+      if (f == c.face_sizes.size())
+        break;
+
+      // Polygon -> face fan conversion
+      const corner *face = &c.corners[first_corner];
+      unsigned int face_size = c.face_sizes[f];
+      first_corner += face_size;
+      for (unsigned int k = 2; k < face_size; k++) {
+        unsigned int i0, i1, i2;
+        if (!vertex(face[0], i0) || !vertex(face[k - 1], i1) ||
+            !vertex(face[k], i2)) {
+          err << "Face index out of range in [" << filename << "]"
+              << std::endl;
+          return err.str();
+        }
+        shape.mesh.indices.push_back(i0);
+        shape.mesh.indices.push_back(i1);
+        shape.mesh.indices.push_back(i2);
+        shape.mesh.material_ids.push_back(material);
+      }
+    }
+  }
+  flush();
+
+  return err.str();
+}
+}
@@ -0,0 +1,26 @@
+#ifndef _FAST_OBJ_LOADER_H
+#define _FAST_OBJ_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include "tiny_obj_loader.h"
+
+namespace tinyobj {
+
+/// Loads .obj from a memory mapped file into the same shapes and materials
+/// as LoadObj.
+/// Lines are tokenized in place without allocating, vertices are
+/// deduplicated with a flat open-addressing hash instead of std::map.
+/// Files larger than a few hundred KB are split into chunks at line
+/// boundaries and parsed in parallel, the chunks are merged in file order.
+/// 'threads' limits the number of chunks, 0 uses all cores.
+/// Returns empty string when loading .obj success.
+std::string LoadObjFast(std::vector<shape_t> &shapes,       // [output]
+                        std::vector<material_t> &materials, // [output]
+                        const char *filename,
+                        const char *mtl_basepath = nullptr,
+                        unsigned int threads = 0);
+}
+
+#endif // _FAST_OBJ_LOADER_H
@@ -0,0 +1,117 @@
+#include "gl_state.h"
+
+ppgso::GLState::CallStats &ppgso::GLState::getCallStats() {
+  static CallStats stats;
+  return stats;
+}
+
+ppgso::GLState::State &ppgso::GLState::state() {
+  static State current;
+  return current;
+}
+
+template<typename T>
+bool ppgso::GLState::change(Cached<T> &cached, const T &value) {
+  auto &stats = getCallStats();
+  if (cached.known && cached.value == value) {
+    stats.elided++;
+    return false;
+  }
+  cached.value = value;
+  cached.known = true;
+  stats.issued++;
+  return true;
+}
+
+void ppgso::GLState::useProgram(GLuint program) {
+  if (change(state().program, program))
+    glUseProgram(program);
+}
+
+void ppgso::GLState::bindVertexArray(GLuint vao) {
+  if (change(state().vertexArray, vao))
+    glBindVertexArray(vao);
+}
+
+void ppgso::GLState::activeTexture(GLuint unit) {
+  if (change(state().activeUnit, unit))
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void ppgso::GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+  activeTexture(unit);
+  if (change(state().textures[{unit, target}], texture))
+    glBindTexture(target, texture);
+}
+
+void ppgso::GLState::bindFramebuffer(GLuint framebuffer) {
+  if (change(state().framebuffer, framebuffer))
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void ppgso::GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  if (change(state().viewport, {{x, y}, {width, height}}))
+    glViewport(x, y, width, height);
+}
+
+void ppgso::GLState::getViewport(GLint viewport[4]) {
+  auto &cached = state().viewport;
+  if (!cached.known) {
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    cached.value = {{viewport[0], viewport[1]}, {viewport[2], viewport[3]}};
+    cached.known = true;
+    return;
+  }
+  viewport[0] = cached.value.first.first;
+  viewport[1] = cached.value.first.second;
+  viewport[2] = cached.value.second.first;
+  viewport[3] = cached.value.second.second;
+}
+
+void ppgso::GLState::setEnabled(GLenum capability, bool enabled) {
+  if (!change(state().capabilities[capability], enabled)) return;
+  if (enabled)
+    glEnable(capability);
+  else
+    glDisable(capability);
+}
+
+void ppgso::GLState::depthFunc(GLenum function) {
+  if (change(state().depthFunc, function))
+    glDepthFunc(function);
+}
+
+void ppgso::GLState::depthMask(bool write) {
+  if (change(state().depthMask, write))
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void ppgso::GLState::blendFunc(GLenum source, GLenum destination) {
+  if (change(state().blendFunc, {source, destination}))
+    glBlendFunc(source, destination);
+}
+
+// OpenGL resets the binding of a deleted object to 0
+void ppgso::GLState::deleteProgram(GLuint name) {
+  auto &program = state().program;
+  if (program.known && program.value == name) program.known = false;
+}
+
+void ppgso::GLState::deleteVertexArray(GLuint name) {
+  auto &vertexArray = state().vertexArray;
+  if (vertexArray.known && vertexArray.value == name) vertexArray.value = 0;
+}
+
+void ppgso::GLState::deleteTexture(GLuint name) {
+  for (auto &texture : state().textures)
+    if (texture.second.known && texture.second.value == name) texture.second.value = 0;
+}
+
+void ppgso::GLState::deleteFramebuffer(GLuint name) {
+  auto &framebuffer = state().framebuffer;
+  if (framebuffer.known && framebuffer.value == name) framebuffer.value = 0;
+}
+
+void ppgso::GLState::invalidate() {
+  state() = State{};
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <utility>
+
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Cache of the OpenGL state changed while drawing, calls setting a value that is already set are dropped.
+   *
+   * Tracks the bound program, vertex array, textures of every unit, framebuffer, viewport, enabled capabilities
+   * and the depth and blend functions of the single OpenGL context. Nothing is known at first, so the first
+   * call for every value is always issued. Code that changes the same state directly must call invalidate
+   * afterwards, otherwise following calls may be dropped even though the state differs.
+   */
+  class GLState {
+  public:
+    /*!
+     * State changes issued to OpenGL and dropped as redundant.
+     */
+    struct CallStats {
+      size_t issued = 0;
+      size_t elided = 0;
+    };
+
+    /*!
+     * Get the calls counted since the last reset.
+     *
+     * @return - Counters of all state changes, reset them by assigning CallStats{}.
+     */
+    static CallStats &getCallStats();
+
+    /*!
+     * Bind a shader program with glUseProgram.
+     *
+     * @param program - OpenGL program name.
+     */
+    static void useProgram(GLuint program);
+
+    /*!
+     * Bind a vertex array object with glBindVertexArray.
+     *
+     * @param vao - OpenGL vertex array name, 0 unbinds.
+     */
+    static void bindVertexArray(GLuint vao);
+
+    /*!
+     * Select the texture unit affected by texture calls with glActiveTexture.
+     *
+     * @param unit - Texture unit number starting with 0.
+     */
+    static void activeTexture(GLuint unit);
+
+    /*!
+     * Bind a texture to a texture unit, the unit becomes active so the texture can be modified as well.
+     *
+     * @param unit - Texture unit number starting with 0.
+     * @param target - Texture target, e.g. GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+     * @param texture - OpenGL texture name.
+     */
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /*!
+     * Bind a framebuffer for both drawing and reading with glBindFramebuffer.
+     *
+     * @param framebuffer - OpenGL framebuffer name, 0 is the window.
+     */
+    static void bindFramebuffer(GLuint framebuffer);
+
+    /*!
+     * Set the viewport with glViewport.
+     */
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /*!
+     * Get the current viewport without a glGet call, OpenGL is only asked while it is not known.
+     *
+     * @param viewport - Receives x, y, width and height.
+     */
+    static void getViewport(GLint viewport[4]);
+
+    /*!
+     * Enable or disable a capability, e.g. GL_DEPTH_TEST or GL_BLEND, with glEnable and glDisable.
+     *
+     * @param capability - OpenGL capability.
+     * @param enabled - New state of the capability.
+     */
+    static void setEnabled(GLenum capability, bool enabled);
+
+    /*!
+     * Set the depth comparison with glDepthFunc.
+     *
+     * @param function - Comparison function, e.g. GL_LESS.
+     */
+    static void depthFunc(GLenum function);
+
+    /*!
+     * Enable or disable writing to the depth buffer with glDepthMask.
+     *
+     * @param write - True to write depth values.
+     */
+    static void depthMask(bool write);
+
+    /*!
+     * Set the blending factors with glBlendFunc.
+     *
+     * @param source - Factor of the incoming color.
+     * @param destination - Factor of the color in the framebuffer.
+     */
+    static void blendFunc(GLenum source, GLenum destination);
+
+    /*!
+     * Forget a program, vertex array, texture or framebuffer before deleting it, a new object may get its name.
+     *
+     * @param name - OpenGL object name.
+     */
+    static void deleteProgram(GLuint name);
+    static void deleteVertexArray(GLuint name);
+    static void deleteTexture(GLuint name);
+    static void deleteFramebuffer(GLuint name);
+
+    /*!
+     * Forget all cached state, the next call for every value is issued again.
+     */
+    static void invalidate();
+
+  private:
+    template<typename T>
+    struct Cached {
+      T value{};
+      bool known = false;
+    };
+
+    struct State {
+      Cached<GLuint> program, vertexArray, activeUnit, framebuffer;
+      Cached<std::pair<std::pair<GLint, GLint>, std::pair<GLsizei, GLsizei>>> viewport;
+      Cached<GLenum> depthFunc;
+      Cached<bool> depthMask;
+      Cached<std::pair<GLenum, GLenum>> blendFunc;
+      std::map<std::pair<GLuint, GLenum>, Cached<GLuint>> textures;
+      std::map<GLenum, Cached<bool>> capabilities;
+    };
+
+    static State &state();
+
+    /*!
+     * Store a new value and count the call.
+     *
+     * @return - True when the value changed and the OpenGL call has to be made.
+     */
+    template<typename T>
+    static bool change(Cached<T> &cached, const T &value);
+  };
+
+}
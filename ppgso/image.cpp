@@ -13,6 +13,10 @@ std::vector<ppgso::Image::Pixel>& ppgso::Image::getFramebuffer() {
   return framebuffer;
 }
 
+const std::vector<ppgso::Image::Pixel>& ppgso::Image::getFramebuffer() const {
+  return framebuffer;
+}
+
 ppgso::Image::Pixel& ppgso::Image::getPixel(int x, int y) {
   return framebuffer[x+y*width];
 }
@@ -27,6 +27,13 @@ namespace ppgso {
      */
     std::vector<Pixel>& getFramebuffer();
 
+    /*!
+     * Get read-only access to the image data.
+     *
+     * @return - Reference to the raw RGB framebuffer data.
+     */
+    const std::vector<Pixel>& getFramebuffer() const;
+
     /*!
      * Get single pixel from the framebuffer.
      *
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "image_bc.h"
+
+namespace ppgso {
+  namespace image {
+
+    namespace {
+      struct Color {
+        float r, g, b;
+      };
+
+      uint16_t packRGB565(const Color &color) {
+        auto r = (int) std::lround(std::min(std::max(color.r, 0.0f), 255.0f) * 31.0f / 255.0f);
+        auto g = (int) std::lround(std::min(std::max(color.g, 0.0f), 255.0f) * 63.0f / 255.0f);
+        auto b = (int) std::lround(std::min(std::max(color.b, 0.0f), 255.0f) * 31.0f / 255.0f);
+        return (uint16_t) ((r << 11) | (g << 5) | b);
+      }
+
+      ppgso::Image::Pixel unpackRGB565(uint16_t color) {
+        int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        return {(uint8_t) ((r << 3) | (r >> 2)), (uint8_t) ((g << 2) | (g >> 4)), (uint8_t) ((b << 3) | (b >> 2))};
+      }
+
+      // Colors of a 4 color block, the interpolated entries use the 1/3 and 2/3 weights of the specification
+      void buildPalette(uint16_t c0, uint16_t c1, bool fourColors, ppgso::Image::Pixel palette[4]) {
+        palette[0] = unpackRGB565(c0);
+        palette[1] = unpackRGB565(c1);
+        auto &a = palette[0], &b = palette[1];
+        if (fourColors) {
+          palette[2] = {(uint8_t) ((2 * a.r + b.r) / 3), (uint8_t) ((2 * a.g + b.g) / 3), (uint8_t) ((2 * a.b + b.b) / 3)};
+          palette[3] = {(uint8_t) ((a.r + 2 * b.r) / 3), (uint8_t) ((a.g + 2 * b.g) / 3), (uint8_t) ((a.b + 2 * b.b) / 3)};
+        } else {
+          palette[2] = {(uint8_t) ((a.r + b.r) / 2), (uint8_t) ((a.g + b.g) / 2), (uint8_t) ((a.b + b.b) / 2)};
+          palette[3] = {0, 0, 0};
+        }
+      }
+
+      int distance(const ppgso::Image::Pixel &a, const ppgso::Image::Pixel &b) {
+        int dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+        return dr * dr + dg * dg + db * db;
+      }
+
+      // Pick the closest palette entry for every pixel, returns the total squared error
+      int selectIndices(const ppgso::Image::Pixel pixels[16], uint16_t c0, uint16_t c1, uint32_t &indices) {
+        ppgso::Image::Pixel palette[4];
+        buildPalette(c0, c1, true, palette);
+
+        int error = 0;
+        indices = 0;
+        for (int i = 0; i < 16; i++) {
+          int best = 0, bestDistance = distance(pixels[i], palette[0]);
+          for (int p = 1; p < 4; p++) {
+            int d = distance(pixels[i], palette[p]);
+            if (d < bestDistance) {
+              best = p;
+              bestDistance = d;
+            }
+          }
+          indices |= (uint32_t) best << (2 * i);
+          error += bestDistance;
+        }
+        return error;
+      }
+
+      // Least squares end points for fixed indices, minimizes the error of the interpolated palette
+      bool refineEndpoints(const ppgso::Image::Pixel pixels[16], uint32_t indices, Color &start, Color &end) {
+        static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0, bb = 0, ab = 0;
+        Color ax{0, 0, 0}, bx{0, 0, 0};
+        for (int i = 0; i < 16; i++) {
+          float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;
+          aa += a * a;
+          bb += b * b;
+          ab += a * b;
+          ax = {ax.r + a * pixels[i].r, ax.g + a * pixels[i].g, ax.b + a * pixels[i].b};
+          bx = {bx.r + b * pixels[i].r, bx.g + b * pixels[i].g, bx.b + b * pixels[i].b};
+        }
+
+        float det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f) return false;
+        float inv = 1.0f / det;
+        start = {(ax.r * bb - bx.r * ab) * inv, (ax.g * bb - bx.g * ab) * inv, (ax.b * bb - bx.b * ab) * inv};
+        end = {(bx.r * aa - ax.r * ab) * inv, (bx.g * aa - ax.g * ab) * inv, (bx.b * aa - ax.b * ab) * inv};
+        return true;
+      }
+
+      void encodeColorBlock(const ppgso::Image::Pixel pixels[16], uint8_t *block) {
+        // Principal axis of the colors from a few power iterations on their covariance
+        Color mean{0, 0, 0};
+        for (int i = 0; i < 16; i++)
+          mean = {mean.r + pixels[i].r / 16.0f, mean.g + pixels[i].g / 16.0f, mean.b + pixels[i].b / 16.0f};
+
+        float cov[6] = {0, 0, 0, 0, 0, 0};
+        for (int i = 0; i < 16; i++) {
+          float r = pixels[i].r - mean.r, g = pixels[i].g - mean.g, b = pixels[i].b - mean.b;
+          cov[0] += r * r;
+          cov[1] += r * g;
+          cov[2] += r * b;
+          cov[3] += g * g;
+          cov[4] += g * b;
+          cov[5] += b * b;
+        }
+
+        Color axis{1, 1, 1};
+        for (int iteration = 0; iteration < 8; iteration++) {
+          Color next{cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                     cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                     cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b};
+          float length = std::max({std::abs(next.r), std::abs(next.g), std::abs(next.b)});
+          if (length < 1e-6f) break;
+          axis = {next.r / length, next.g / length, next.b / length};
+        }
+
+        // End points are the extreme projections of the colors onto the axis
+        float minT = 0, maxT = 0;
+        float axisLength = axis.r * axis.r + axis.g * axis.g + axis.b * axis.b;
+        for (int i = 0; i < 16; i++) {
+          float t = ((pixels[i].r - mean.r) * axis.r + (pixels[i].g - mean.g) * axis.g +
+                     (pixels[i].b - mean.b) * axis.b) / axisLength;
+          minT = std::min(minT, t);
+          maxT = std::max(maxT, t);
+        }
+        Color start{mean.r + axis.r * maxT, mean.g + axis.g * maxT, mean.b + axis.b * maxT};
+        Color end{mean.r + axis.r * minT, mean.g + axis.g * minT, mean.b + axis.b * minT};
+
+        uint16_t c0 = packRGB565(start), c1 = packRGB565(end);
+        uint32_t indices;
+        int error = selectIndices(pixels, c0, c1, indices);
+
+        // Alternate between fitting end points and selecting indices while the error keeps dropping
+        for (int iteration = 0; iteration < 3 && refineEndpoints(pixels, indices, start, end); iteration++) {
+          uint16_t r0 = packRGB565(start), r1 = packRGB565(end);
+          uint32_t refinedIndices;
+          int refinedError = selectIndices(pixels, r0, r1, refinedIndices);
+          if (refinedError >= error) break;
+          c0 = r0;
+          c1 = r1;
+          indices = refinedIndices;
+          error = refinedError;
+        }
+
+        // Keep c0 > c1 so the block always decodes in the 4 color mode
+        if (c0 < c1) {
+          std::swap(c0, c1);
+          indices ^= 0x55555555u;
+        } else if (c0 == c1) {
+          indices = 0;
+        }
+
+        block[0] = (uint8_t) (c0 & 0xFF);
+        block[1] = (uint8_t) (c0 >> 8);
+        block[2] = (uint8_t) (c1 & 0xFF);
+        block[3] = (uint8_t) (c1 >> 8);
+        for (int i = 0; i < 4; i++)
+          block[4 + i] = (uint8_t) (indices >> (8 * i));
+      }
+
+      void decodeColorBlock(const uint8_t *block, bool allowThreeColors, ppgso::Image::Pixel pixels[16]) {
+        uint16_t c0 = (uint16_t) (block[0] | (block[1] << 8));
+        uint16_t c1 = (uint16_t) (block[2] | (block[3] << 8));
+        uint32_t indices = (uint32_t) block[4] | ((uint32_t) block[5] << 8) | ((uint32_t) block[6] << 16) |
+                           ((uint32_t) block[7] << 24);
+
+        ppgso::Image::Pixel palette[4];
+        buildPalette(c0, c1, !allowThreeColors || c0 > c1, palette);
+        for (int i = 0; i < 16; i++)
+          pixels[i] = palette[(indices >> (2 * i)) & 3];
+      }
+
+      // Gather a 4x4 block, pixels past the edge repeat the last row and column
+      void fetchBlock(const ppgso::Image &image, int bx, int by, ppgso::Image::Pixel pixels[16]) {
+        auto &framebuffer = image.getFramebuffer();
+        for (int y = 0; y < 4; y++) {
+          int sy = std::min(by * 4 + y, image.height - 1);
+          for (int x = 0; x < 4; x++) {
+            int sx = std::min(bx * 4 + x, image.width - 1);
+            pixels[y * 4 + x] = framebuffer[(size_t) sy * image.width + sx];
+          }
+        }
+      }
+
+      void storeBlock(ppgso::Image &image, int bx, int by, const ppgso::Image::Pixel pixels[16]) {
+        auto &framebuffer = image.getFramebuffer();
+        for (int y = 0; y < 4 && by * 4 + y < image.height; y++)
+          for (int x = 0; x < 4 && bx * 4 + x < image.width; x++)
+            framebuffer[(size_t) (by * 4 + y) * image.width + bx * 4 + x] = pixels[y * 4 + x];
+      }
+
+      std::vector<uint8_t> compress(const ppgso::Image &image, size_t blockSize) {
+        std::vector<uint8_t> blocks(getBlockCompressedSize(image.width, image.height, blockSize));
+        int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+
+        ppgso::Image::Pixel pixels[16];
+        auto block = blocks.data();
+        for (int by = 0; by < blocksY; by++) {
+          for (int bx = 0; bx < blocksX; bx++) {
+            fetchBlock(image, bx, by, pixels);
+            if (blockSize == 16) {
+              // Both alpha end points opaque, every index then selects alpha 255
+              std::memset(block, 0, 8);
+              block[0] = block[1] = 255;
+              block += 8;
+            }
+            encodeColorBlock(pixels, block);
+            block += 8;
+          }
+        }
+        return blocks;
+      }
+
+      ppgso::Image decompress(const uint8_t *blocks, int width, int height, size_t blockSize) {
+        ppgso::Image image{width, height};
+        int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+
+        ppgso::Image::Pixel pixels[16];
+        for (int by = 0; by < blocksY; by++) {
+          for (int bx = 0; bx < blocksX; bx++) {
+            // BC3 color blocks always use the 4 color mode
+            if (blockSize == 16) {
+              decodeColorBlock(blocks + 8, false, pixels);
+            } else {
+              decodeColorBlock(blocks, true, pixels);
+            }
+            storeBlock(image, bx, by, pixels);
+            blocks += blockSize;
+          }
+        }
+        return image;
+      }
+    }
+
+    size_t getBlockCompressedSize(int width, int height, size_t blockSize) {
+      return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+    }
+
+    std::vector<uint8_t> compressBC1(const ppgso::Image &image) {
+      return compress(image, 8);
+    }
+
+    std::vector<uint8_t> compressBC3(const ppgso::Image &image) {
+      return compress(image, 16);
+    }
+
+    ppgso::Image decompressBC1(const uint8_t *blocks, int width, int height) {
+      return decompress(blocks, width, height, 8);
+    }
+
+    ppgso::Image decompressBC3(const uint8_t *blocks, int width, int height) {
+      return decompress(blocks, width, height, 16);
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "image.h"
+
+namespace ppgso {
+  namespace image {
+/*!
+ * Size of a block compressed image, blocks of 4x4 pixels cover the image including its partial edge blocks.
+ *
+ * @param width - Width in pixels.
+ * @param height - Height in pixels.
+ * @param blockSize - Bytes per block, 8 for BC1 and 16 for BC3.
+ * @return - Size in bytes.
+ */
+  size_t getBlockCompressedSize(int width, int height, size_t blockSize);
+
+/*!
+ * Compress image into BC1 (DXT1) blocks, 8 bytes per 4x4 pixels.
+ *
+ * Block end points are fitted along the principal axis of the block colors and refined with least squares.
+ *
+ * @param image - Image to compress.
+ * @return - Blocks in rows from the top of the image.
+ */
+  std::vector<uint8_t> compressBC1(const ppgso::Image &image);
+
+/*!
+ * Compress image into BC3 (DXT5) blocks with opaque alpha, 16 bytes per 4x4 pixels.
+ *
+ * @param image - Image to compress.
+ * @return - Blocks in rows from the top of the image.
+ */
+  std::vector<uint8_t> compressBC3(const ppgso::Image &image);
+
+/*!
+ * Decode BC1 blocks back into an image the way the GPU samples them.
+ *
+ * @param blocks - Compressed blocks.
+ * @param width - Width in pixels.
+ * @param height - Height in pixels.
+ * @return - Decoded image.
+ */
+  ppgso::Image decompressBC1(const uint8_t *blocks, int width, int height);
+
+/*!
+ * Decode color of BC3 blocks back into an image, the alpha channel is dropped.
+ *
+ * @param blocks - Compressed blocks.
+ * @param width - Width in pixels.
+ * @param height - Height in pixels.
+ * @return - Decoded image.
+ */
+  ppgso::Image decompressBC3(const uint8_t *blocks, int width, int height);
+  }
+}
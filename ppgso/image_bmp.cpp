@@ -1,7 +1,11 @@
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include "image_bmp.h"
+#include "cpu_features.h"
+
+static_assert(sizeof(ppgso::Image::Pixel) == 3, "Image pixels have to be tightly packed RGB");
 
 namespace ppgso {
   namespace image {
@@ -33,21 +37,19 @@ namespace ppgso {
     } BITMAPINFOHEADER;
 #pragma pack()
 
-    Image loadBMP(const std::string &bmp) {
+    MappedBMP::MappedBMP(const std::string &bmp) : file{bmp} {
       BITMAPFILEHEADER bmpFileHeader = {};
       BITMAPINFOHEADER bmpInfoHeader = {};
 
-      std::ifstream input_file(bmp, std::ios::binary);
-
       // Check headers
-      if (!input_file.is_open()) {
+      if (file.size() < sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER)) {
         std::stringstream msg;
-        msg << "Could not open BMP file. " << bmp;
+        msg << "BMP file does not contain supported BMP format. " << bmp;
         throw std::runtime_error(msg.str());
       }
 
-      input_file.read((char *) &bmpFileHeader, sizeof(BITMAPFILEHEADER));
-      input_file.read((char *) &bmpInfoHeader, sizeof(BITMAPINFOHEADER));
+      std::memcpy(&bmpFileHeader, file.data(), sizeof(BITMAPFILEHEADER));
+      std::memcpy(&bmpInfoHeader, file.data() + sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER));
 
       if (bmpFileHeader.bfType != 19778) {
         std::stringstream msg;
@@ -67,39 +69,106 @@ namespace ppgso {
         throw std::runtime_error(msg.str());
       }
 
-      int width = bmpInfoHeader.biWidth;
-      int height = abs(bmpInfoHeader.biHeight);
-      bool flipped = bmpInfoHeader.biHeight < 0;
+      width = bmpInfoHeader.biWidth;
+      height = abs(bmpInfoHeader.biHeight);
+      topDown = bmpInfoHeader.biHeight < 0;
 
-      if (width == 0 || height == 0) {
+      if (width <= 0 || height == 0) {
         std::stringstream msg;
         msg << "BMP file does not contain any data. " << bmp;
         throw std::runtime_error(msg.str());
       }
 
-      Image image{width, height};
-      auto &framebuffer = image.getFramebuffer();
+      // BMP uses padding for rows
+      stride = ((size_t) width * 3 + 3) & ~(size_t) 3;
+      if (bmpFileHeader.bfOffBits > file.size() || stride * height > file.size() - bmpFileHeader.bfOffBits) {
+        std::stringstream msg;
+        msg << "BMP file is truncated. " << bmp;
+        throw std::runtime_error(msg.str());
+      }
+      pixels = file.data() + bmpFileHeader.bfOffBits;
+    }
 
-      // Load data
-      input_file.seekg(bmpFileHeader.bfOffBits, input_file.beg);
+    const uint8_t *MappedBMP::getRow(int y) const {
+      return pixels + stride * (topDown ? y : height - 1 - y);
+    }
 
-      // BMP uses padding for rows
-      unsigned int row_padded = (width * sizeof(Image::Pixel) + 3) & (~3);
+    size_t MappedBMP::getStride() const {
+      return stride;
+    }
 
-      for (int j = 0; j < height; j++) {
-        auto row_data = std::vector<Image::Pixel>(row_padded);
-        input_file.read((char *) row_data.data(), row_padded);
-        for (int i = 0; i < width; i++) {
-          auto pixel = row_data[i];
-          std::swap(pixel.r, pixel.b);
-          if (flipped) {
-            framebuffer[i + j * width] = pixel;
-          } else {
-            framebuffer[i + (height - 1 - j) * width] = pixel;
-          }
+    bool MappedBMP::isTopDown() const {
+      return topDown;
+    }
+
+    void MappedBMP::prefault() const {
+      file.prefault();
+    }
+
+    namespace {
+      void swizzleScalar(uint8_t *dst, const uint8_t *src, int count) {
+        for (int i = 0; i < count; i++, dst += 3, src += 3) {
+          dst[0] = src[2];
+          dst[1] = src[1];
+          dst[2] = src[0];
+        }
+      }
+
+#ifdef PPGSO_X86
+      // Reverses 5 pixels in 16 bytes, the last byte is rewritten by the next block
+      PPGSO_TARGET("ssse3") void swizzleSSSE3(uint8_t *dst, const uint8_t *src, int count) {
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+        int i = 0;
+        // Each block reads and writes 16 bytes, so one more pixel has to follow it
+        for (; i + 6 <= count; i += 5) {
+          __m128i block = _mm_loadu_si128((const __m128i *) (src + 3 * i));
+          _mm_storeu_si128((__m128i *) (dst + 3 * i), _mm_shuffle_epi8(block, shuffle));
         }
+        swizzleScalar(dst + 3 * i, src + 3 * i, count - i);
+      }
+
+      // Same as SSSE3 with two blocks of 5 pixels, one in each 128 bit lane
+      PPGSO_TARGET("avx2") void swizzleAVX2(uint8_t *dst, const uint8_t *src, int count) {
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15,
+                                                 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+        int i = 0;
+        for (; i + 11 <= count; i += 10) {
+          __m128i low = _mm_loadu_si128((const __m128i *) (src + 3 * i));
+          __m128i high = _mm_loadu_si128((const __m128i *) (src + 3 * i + 15));
+          __m256i block = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+          block = _mm256_shuffle_epi8(block, shuffle);
+          _mm_storeu_si128((__m128i *) (dst + 3 * i), _mm256_castsi256_si128(block));
+          _mm_storeu_si128((__m128i *) (dst + 3 * i + 15), _mm256_extracti128_si256(block, 1));
+        }
+        swizzleScalar(dst + 3 * i, src + 3 * i, count - i);
+      }
+#endif
+
+      typedef void (*SwizzleFunction)(uint8_t *, const uint8_t *, int);
+
+      SwizzleFunction selectSwizzle() {
+#ifdef PPGSO_X86
+        if (cpuSupportsAVX2()) return swizzleAVX2;
+        if (cpuSupportsSSSE3()) return swizzleSSSE3;
+#endif
+        return swizzleScalar;
       }
-      input_file.close();
+    }
+
+    void swizzleBGR(uint8_t *dst, const uint8_t *src, int count) {
+      static const SwizzleFunction swizzle = selectSwizzle();
+      swizzle(dst, src, count);
+    }
+
+    Image loadBMP(const std::string &bmp) {
+      MappedBMP file{bmp};
+
+      Image image{file.width, file.height};
+      auto framebuffer = reinterpret_cast<uint8_t *>(image.getFramebuffer().data());
+
+      // Rows are flipped and converted straight from the mapping into the framebuffer
+      for (int y = 0; y < file.height; y++)
+        swizzleBGR(framebuffer + (size_t) y * file.width * 3, file.getRow(y), file.width);
 
       return image;
     }
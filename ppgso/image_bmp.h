@@ -1,8 +1,61 @@
 #pragma once
+#include <cstdint>
+
 #include "image.h"
+#include "mapped_file.h"
 
 namespace ppgso {
 namespace image {
+/*!
+ * Memory mapped uncompressed 24 bit BMP image.
+ *
+ * Pixel rows stay in the mapped file in BGR order, so they can be handed to OpenGL with GL_BGR without any
+ * conversion on the CPU.
+ */
+  class MappedBMP {
+  public:
+    /*!
+     * Map BMP image and validate its headers. Only uncompressed RGB format is supported.
+     *
+     * @param bmp - File path to a BMP image.
+     */
+    explicit MappedBMP(const std::string &bmp);
+
+    /*!
+     * Get pixels of a row, rows are numbered from the top of the image.
+     *
+     * @param y - Row index.
+     * @return - Pointer to width BGR pixels.
+     */
+    const uint8_t *getRow(int y) const;
+
+    /*!
+     * Get distance between the starts of two rows in the file, rows are padded to 4 bytes.
+     *
+     * @return - Row stride in bytes.
+     */
+    size_t getStride() const;
+
+    /*!
+     * Check whether rows are stored from the top of the image, most BMP files store them bottom-up.
+     *
+     * @return - True when the first row in the file is the top row.
+     */
+    bool isTopDown() const;
+
+    /*!
+     * Read the pixel data once, so later accesses do not wait for the disk.
+     */
+    void prefault() const;
+
+    int width, height;
+  private:
+    MappedFile file;
+    const uint8_t *pixels;
+    size_t stride;
+    bool topDown;
+  };
+
 /*!
  * Load BMP image from file. Only uncompressed RGB format is supported.
  *
@@ -10,6 +63,15 @@ namespace image {
  */
   ppgso::Image loadBMP(const std::string &bmp);
 
+/*!
+ * Convert BGR pixels to RGB, uses SSSE3 or AVX2 when the processor supports it.
+ *
+ * @param dst - Output RGB pixels.
+ * @param src - Input BGR pixels, must not overlap with dst.
+ * @param count - Number of pixels.
+ */
+  void swizzleBGR(uint8_t *dst, const uint8_t *src, int count);
+
 /*!
  * Save as BMP image.
  * @param image - Image to save.
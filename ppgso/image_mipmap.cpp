@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "image_mipmap.h"
+
+namespace ppgso {
+  namespace image {
+
+    namespace {
+      // Lanczos filter with 2 lobes, wide enough to suppress aliasing without visible ringing
+      const double LOBES = 2.0;
+      const double PI = 3.14159265358979323846;
+
+      double sinc(double x) {
+        if (std::abs(x) < 1e-8) return 1.0;
+        return std::sin(PI * x) / (PI * x);
+      }
+
+      double lanczos(double x) {
+        if (std::abs(x) >= LOBES) return 0.0;
+        return sinc(x) * sinc(x / LOBES);
+      }
+
+      float toLinear(uint8_t value) {
+        double c = value / 255.0;
+        return (float) (c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+      }
+
+      uint8_t toSRGB(float value) {
+        double c = std::min(std::max((double) value, 0.0), 1.0);
+        c = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+        return (uint8_t) std::lround(c * 255.0);
+      }
+
+      struct Tap {
+        int index;
+        float weight;
+      };
+
+      // Filter taps of every output sample along one axis, source positions wrap around
+      std::vector<std::vector<Tap>> computeTaps(int srcSize, int dstSize) {
+        std::vector<std::vector<Tap>> taps(dstSize);
+        double scale = (double) srcSize / dstSize;
+        double support = LOBES * scale;
+
+        for (int i = 0; i < dstSize; i++) {
+          double center = (i + 0.5) * scale - 0.5;
+          int first = (int) std::floor(center - support) + 1;
+          int last = (int) std::ceil(center + support) - 1;
+
+          double sum = 0.0;
+          for (int s = first; s <= last; s++) {
+            double weight = lanczos((s - center) / scale);
+            if (weight == 0.0) continue;
+            int index = ((s % srcSize) + srcSize) % srcSize;
+            taps[i].push_back({index, (float) weight});
+            sum += weight;
+          }
+          for (auto &tap : taps[i])
+            tap.weight = (float) (tap.weight / sum);
+        }
+        return taps;
+      }
+
+      ppgso::Image resample(const std::vector<float> &linear, int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+        auto columns = computeTaps(srcWidth, dstWidth);
+        auto rows = computeTaps(srcHeight, dstHeight);
+
+        // Horizontal pass into a float buffer, then the vertical pass straight into the image
+        std::vector<float> horizontal((size_t) dstWidth * srcHeight * 3);
+        for (int y = 0; y < srcHeight; y++) {
+          auto src = &linear[(size_t) y * srcWidth * 3];
+          auto dst = &horizontal[(size_t) y * dstWidth * 3];
+          for (int x = 0; x < dstWidth; x++) {
+            float r = 0, g = 0, b = 0;
+            for (auto &tap : columns[x]) {
+              r += tap.weight * src[tap.index * 3];
+              g += tap.weight * src[tap.index * 3 + 1];
+              b += tap.weight * src[tap.index * 3 + 2];
+            }
+            dst[x * 3] = r;
+            dst[x * 3 + 1] = g;
+            dst[x * 3 + 2] = b;
+          }
+        }
+
+        ppgso::Image result{dstWidth, dstHeight};
+        auto &framebuffer = result.getFramebuffer();
+        for (int y = 0; y < dstHeight; y++) {
+          for (int x = 0; x < dstWidth; x++) {
+            float r = 0, g = 0, b = 0;
+            for (auto &tap : rows[y]) {
+              auto src = &horizontal[((size_t) tap.index * dstWidth + x) * 3];
+              r += tap.weight * src[0];
+              g += tap.weight * src[1];
+              b += tap.weight * src[2];
+            }
+            framebuffer[(size_t) y * dstWidth + x] = {toSRGB(r), toSRGB(g), toSRGB(b)};
+          }
+        }
+        return result;
+      }
+    }
+
+    std::vector<ppgso::Image> generateMipmaps(const ppgso::Image &image) {
+      std::vector<ppgso::Image> levels;
+      levels.push_back(image);
+      if (image.width <= 0 || image.height <= 0)
+        return levels;
+
+      float lut[256];
+      for (int i = 0; i < 256; i++)
+        lut[i] = toLinear((uint8_t) i);
+
+      std::vector<float> linear;
+      linear.reserve(image.getFramebuffer().size() * 3);
+      for (auto &pixel : image.getFramebuffer()) {
+        linear.push_back(lut[pixel.r]);
+        linear.push_back(lut[pixel.g]);
+        linear.push_back(lut[pixel.b]);
+      }
+
+      // Every level is filtered from the base, so errors of the small levels do not accumulate
+      int width = image.width, height = image.height;
+      while (width > 1 || height > 1) {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        levels.push_back(resample(linear, image.width, image.height, width, height));
+      }
+      return levels;
+    }
+
+    double psnr(const ppgso::Image &a, const ppgso::Image &b) {
+      if (a.width != b.width || a.height != b.height)
+        throw std::invalid_argument("PSNR of images with different sizes");
+
+      double error = 0.0;
+      auto &pa = a.getFramebuffer();
+      auto &pb = b.getFramebuffer();
+      for (size_t i = 0; i < pa.size(); i++) {
+        double dr = pa[i].r - pb[i].r, dg = pa[i].g - pb[i].g, db = pa[i].b - pb[i].b;
+        error += dr * dr + dg * dg + db * db;
+      }
+      if (error == 0.0 || pa.empty())
+        return std::numeric_limits<double>::infinity();
+
+      double mse = error / (pa.size() * 3.0);
+      return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+
+#include "image.h"
+
+namespace ppgso {
+  namespace image {
+/*!
+ * Build the full mipmap chain of an image down to 1x1.
+ *
+ * Each level has half the size of the previous one rounded down, as OpenGL expects. Levels are resampled from the
+ * base image with a Lanczos filter in linear light and wrap around the edges like GL_REPEAT textures do, which keeps
+ * small levels sharper and free of the darkening of a box filter applied to sRGB values.
+ *
+ * @param image - Base level.
+ * @return - All levels starting with a copy of the base level.
+ */
+  std::vector<ppgso::Image> generateMipmaps(const ppgso::Image &image);
+
+/*!
+ * Compute peak signal to noise ratio between two images of the same size.
+ *
+ * @param a - First image.
+ * @param b - Second image.
+ * @return - PSNR in dB over all color channels, infinity for identical images.
+ */
+  double psnr(const ppgso::Image &a, const ppgso::Image &b);
+  }
+}
@@ -0,0 +1,100 @@
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+ppgso::MappedFile::MappedFile(const std::string &path) {
+  std::stringstream msg;
+#ifdef _WIN32
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    msg << "Could not open file " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  length = (size_t) fileSize.QuadPart;
+  if (length == 0) return;
+
+  fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (fileMapping)
+    mapping = (const unsigned char *) MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+
+  if (!mapping) {
+    if (fileMapping) CloseHandle(fileMapping);
+    CloseHandle(file);
+    msg << "Could not map file " << path;
+    throw std::runtime_error(msg.str());
+  }
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    msg << "Could not open file " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  struct stat info = {};
+  fstat(fd, &info);
+  length = (size_t) info.st_size;
+  if (length == 0) {
+    close(fd);
+    return;
+  }
+
+  void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  close(fd);
+
+  if (address == MAP_FAILED) {
+    msg << "Could not map file " << path;
+    throw std::runtime_error(msg.str());
+  }
+  mapping = (const unsigned char *) address;
+#endif
+}
+
+ppgso::MappedFile::~MappedFile() {
+#ifdef _WIN32
+  if (mapping) UnmapViewOfFile(mapping);
+  if (fileMapping) CloseHandle(fileMapping);
+  if (file) CloseHandle(file);
+#else
+  if (mapping) munmap((void *) mapping, length);
+#endif
+}
+
+const unsigned char *ppgso::MappedFile::data() const {
+  return mapping;
+}
+
+size_t ppgso::MappedFile::size() const {
+  return length;
+}
+
+void ppgso::MappedFile::prefault() const {
+  volatile unsigned char sink = 0;
+  for (size_t offset = 0; offset < length; offset += 4096)
+    sink ^= mapping[offset];
+  (void) sink;
+}
+
+std::time_t ppgso::MappedFile::getModificationTime(const std::string &path) {
+  struct stat info = {};
+  if (stat(path.c_str(), &info) != 0)
+    return 0;
+  return info.st_mtime;
+}
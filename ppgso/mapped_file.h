@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <ctime>
+#include <string>
+
+namespace ppgso {
+
+  /*!
+   * Read-only memory mapping of a whole file.
+   *
+   * The file contents are paged in by the operating system on first access, so data can be handed to OpenGL directly
+   * from the mapping without reading it into an intermediate buffer first.
+   */
+  class MappedFile {
+  public:
+    /*!
+     * Map the file into memory.
+     *
+     * @param path - File path to map.
+     */
+    explicit MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /*!
+     * Get pointer to the first byte of the mapped file.
+     *
+     * @return - Pointer to the file contents, nullptr for empty files.
+     */
+    const unsigned char *data() const;
+
+    /*!
+     * Get size of the mapped file.
+     *
+     * @return - Size in bytes.
+     */
+    size_t size() const;
+
+    /*!
+     * Read one byte of every page, so later accesses do not wait for the disk.
+     */
+    void prefault() const;
+
+    /*!
+     * Get the last modification time of a file.
+     *
+     * @param path - File path to check.
+     * @return - Modification time or 0 when the file does not exist.
+     */
+    static std::time_t getModificationTime(const std::string &path);
+
+  private:
+    const unsigned char *mapping = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *fileMapping = nullptr;
+#endif
+  };
+
+}
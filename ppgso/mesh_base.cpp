@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+#include "gl_state.h"
+#include "mesh_base.h"
+#include "mesh_file.h"
+
+ppgso::ShapeView ppgso::ShapeData::view() const {
+  ShapeView shape;
+  shape.positions = positions.data();
+  shape.positionsSize = positions.size();
+  shape.texcoords = texcoords.data();
+  shape.texcoordsSize = texcoords.size();
+  shape.normals = normals.data();
+  shape.normalsSize = normals.size();
+  shape.indices = indices.data();
+  shape.indicesSize = indices.size();
+  shape.lodIndexCounts = lodIndexCounts.data();
+  shape.lodCount = lodIndexCounts.size();
+  return shape;
+}
+
+ppgso::MeshBase::~MeshBase() {
+  for(auto& buffer : buffers) {
+    glDeleteBuffers(1, &buffer.ibo);
+    glDeleteBuffers(1, &buffer.nbo);
+    glDeleteBuffers(1, &buffer.tbo);
+    glDeleteBuffers(1, &buffer.vbo);
+    GLState::deleteVertexArray(buffer.vao);
+    glDeleteVertexArrays(1, &buffer.vao);
+  }
+}
+
+ppgso::MeshBase::MeshBase(VertexFormat format) : format{format} {}
+
+void ppgso::MeshBase::upload(const ShapeView &shape) {
+  gl_buffer buffer;
+
+  // Generate a vertex array object
+  glGenVertexArrays(1, &buffer.vao);
+  GLState::bindVertexArray(buffer.vao);
+
+  if (format == VertexFormat::Packed)
+    uploadPacked(shape, buffer);
+  else
+    uploadFloat(shape, buffer);
+
+  if (shape.lodCount) {
+    GLsizei first = 0;
+    for (size_t i = 0; i < shape.lodCount; i++) {
+      buffer.lods.emplace_back(first, (GLsizei) shape.lodIndexCounts[i]);
+      first += (GLsizei) shape.lodIndexCounts[i];
+    }
+  } else {
+    buffer.lods.emplace_back(0, (GLsizei) shape.indicesSize);
+  }
+
+  // Bounds of all shapes together
+  for (size_t i = 0; i + 2 < shape.positionsSize; i += 3) {
+    glm::vec3 position{shape.positions[i], shape.positions[i + 1], shape.positions[i + 2]};
+    boundsMin = glm::min(boundsMin, position);
+    boundsMax = glm::max(boundsMax, position);
+  }
+
+  byteSize += getByteSize(shape, format);
+
+  // Copy it to the end of the buffers vector
+  buffers.push_back(buffer);
+}
+
+void ppgso::MeshBase::uploadFloat(const ShapeView &shape, gl_buffer &buffer) {
+  if(shape.positionsSize) {
+    // Generate and upload a buffer with vertex positions to GPU
+    glGenBuffers(1, &buffer.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+    glBufferData(GL_ARRAY_BUFFER, shape.positionsSize * sizeof(float), shape.positions, GL_STATIC_DRAW);
+
+    // Bind the buffer to "Position" attribute in program
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  }
+
+  if(shape.texcoordsSize) {
+    // Generate and upload a buffer with texture coordinates to GPU
+    glGenBuffers(1, &buffer.tbo);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
+    glBufferData(GL_ARRAY_BUFFER, shape.texcoordsSize * sizeof(float), shape.texcoords, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  }
+
+  if(shape.normalsSize) {
+    // Generate and upload a buffer with normals to GPU
+    glGenBuffers(1, &buffer.nbo);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
+    glBufferData(GL_ARRAY_BUFFER, shape.normalsSize * sizeof(float), shape.normals, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  }
+
+  // Generate and upload a buffer with indices to GPU
+  glGenBuffers(1, &buffer.ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, shape.indicesSize * sizeof(unsigned int), shape.indices, GL_STATIC_DRAW);
+}
+
+namespace {
+  struct PackedVertex {
+    // The fourth component is padding, it keeps the following attributes 4 byte aligned
+    uint16_t position[4];
+    uint16_t texcoord[2];
+    uint16_t normal[2];
+  };
+  static_assert(sizeof(PackedVertex) == 16, "Packed vertices have to be tightly packed");
+
+  // Unsigned normalization is used everywhere, its conversion to float is the same in all OpenGL versions
+  uint16_t toUnorm16(float value) {
+    return (uint16_t) std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f);
+  }
+
+  // Project the normal onto an octahedron and unfold its lower half, maps the unit sphere onto [0, 1]^2
+  glm::vec2 encodeOctahedral(glm::vec3 normal) {
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.0f) return {0.5f, 0.5f};
+    normal /= length;
+
+    glm::vec2 encoded{normal.x, normal.y};
+    if (normal.z < 0.0f) {
+      encoded = {(1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f),
+                 (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f)};
+    }
+    return encoded * 0.5f + 0.5f;
+  }
+
+  size_t getVertexCount(const ppgso::ShapeView &shape) {
+    return shape.positionsSize / 3;
+  }
+
+  bool usesShortIndices(const ppgso::ShapeView &shape) {
+    return getVertexCount(shape) <= 65536;
+  }
+}
+
+void ppgso::MeshBase::uploadPacked(const ShapeView &shape, gl_buffer &buffer) {
+  auto vertexCount = getVertexCount(shape);
+  bool hasTexcoords = shape.texcoordsSize == vertexCount * 2 && vertexCount;
+  bool hasNormals = shape.normalsSize == vertexCount * 3 && vertexCount;
+
+  // Bounding boxes of positions and texture coordinates become the dequantization scale and offset
+  glm::vec3 minPosition{0.0f}, maxPosition{0.0f};
+  glm::vec2 minTexcoord{0.0f}, maxTexcoord{0.0f};
+  for (size_t i = 0; i < vertexCount; i++) {
+    glm::vec3 position{shape.positions[i * 3], shape.positions[i * 3 + 1], shape.positions[i * 3 + 2]};
+    minPosition = i ? glm::min(minPosition, position) : position;
+    maxPosition = i ? glm::max(maxPosition, position) : position;
+    if (hasTexcoords) {
+      glm::vec2 texcoord{shape.texcoords[i * 2], shape.texcoords[i * 2 + 1]};
+      minTexcoord = i ? glm::min(minTexcoord, texcoord) : texcoord;
+      maxTexcoord = i ? glm::max(maxTexcoord, texcoord) : texcoord;
+    }
+  }
+  buffer.positionScale = maxPosition - minPosition;
+  buffer.positionOffset = minPosition;
+  buffer.texCoordScaleOffset = {maxTexcoord - minTexcoord, minTexcoord};
+  buffer.packed = true;
+
+  auto normalize = [](float value, float offset, float scale) {
+    return scale > 0.0f ? (value - offset) / scale : 0.0f;
+  };
+
+  std::vector<PackedVertex> vertices(vertexCount);
+  for (size_t i = 0; i < vertexCount; i++) {
+    auto &vertex = vertices[i];
+    for (int c = 0; c < 3; c++)
+      vertex.position[c] = toUnorm16(normalize(shape.positions[i * 3 + c], minPosition[c], buffer.positionScale[c]));
+    vertex.position[3] = 0;
+
+    vertex.texcoord[0] = vertex.texcoord[1] = 0;
+    if (hasTexcoords) {
+      for (int c = 0; c < 2; c++)
+        vertex.texcoord[c] = toUnorm16(normalize(shape.texcoords[i * 2 + c], minTexcoord[c],
+                                                 buffer.texCoordScaleOffset[c]));
+    }
+
+    vertex.normal[0] = vertex.normal[1] = 0;
+    if (hasNormals) {
+      auto encoded = encodeOctahedral({shape.normals[i * 3], shape.normals[i * 3 + 1], shape.normals[i * 3 + 2]});
+      vertex.normal[0] = toUnorm16(encoded.x);
+      vertex.normal[1] = toUnorm16(encoded.y);
+    }
+  }
+
+  // Generate and upload one interleaved buffer with all attributes to GPU
+  glGenBuffers(1, &buffer.vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(PackedVertex), vertices.data(), GL_STATIC_DRAW);
+
+  auto stride = (GLsizei) sizeof(PackedVertex);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *) offsetof(PackedVertex, position));
+  if (hasTexcoords) {
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *) offsetof(PackedVertex, texcoord));
+  }
+  if (hasNormals) {
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *) offsetof(PackedVertex, normal));
+  }
+
+  glGenBuffers(1, &buffer.ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
+  if (usesShortIndices(shape)) {
+    std::vector<uint16_t> indices(shape.indices, shape.indices + shape.indicesSize);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    buffer.indexType = GL_UNSIGNED_SHORT;
+  } else {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, shape.indicesSize * sizeof(unsigned int), shape.indices, GL_STATIC_DRAW);
+  }
+}
+
+bool ppgso::MeshBase::loadBinary(const std::string &obj) {
+  if (!MeshFile::isUpToDate(obj))
+    return false;
+
+  auto path = MeshFile::getBinaryPath(obj);
+  try {
+    // Buffers are filled straight from the mapped file, no parsing or intermediate copies
+    MeshFile file{path};
+    for (auto &shape : file.getShapes())
+      upload(shape);
+  } catch (std::exception &e) {
+    std::cerr << "Ignoring " << path << ": " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void ppgso::MeshBase::render(size_t lod) {
+  draw(lod, 0, 0);
+}
+
+void ppgso::MeshBase::renderInstanced(size_t lod, GLuint instanceBuffer, size_t count) {
+  if (count > 0)
+    draw(lod, instanceBuffer, count);
+}
+
+void ppgso::MeshBase::draw(size_t lod, GLuint instanceBuffer, size_t count) {
+  auto &stats = getDrawStats();
+  bool packed = false;
+  for(auto& buffer : buffers) {
+    auto &range = buffer.lods[std::min(lod, buffer.lods.size() - 1)];
+    auto indexSize = buffer.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+
+    // Dequantization of the shape goes to constant attributes, so it needs no uniforms of the bound program
+    if (buffer.packed) {
+      glVertexAttrib3fv(3, &buffer.positionScale[0]);
+      glVertexAttrib3fv(4, &buffer.positionOffset[0]);
+      glVertexAttrib4fv(5, &buffer.texCoordScaleOffset[0]);
+    }
+    if (buffer.packed != packed) {
+      packed = buffer.packed;
+      glVertexAttrib1f(6, packed ? 1.0f : 0.0f);
+    }
+
+    // Draw object
+    GLState::bindVertexArray(buffer.vao);
+    auto indices = (void *) (range.first * indexSize);
+    if (count == 0) {
+      glDrawElements(GL_TRIANGLES, range.second, buffer.indexType, indices);
+    } else {
+      // One mat4 takes four vec4 attributes, each advancing once per instance
+      glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+      for (GLuint column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(7 + column);
+        glVertexAttribPointer(7 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void *) (column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(7 + column, 1);
+      }
+      glDrawElementsInstanced(GL_TRIANGLES, range.second, buffer.indexType, indices, (GLsizei) count);
+      stats.instances += count;
+    }
+    stats.drawCalls++;
+  }
+  if (packed)
+    glVertexAttrib1f(6, 0.0f);
+}
+
+size_t ppgso::MeshBase::getLodCount() const {
+  size_t count = 1;
+  for (auto &buffer : buffers)
+    count = std::max(count, buffer.lods.size());
+  return count;
+}
+
+size_t ppgso::MeshBase::getTriangleCount(size_t lod) const {
+  size_t count = 0;
+  for (auto &buffer : buffers)
+    count += buffer.lods[std::min(lod, buffer.lods.size() - 1)].second / 3;
+  return count;
+}
+
+glm::vec3 ppgso::MeshBase::getBoundsMin() const {
+  return boundsMin;
+}
+
+glm::vec3 ppgso::MeshBase::getBoundsMax() const {
+  return boundsMax;
+}
+
+glm::vec3 ppgso::MeshBase::getBoundingCenter() const {
+  if (boundsMin.x > boundsMax.x) return glm::vec3{0.0f};
+  return (boundsMin + boundsMax) * 0.5f;
+}
+
+float ppgso::MeshBase::getBoundingRadius() const {
+  if (boundsMin.x > boundsMax.x) return 0.0f;
+  return glm::length(boundsMax - boundsMin) * 0.5f;
+}
+
+size_t ppgso::MeshBase::getByteSize() const {
+  return byteSize;
+}
+
+size_t ppgso::MeshBase::getByteSize(const ShapeView &shape, VertexFormat format) {
+  if (format == VertexFormat::Packed) {
+    auto indexSize = usesShortIndices(shape) ? sizeof(uint16_t) : sizeof(unsigned int);
+    return getVertexCount(shape) * sizeof(PackedVertex) + shape.indicesSize * indexSize;
+  }
+  return (shape.positionsSize + shape.texcoordsSize + shape.normalsSize) * sizeof(float)
+         + shape.indicesSize * sizeof(unsigned int);
+}
+
+ppgso::VertexFormat ppgso::MeshBase::getVertexFormat() const {
+  return format;
+}
+
+ppgso::MeshBase::DrawStats &ppgso::MeshBase::getDrawStats() {
+  static DrawStats stats;
+  return stats;
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace ppgso {
+
+  /*!
+   * Read-only view of a single shape exactly as it is uploaded to the GPU.
+   *
+   * Attributes are tightly packed floats, 3 per position and normal and 2 per texture coordinate.
+   * Sizes are numbers of elements in each array, not bytes.
+   * Levels of detail are stored one after another in the indices, lodIndexCounts holds the number of indices of each
+   * level starting with the full detail one. Without it all indices form a single level.
+   */
+  struct ShapeView {
+    const float *positions = nullptr;
+    size_t positionsSize = 0;
+    const float *texcoords = nullptr;
+    size_t texcoordsSize = 0;
+    const float *normals = nullptr;
+    size_t normalsSize = 0;
+    const unsigned int *indices = nullptr;
+    size_t indicesSize = 0;
+    const unsigned int *lodIndexCounts = nullptr;
+    size_t lodCount = 0;
+  };
+
+  /*!
+   * Shape geometry loaded into CPU memory.
+   */
+  struct ShapeData {
+    std::vector<float> positions;
+    std::vector<float> texcoords;
+    std::vector<float> normals;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> lodIndexCounts;
+
+    /*!
+     * Get a view of the shape data.
+     *
+     * @return - View pointing into the vectors of this shape.
+     */
+    ShapeView view() const;
+  };
+
+  /*!
+   * Layout of the vertex and index buffers of a mesh on the GPU.
+   */
+  enum class VertexFormat {
+    // Separate buffers of 32 bit floats for every attribute and 32 bit indices
+    Float,
+    // One interleaved buffer of 16 byte vertices with 16 bit normalized positions and texture coordinates and
+    // octahedral normals, 16 bit indices for shapes of up to 65536 vertices
+    Packed
+  };
+
+  /*!
+   * OpenGL buffers and rendering shared by the mesh loader back-ends.
+   *
+   * Every shape is uploaded into its own vertex array object bound as follows:
+   * vec3 Position - Vertex position, position 0
+   * vec2 TexCoord - Texture coordinate, position 1
+   * vec3 Normal - Normal vector, position 2
+   *
+   * Packed shapes store positions and texture coordinates normalized to their bounding box and normals as two
+   * octahedral coordinates in the xy components. While drawing a packed shape, render sets the constant attributes
+   * float PackedVertices (6) to 1 and vec3 PositionScale (3), vec3 PositionOffset (4) and vec4 TexCoordScaleOffset (5)
+   * to decode it: Position * PositionScale + PositionOffset, TexCoord * TexCoordScaleOffset.xy + TexCoordScaleOffset.zw.
+   * PackedVertices is reset to 0 afterwards, so vertex arrays not created by MeshBase keep working with such shaders.
+   *
+   * Levels of detail of a shape share its vertex buffer and are ranges of its index buffer.
+   *
+   * Instanced draws read one model matrix per instance as mat4 InstanceMatrix, positions 7 to 10. The attributes stay
+   * bound to the last instance buffer afterwards, programs that do not declare them are not affected.
+   */
+  class MeshBase {
+  public:
+    /*!
+     * Draw calls issued by all meshes.
+     */
+    struct DrawStats {
+      // glDrawElements and glDrawElementsInstanced calls
+      size_t drawCalls = 0;
+      // Instances drawn by the instanced calls
+      size_t instances = 0;
+    };
+
+    /*!
+     * Create an empty mesh.
+     *
+     * @param format - Layout of the buffers created by upload.
+     */
+    explicit MeshBase(VertexFormat format = VertexFormat::Float);
+    MeshBase(const MeshBase &) = delete;
+    MeshBase &operator=(const MeshBase &) = delete;
+
+    ~MeshBase();
+
+    /*!
+     * Render the geometry associated with the mesh using glDrawElements.
+     *
+     * @param lod - Level of detail to draw, 0 is the full detail mesh. Shapes with fewer levels draw their coarsest one.
+     */
+    void render(size_t lod = 0);
+
+    /*!
+     * Render several instances of the geometry using glDrawElementsInstanced.
+     *
+     * @param lod - Level of detail to draw, 0 is the full detail mesh.
+     * @param instanceBuffer - Array buffer with one tightly packed mat4 model matrix per instance.
+     * @param count - Number of instances to draw.
+     */
+    void renderInstanced(size_t lod, GLuint instanceBuffer, size_t count);
+
+    /*!
+     * Get the number of levels of detail.
+     *
+     * @return - Highest number of levels among the shapes, 1 for meshes without simplified levels.
+     */
+    size_t getLodCount() const;
+
+    /*!
+     * Get the number of triangles render draws for a level of detail.
+     *
+     * @param lod - Level of detail.
+     * @return - Triangle count over all shapes.
+     */
+    size_t getTriangleCount(size_t lod = 0) const;
+
+    /*!
+     * Get the corner of the axis aligned bounding box of all uploaded shapes with the smallest coordinates.
+     *
+     * @return - Corner in model space, greater than getBoundsMax for an empty mesh.
+     */
+    glm::vec3 getBoundsMin() const;
+
+    /*!
+     * Get the corner of the axis aligned bounding box of all uploaded shapes with the largest coordinates.
+     *
+     * @return - Corner in model space, less than getBoundsMin for an empty mesh.
+     */
+    glm::vec3 getBoundsMax() const;
+
+    /*!
+     * Get the center of the bounding box of all uploaded shapes.
+     *
+     * @return - Center in model space, the origin for an empty mesh.
+     */
+    glm::vec3 getBoundingCenter() const;
+
+    /*!
+     * Get the radius of a sphere around the bounding box center enclosing all uploaded shapes.
+     *
+     * @return - Radius in model space, 0 for an empty mesh.
+     */
+    float getBoundingRadius() const;
+
+    /*!
+     * Get the size of all vertex and index buffers uploaded to the GPU.
+     *
+     * @return - Size in bytes.
+     */
+    size_t getByteSize() const;
+
+    /*!
+     * Get the size of the buffers a shape needs on the GPU.
+     *
+     * @param shape - Shape geometry.
+     * @param format - Layout of the buffers.
+     * @return - Size in bytes.
+     */
+    static size_t getByteSize(const ShapeView &shape, VertexFormat format);
+
+    /*!
+     * Get the layout of the buffers of this mesh.
+     *
+     * @return - Vertex format chosen at construction.
+     */
+    VertexFormat getVertexFormat() const;
+
+    /*!
+     * Upload a shape to the GPU as a new vertex array object.
+     *
+     * @param shape - Shape geometry to upload.
+     */
+    void upload(const ShapeView &shape);
+
+    /*!
+     * Get the draw calls counted since the last reset.
+     *
+     * @return - Counters shared by all meshes, reset them by assigning DrawStats{}.
+     */
+    static DrawStats &getDrawStats();
+
+  protected:
+    /*!
+     * Upload all shapes from the binary .ppmesh file stored next to the obj file.
+     * The binary file is used only when it is newer than the obj file.
+     *
+     * @param obj - File path to the obj file.
+     * @return - True when the shapes were loaded from the binary file.
+     */
+    bool loadBinary(const std::string &obj);
+
+  private:
+    struct gl_buffer {
+    public:
+      GLuint vao = 0, vbo = 0, tbo = 0, nbo = 0, ibo = 0;
+      // First index and index count of every level of detail
+      std::vector<std::pair<GLsizei, GLsizei>> lods;
+      GLenum indexType = GL_UNSIGNED_INT;
+      // Dequantization of packed shapes
+      bool packed = false;
+      glm::vec3 positionScale{1.0f}, positionOffset{0.0f};
+      glm::vec4 texCoordScaleOffset{1.0f, 1.0f, 0.0f, 0.0f};
+    };
+
+    void uploadFloat(const ShapeView &shape, gl_buffer &buffer);
+    void uploadPacked(const ShapeView &shape, gl_buffer &buffer);
+    void draw(size_t lod, GLuint instanceBuffer, size_t count);
+
+    std::vector<gl_buffer> buffers;
+    size_t byteSize = 0;
+    VertexFormat format;
+    // Empty until the first shape is uploaded
+    glm::vec3 boundsMin{std::numeric_limits<float>::max()}, boundsMax{-std::numeric_limits<float>::max()};
+  };
+}
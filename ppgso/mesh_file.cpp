@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "mesh_file.h"
+
+namespace {
+  const char MAGIC[4] = {'P', 'P', 'M', 'S'};
+
+  enum Attribute { POSITIONS, TEXCOORDS, NORMALS, INDICES, LODS, ATTRIBUTE_COUNT };
+
+  struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t shapeCount;
+    uint32_t reserved;
+  };
+
+  struct ShapeHeader {
+    uint32_t offsets[ATTRIBUTE_COUNT];
+    uint32_t sizes[ATTRIBUTE_COUNT];
+  };
+
+  // Floats and indices share the element size so one offset computation covers all arrays
+  static_assert(sizeof(float) == 4 && sizeof(unsigned int) == 4, "ppmesh requires 4 byte elements");
+}
+
+ppgso::MeshFile::MeshFile(const std::string &path) : file{path} {
+  auto fail = [&path](const char *reason) {
+    std::stringstream msg;
+    msg << "Invalid mesh file " << path << ": " << reason;
+    throw std::runtime_error(msg.str());
+  };
+
+  auto data = file.data();
+  auto size = file.size();
+  if (size < sizeof(FileHeader))
+    fail("truncated header");
+
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    fail("bad magic");
+  if (header.version != VERSION)
+    fail("unsupported version");
+  if (header.shapeCount > (size - sizeof(FileHeader)) / sizeof(ShapeHeader))
+    fail("truncated shape table");
+
+  shapes.reserve(header.shapeCount);
+  for (uint32_t i = 0; i < header.shapeCount; i++) {
+    ShapeHeader entry;
+    std::memcpy(&entry, data + sizeof(FileHeader) + i * sizeof(ShapeHeader), sizeof(entry));
+
+    for (int a = 0; a < ATTRIBUTE_COUNT; a++) {
+      if (entry.offsets[a] % 4 != 0)
+        fail("misaligned data");
+      if (entry.offsets[a] > size || entry.sizes[a] > (size - entry.offsets[a]) / 4)
+        fail("data out of bounds");
+    }
+
+    ShapeView shape;
+    shape.positions = reinterpret_cast<const float *>(data + entry.offsets[POSITIONS]);
+    shape.positionsSize = entry.sizes[POSITIONS];
+    shape.texcoords = reinterpret_cast<const float *>(data + entry.offsets[TEXCOORDS]);
+    shape.texcoordsSize = entry.sizes[TEXCOORDS];
+    shape.normals = reinterpret_cast<const float *>(data + entry.offsets[NORMALS]);
+    shape.normalsSize = entry.sizes[NORMALS];
+    shape.indices = reinterpret_cast<const unsigned int *>(data + entry.offsets[INDICES]);
+    shape.indicesSize = entry.sizes[INDICES];
+    shape.lodIndexCounts = reinterpret_cast<const unsigned int *>(data + entry.offsets[LODS]);
+    shape.lodCount = entry.sizes[LODS];
+
+    if (shape.positionsSize % 3 || shape.texcoordsSize % 2 || shape.normalsSize % 3 || shape.indicesSize % 3)
+      fail("incomplete vertices or triangles");
+
+    // An index past the vertex arrays would make the GPU read outside of the buffers
+    auto vertexCount = shape.positionsSize / 3;
+    for (size_t j = 0; j < shape.indicesSize; j++)
+      if (shape.indices[j] >= vertexCount)
+        fail("index out of range");
+
+    // Levels have to cover the index buffer exactly with whole triangles
+    size_t lodIndices = 0;
+    for (size_t j = 0; j < shape.lodCount; j++) {
+      if (shape.lodIndexCounts[j] == 0 || shape.lodIndexCounts[j] % 3)
+        fail("invalid level of detail");
+      lodIndices += shape.lodIndexCounts[j];
+    }
+    if (shape.lodCount && lodIndices != shape.indicesSize)
+      fail("levels of detail do not match indices");
+
+    shapes.push_back(shape);
+  }
+}
+
+const std::vector<ppgso::ShapeView> &ppgso::MeshFile::getShapes() const {
+  return shapes;
+}
+
+void ppgso::MeshFile::save(const std::string &path, const std::vector<ShapeView> &shapes) {
+  FileHeader header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.shapeCount = (uint32_t) shapes.size();
+  header.reserved = 0;
+
+  // Lay out the arrays one after another behind the shape table
+  std::vector<ShapeHeader> table(shapes.size());
+  size_t offset = sizeof(FileHeader) + shapes.size() * sizeof(ShapeHeader);
+  for (size_t i = 0; i < shapes.size(); i++) {
+    const size_t sizes[ATTRIBUTE_COUNT] = {shapes[i].positionsSize, shapes[i].texcoordsSize,
+                                           shapes[i].normalsSize, shapes[i].indicesSize, shapes[i].lodCount};
+    for (int a = 0; a < ATTRIBUTE_COUNT; a++) {
+      table[i].offsets[a] = (uint32_t) offset;
+      table[i].sizes[a] = (uint32_t) sizes[a];
+      offset += sizes[a] * 4;
+    }
+  }
+  if (offset > UINT32_MAX) {
+    std::stringstream msg;
+    msg << "Mesh too large for " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  if (!out) {
+    std::stringstream msg;
+    msg << "Could not write file " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(ShapeHeader));
+  for (auto &shape : shapes) {
+    out.write(reinterpret_cast<const char *>(shape.positions), shape.positionsSize * sizeof(float));
+    out.write(reinterpret_cast<const char *>(shape.texcoords), shape.texcoordsSize * sizeof(float));
+    out.write(reinterpret_cast<const char *>(shape.normals), shape.normalsSize * sizeof(float));
+    out.write(reinterpret_cast<const char *>(shape.indices), shape.indicesSize * sizeof(unsigned int));
+    out.write(reinterpret_cast<const char *>(shape.lodIndexCounts), shape.lodCount * sizeof(unsigned int));
+  }
+
+  if (!out) {
+    std::stringstream msg;
+    msg << "Could not write file " << path;
+    throw std::runtime_error(msg.str());
+  }
+}
+
+std::string ppgso::MeshFile::getBinaryPath(const std::string &obj) {
+  auto dot = obj.find_last_of('.');
+  auto slash = obj.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return obj + ".ppmesh";
+  return obj.substr(0, dot) + ".ppmesh";
+}
+
+bool ppgso::MeshFile::isUpToDate(const std::string &obj) {
+  auto binaryTime = MappedFile::getModificationTime(getBinaryPath(obj));
+  return binaryTime != 0 && binaryTime >= MappedFile::getModificationTime(obj);
+}
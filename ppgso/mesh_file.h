@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "mesh_base.h"
+
+namespace ppgso {
+
+  /*!
+   * Binary .ppmesh file with geometry laid out exactly as it is uploaded to the GPU.
+   *
+   * The file starts with a header followed by one table entry per shape. Each entry stores byte offsets and element
+   * counts of positions, texture coordinates, normals, indices and index counts of the levels of detail. All arrays
+   * are 4 byte aligned, little endian and can be passed to glBufferData directly from the memory mapping.
+   */
+  class MeshFile {
+  public:
+    static const unsigned int VERSION = 2;
+
+    /*!
+     * Map a .ppmesh file into memory and validate its layout.
+     *
+     * @param path - File path to the .ppmesh file.
+     */
+    explicit MeshFile(const std::string &path);
+
+    /*!
+     * Get the shapes stored in the file.
+     *
+     * @return - Views pointing into the mapped file, valid while this object exists.
+     */
+    const std::vector<ShapeView> &getShapes() const;
+
+    /*!
+     * Write shapes into a .ppmesh file.
+     *
+     * @param path - File path to write.
+     * @param shapes - Shapes to store.
+     */
+    static void save(const std::string &path, const std::vector<ShapeView> &shapes);
+
+    /*!
+     * Get the path of the binary file belonging to an obj file.
+     *
+     * @param obj - File path to the obj file.
+     * @return - The same path with the .ppmesh extension.
+     */
+    static std::string getBinaryPath(const std::string &obj);
+
+    /*!
+     * Check whether the binary file exists and is not older than the obj file.
+     *
+     * @param obj - File path to the obj file.
+     * @return - True when the binary file can be used instead of the obj file.
+     */
+    static bool isUpToDate(const std::string &obj);
+
+  private:
+    MappedFile file;
+    std::vector<ShapeView> shapes;
+  };
+
+}
@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+#include "mesh_optimizer.h"
+
+namespace {
+  // Size of the LRU cache the Forsyth scoring assumes, larger than real caches so the order suits all of them
+  const int FORSYTH_CACHE_SIZE = 32;
+  const float CACHE_DECAY_POWER = 1.5f;
+  const float LAST_TRIANGLE_SCORE = 0.75f;
+  const float VALENCE_BOOST_SCALE = 2.0f;
+  const float VALENCE_BOOST_POWER = 0.5f;
+
+  // FIFO cache used to find cluster boundaries for overdraw optimization
+  const unsigned int CLUSTER_CACHE_SIZE = 16;
+
+  const size_t NONE = std::numeric_limits<size_t>::max();
+
+  float getVertexScore(int cachePosition, unsigned int liveTriangles) {
+    // Vertices without remaining triangles must never attract the next triangle
+    if (liveTriangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+      // The last triangle's vertices get a fixed score so its immediate neighbours are not always preferred
+      if (cachePosition < 3)
+        score = LAST_TRIANGLE_SCORE;
+      else
+        score = std::pow(1.0f - (cachePosition - 3) / (float) (FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+
+    // Vertices with few triangles left are finished first, so they can leave the cache for good
+    return score + VALENCE_BOOST_SCALE * std::pow((float) liveTriangles, -VALENCE_BOOST_POWER);
+  }
+
+  /*!
+   * FIFO cache simulation over a range of a triangle list, counts transformed vertices.
+   */
+  class FifoCache {
+  public:
+    FifoCache(size_t vertexCount, unsigned int size) : timestamps(vertexCount, 0), size{size}, time{size + 1} {}
+
+    unsigned int access(unsigned int vertex) {
+      if (time - timestamps[vertex] <= size) return 0;
+      timestamps[vertex] = time++;
+      return 1;
+    }
+
+    void reset() {
+      // Moving time forward by the cache size evicts all entries at once
+      time += size + 1;
+    }
+
+  private:
+    std::vector<unsigned int> timestamps;
+    unsigned int size;
+    unsigned int time;
+  };
+}
+
+ppgso::VertexCacheStats ppgso::analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                                  unsigned int cacheSize) {
+  VertexCacheStats stats;
+  if (indices.size() < 3) return stats;
+
+  FifoCache cache{vertexCount, cacheSize};
+  std::vector<bool> referenced(vertexCount, false);
+  size_t transformed = 0, unique = 0;
+  for (auto index : indices) {
+    transformed += cache.access(index);
+    if (!referenced[index]) {
+      referenced[index] = true;
+      unique++;
+    }
+  }
+
+  stats.acmr = (double) transformed / (indices.size() / 3);
+  stats.atvr = (double) transformed / unique;
+  return stats;
+}
+
+void ppgso::optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount) {
+  size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0) return;
+
+  // Triangles of every vertex in one array, live triangles are kept at the front of each vertex's range
+  std::vector<unsigned int> liveTriangles(vertexCount, 0);
+  for (size_t i = 0; i < triangleCount * 3; i++)
+    liveTriangles[indices[i]]++;
+
+  std::vector<size_t> offsets(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; v++)
+    offsets[v + 1] = offsets[v] + liveTriangles[v];
+
+  std::vector<unsigned int> adjacency(triangleCount * 3);
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < triangleCount; t++)
+    for (int k = 0; k < 3; k++)
+      adjacency[fill[indices[t * 3 + k]]++] = (unsigned int) t;
+
+  std::vector<int> cachePosition(vertexCount, -1);
+  std::vector<float> vertexScore(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++)
+    vertexScore[v] = getVertexScore(-1, liveTriangles[v]);
+
+  std::vector<float> triangleScore(triangleCount);
+  size_t best = 0;
+  for (size_t t = 0; t < triangleCount; t++) {
+    triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    if (triangleScore[t] > triangleScore[best]) best = t;
+  }
+
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<unsigned int> cache, newCache;
+  cache.reserve(FORSYTH_CACHE_SIZE + 3);
+  newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+  std::vector<unsigned int> result;
+  result.reserve(triangleCount * 3);
+  size_t cursor = 0;
+
+  while (true) {
+    if (best == NONE) {
+      // Nothing in the cache has triangles left, continue with the next triangle in the original order
+      while (cursor < triangleCount && emitted[cursor]) cursor++;
+      if (cursor == triangleCount) break;
+      best = cursor;
+    }
+
+    emitted[best] = true;
+    const unsigned int *triangle = &indices[best * 3];
+    result.insert(result.end(), triangle, triangle + 3);
+
+    // Remove the triangle from the live triangles of its vertices
+    for (int k = 0; k < 3; k++) {
+      auto v = triangle[k];
+      auto begin = adjacency.begin() + offsets[v];
+      auto end = begin + liveTriangles[v];
+      auto found = std::find(begin, end, (unsigned int) best);
+      if (found != end) {
+        std::iter_swap(found, end - 1);
+        liveTriangles[v]--;
+      }
+    }
+
+    // The triangle's vertices move to the front of the LRU cache
+    newCache.clear();
+    for (int k = 0; k < 3; k++)
+      if (std::find(newCache.begin(), newCache.end(), triangle[k]) == newCache.end())
+        newCache.push_back(triangle[k]);
+    for (auto v : cache)
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+        newCache.push_back(v);
+
+    for (size_t i = 0; i < newCache.size(); i++) {
+      auto v = newCache[i];
+      cachePosition[v] = i < FORSYTH_CACHE_SIZE ? (int) i : -1;
+      vertexScore[v] = getVertexScore(cachePosition[v], liveTriangles[v]);
+    }
+
+    // Only triangles touching the cache changed their score, the best of them is emitted next
+    best = NONE;
+    float bestScore = -1.0f;
+    for (auto v : newCache) {
+      for (size_t a = offsets[v]; a < offsets[v] + liveTriangles[v]; a++) {
+        auto t = adjacency[a];
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] +
+                           vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > bestScore) {
+          bestScore = triangleScore[t];
+          best = t;
+        }
+      }
+    }
+
+    newCache.resize(std::min(newCache.size(), (size_t) FORSYTH_CACHE_SIZE));
+    cache.swap(newCache);
+  }
+
+  indices.swap(result);
+}
+
+void ppgso::optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<float> &positions,
+                             float threshold) {
+  size_t triangleCount = indices.size() / 3;
+  size_t vertexCount = positions.size() / 3;
+  if (triangleCount < 2 || vertexCount == 0) return;
+
+  // Hard boundaries are triangles missing the cache with all vertices, the cache starts over there anyway
+  std::vector<size_t> hardClusters;
+  {
+    FifoCache cache{vertexCount, CLUSTER_CACHE_SIZE};
+    for (size_t t = 0; t < triangleCount; t++) {
+      unsigned int misses = 0;
+      for (int k = 0; k < 3; k++)
+        misses += cache.access(indices[t * 3 + k]);
+      if (t == 0 || misses == 3)
+        hardClusters.push_back(t);
+    }
+    hardClusters.push_back(triangleCount);
+  }
+
+  // Soft boundaries split a cluster as soon as the part before them is not worse than the allowed ACMR
+  std::vector<size_t> clusters;
+  FifoCache cache{vertexCount, CLUSTER_CACHE_SIZE};
+  for (size_t c = 0; c + 1 < hardClusters.size(); c++) {
+    size_t start = hardClusters[c], end = hardClusters[c + 1];
+
+    cache.reset();
+    size_t misses = 0;
+    for (size_t t = start; t < end; t++)
+      for (int k = 0; k < 3; k++)
+        misses += cache.access(indices[t * 3 + k]);
+    double target = (double) misses / (end - start) * threshold;
+
+    clusters.push_back(start);
+    cache.reset();
+    misses = 0;
+    size_t clusterStart = start;
+    for (size_t t = start; t < end; t++) {
+      for (int k = 0; k < 3; k++)
+        misses += cache.access(indices[t * 3 + k]);
+      if (t + 1 < end && (double) misses / (t + 1 - clusterStart) <= target) {
+        clusters.push_back(t + 1);
+        clusterStart = t + 1;
+        cache.reset();
+        misses = 0;
+      }
+    }
+  }
+  clusters.push_back(triangleCount);
+
+  auto position = [&positions](unsigned int v) {
+    return glm::vec3{positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2]};
+  };
+
+  // Area weighted centroid and normal of each cluster and of the whole mesh
+  size_t clusterCount = clusters.size() - 1;
+  std::vector<glm::vec3> centroids(clusterCount), normals(clusterCount);
+  glm::vec3 meshCentroid{0.0f};
+  float meshArea = 0.0f;
+  for (size_t c = 0; c < clusterCount; c++) {
+    glm::vec3 centroid{0.0f}, normal{0.0f};
+    float area = 0.0f;
+    for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+      auto a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), d = position(indices[t * 3 + 2]);
+      auto cross = glm::cross(b - a, d - a);
+      float triangleArea = glm::length(cross);
+      centroid += (a + b + d) * (triangleArea / 3.0f);
+      normal += cross;
+      area += triangleArea;
+    }
+    meshCentroid += centroid;
+    meshArea += area;
+    centroids[c] = area > 0.0f ? centroid / area : position(indices[clusters[c] * 3]);
+    normals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3{0.0f};
+  }
+  if (meshArea > 0.0f)
+    meshCentroid /= meshArea;
+
+  // Clusters on the outside facing away from the center are likely to occlude the others, draw them first
+  std::vector<float> sortKeys(clusterCount);
+  std::vector<size_t> order(clusterCount);
+  for (size_t c = 0; c < clusterCount; c++) {
+    sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+    order[c] = c;
+  }
+  std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+  std::vector<unsigned int> result;
+  result.reserve(indices.size());
+  for (auto c : order)
+    result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+  indices.swap(result);
+}
+
+void ppgso::optimizeVertexFetch(ShapeData &shape) {
+  const auto UNUSED = std::numeric_limits<unsigned int>::max();
+  size_t vertexCount = shape.positions.size() / 3;
+
+  // Attributes are indexed together, one array of a different length would be left in the old order
+  auto matches = [vertexCount](const std::vector<float> &attribute, size_t components) {
+    return attribute.empty() || attribute.size() == vertexCount * components;
+  };
+  if (!matches(shape.texcoords, 2) || !matches(shape.normals, 3)) return;
+
+  std::vector<unsigned int> remap(vertexCount, UNUSED);
+  unsigned int next = 0;
+  for (auto &index : shape.indices) {
+    if (remap[index] == UNUSED)
+      remap[index] = next++;
+    index = remap[index];
+  }
+
+  auto reorder = [&remap, vertexCount, next](std::vector<float> &attribute, size_t components) {
+    if (attribute.empty()) return;
+    std::vector<float> result(next * components);
+    for (size_t v = 0; v < vertexCount; v++)
+      if (remap[v] != UNUSED)
+        std::copy_n(attribute.begin() + v * components, components, result.begin() + remap[v] * components);
+    attribute.swap(result);
+  };
+  reorder(shape.positions, 3);
+  reorder(shape.texcoords, 2);
+  reorder(shape.normals, 3);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+
+#include "mesh_base.h"
+
+namespace ppgso {
+
+  /*!
+   * Post-transform vertex cache efficiency of a triangle list.
+   */
+  struct VertexCacheStats {
+    // Average cache miss ratio, transformed vertices per triangle, 0.5 is the best possible for large meshes
+    double acmr = 0.0;
+    // Average transformed vertex ratio, transformed vertices per referenced vertex, 1.0 is the best possible
+    double atvr = 0.0;
+  };
+
+  /*!
+   * Simulate a FIFO post-transform vertex cache over a triangle list.
+   *
+   * @param indices - Triangle list.
+   * @param vertexCount - Number of vertices the indices refer to.
+   * @param cacheSize - Number of cache entries, 16 is close to most GPUs.
+   * @return - Cache statistics.
+   */
+  VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                      unsigned int cacheSize = 16);
+
+  /*!
+   * Reorder triangles so vertices are reused while they are still in the post-transform cache.
+   *
+   * Uses the greedy algorithm of Tom Forsyth, which scores vertices by their position in a simulated LRU cache and by
+   * the number of triangles still using them, and always emits the best scored triangle next.
+   *
+   * @param indices - Triangle list to reorder in place.
+   * @param vertexCount - Number of vertices the indices refer to.
+   */
+  void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount);
+
+  /*!
+   * Reorder clusters of triangles, so triangles facing away from the center of the mesh are drawn first and occlude
+   * the rest. Clusters are cut where the vertex cache restarts anyway or where it costs at most the given ratio of
+   * ACMR, so the result of optimizeVertexCache is mostly kept.
+   *
+   * @param indices - Triangle list ordered by optimizeVertexCache to reorder in place.
+   * @param positions - Vertex positions, 3 floats per vertex.
+   * @param threshold - Allowed growth of ACMR, 1.05 allows 5 % more vertex shader invocations.
+   */
+  void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<float> &positions,
+                        float threshold = 1.05f);
+
+  /*!
+   * Reorder vertices in the order the triangles first use them, so vertex fetches read memory sequentially.
+   * Vertices not used by any triangle are dropped. Shapes with texture coordinates or normals of another vertex
+   * count than the positions are left unchanged.
+   *
+   * @param shape - Shape to reorder, its attribute arrays and indices are remapped in place.
+   */
+  void optimizeVertexFetch(ShapeData &shape);
+}
@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "mesh_simplifier.h"
+#include "mesh_optimizer.h"
+
+namespace {
+  // Open borders are kept in place by planes perpendicular to them, weighted above the surface planes
+  const double BORDER_WEIGHT = 10.0;
+
+  // Shapes this small cost less to draw than to switch levels for
+  const size_t LOD_MIN_TRIANGLES = 256;
+
+  /*!
+   * Symmetric 4x4 matrix of a quadric error, the sum of squared distances to a set of planes.
+   */
+  struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+    void addPlane(const glm::dvec3 &normal, double distance, double weight) {
+      a2 += weight * normal.x * normal.x;
+      ab += weight * normal.x * normal.y;
+      ac += weight * normal.x * normal.z;
+      ad += weight * normal.x * distance;
+      b2 += weight * normal.y * normal.y;
+      bc += weight * normal.y * normal.z;
+      bd += weight * normal.y * distance;
+      c2 += weight * normal.z * normal.z;
+      cd += weight * normal.z * distance;
+      d2 += weight * distance * distance;
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+      a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad; b2 += other.b2;
+      bc += other.bc; bd += other.bd; c2 += other.c2; cd += other.cd; d2 += other.d2;
+      return *this;
+    }
+
+    double evaluate(const glm::dvec3 &p) const {
+      double error = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+                     + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+                     + c2 * p.z * p.z + 2 * cd * p.z + d2;
+      return std::abs(error);
+    }
+  };
+
+  struct Collapse {
+    unsigned int from, to;
+    double cost;
+  };
+
+  uint64_t getEdgeKey(unsigned int a, unsigned int b) {
+    if (a > b) std::swap(a, b);
+    return ((uint64_t) a << 32) | b;
+  }
+
+  /*!
+   * Mesh welded by position, collapses operate on positions while the triangles keep indexing the original vertices.
+   */
+  class Simplifier {
+  public:
+    Simplifier(const ppgso::ShapeView &shape, const std::vector<unsigned int> &indices) : triangles{indices}, shape(shape) {
+      auto vertexCount = shape.positionsSize / 3;
+      hasTexcoords = shape.texcoordsSize == vertexCount * 2;
+      hasNormals = shape.normalsSize == vertexCount * 3;
+
+      // Vertices with bit identical positions are one position, seams in normals or texture coordinates stay welded
+      std::unordered_map<std::string, unsigned int> unique;
+      positionOf.resize(vertexCount);
+      for (size_t v = 0; v < vertexCount; v++) {
+        std::string key(reinterpret_cast<const char *>(shape.positions + v * 3), sizeof(float) * 3);
+        auto result = unique.emplace(key, (unsigned int) points.size());
+        if (result.second)
+          points.emplace_back(shape.positions[v * 3], shape.positions[v * 3 + 1], shape.positions[v * 3 + 2]);
+        positionOf[v] = result.first->second;
+      }
+
+      // Vertices sharing each position, the candidates a collapsed vertex is replaced with
+      groupStart.assign(points.size() + 1, 0);
+      for (auto p : positionOf) groupStart[p + 1]++;
+      for (size_t p = 0; p < points.size(); p++) groupStart[p + 1] += groupStart[p];
+      groupVertices.resize(vertexCount);
+      auto fill = groupStart;
+      for (size_t v = 0; v < vertexCount; v++) groupVertices[fill[positionOf[v]]++] = (unsigned int) v;
+
+      removeDegenerate();
+      computeQuadrics();
+    }
+
+    void simplify(size_t targetTriangles) {
+      while (triangles.size() / 3 > targetTriangles) {
+        if (!collapsePass(triangles.size() / 3 - targetTriangles)) break;
+        removeDegenerate();
+      }
+    }
+
+    std::vector<unsigned int> triangles;
+
+  private:
+    glm::dvec3 getNormal(unsigned int a, unsigned int b, unsigned int c) const {
+      return glm::cross(points[b] - points[a], points[c] - points[a]);
+    }
+
+    void removeDegenerate() {
+      size_t kept = 0;
+      for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        auto a = positionOf[triangles[t]], b = positionOf[triangles[t + 1]], c = positionOf[triangles[t + 2]];
+        if (a == b || b == c || a == c) continue;
+        std::memmove(&triangles[kept], &triangles[t], 3 * sizeof(unsigned int));
+        kept += 3;
+      }
+      triangles.resize(kept);
+    }
+
+    void computeQuadrics() {
+      quadrics.assign(points.size(), Quadric{});
+      std::unordered_map<uint64_t, unsigned int> edgeUse;
+      for (size_t t = 0; t < triangles.size(); t += 3) {
+        unsigned int p[3] = {positionOf[triangles[t]], positionOf[triangles[t + 1]], positionOf[triangles[t + 2]]};
+        auto normal = getNormal(p[0], p[1], p[2]);
+        double area = glm::length(normal);
+        if (area == 0.0) continue;
+        normal /= area;
+
+        // Area weighting keeps large faces flat while slivers barely matter
+        Quadric plane;
+        plane.addPlane(normal, -glm::dot(normal, points[p[0]]), area * 0.5);
+        for (auto v : p) quadrics[v] += plane;
+        for (int e = 0; e < 3; e++) edgeUse[getEdgeKey(p[e], p[(e + 1) % 3])]++;
+      }
+
+      for (size_t t = 0; t < triangles.size(); t += 3) {
+        unsigned int p[3] = {positionOf[triangles[t]], positionOf[triangles[t + 1]], positionOf[triangles[t + 2]]};
+        auto normal = getNormal(p[0], p[1], p[2]);
+        if (glm::length(normal) == 0.0) continue;
+        for (int e = 0; e < 3; e++) {
+          auto a = p[e], b = p[(e + 1) % 3];
+          if (edgeUse[getEdgeKey(a, b)] != 1) continue;
+          auto edge = points[b] - points[a];
+          auto length = glm::length(edge);
+          auto borderNormal = glm::cross(edge, normal);
+          if (length == 0.0 || glm::length(borderNormal) == 0.0) continue;
+          borderNormal = glm::normalize(borderNormal);
+
+          Quadric border;
+          border.addPlane(borderNormal, -glm::dot(borderNormal, points[a]), BORDER_WEIGHT * length * length);
+          quadrics[a] += border;
+          quadrics[b] += border;
+        }
+      }
+    }
+
+    /*!
+     * Collapse the cheapest edges whose neighbourhoods do not overlap, so every collapse is evaluated on an up to
+     * date mesh. Returns false when no edge could be collapsed.
+     */
+    bool collapsePass(size_t trianglesToRemove) {
+      // Triangles around each position
+      std::vector<unsigned int> adjacencyStart(points.size() + 1, 0);
+      for (auto v : triangles) adjacencyStart[positionOf[v] + 1]++;
+      for (size_t p = 0; p < points.size(); p++) adjacencyStart[p + 1] += adjacencyStart[p];
+      std::vector<unsigned int> adjacency(triangles.size());
+      auto fill = adjacencyStart;
+      for (size_t i = 0; i < triangles.size(); i++) adjacency[fill[positionOf[triangles[i]]]++] = (unsigned int) (i / 3);
+
+      // Edges used by a single triangle are open borders
+      std::unordered_map<uint64_t, unsigned int> edgeUse;
+      edgeUse.reserve(triangles.size());
+      for (size_t t = 0; t < triangles.size(); t += 3)
+        for (int e = 0; e < 3; e++)
+          edgeUse[getEdgeKey(positionOf[triangles[t + e]], positionOf[triangles[t + (e + 1) % 3]])]++;
+
+      std::vector<bool> onBorder(points.size(), false);
+      for (auto &edge : edgeUse) {
+        if (edge.second != 1) continue;
+        onBorder[edge.first >> 32] = true;
+        onBorder[edge.first & 0xffffffffu] = true;
+      }
+
+      std::vector<Collapse> collapses;
+      collapses.reserve(edgeUse.size());
+      for (auto &edge : edgeUse) {
+        auto a = (unsigned int) (edge.first >> 32), b = (unsigned int) (edge.first & 0xffffffffu);
+        bool borderEdge = edge.second == 1;
+
+        // Border positions may only slide along the border, otherwise holes would open or close
+        Collapse best{a, b, HUGE_VAL};
+        auto combined = quadrics[a];
+        combined += quadrics[b];
+        if (!onBorder[a] || borderEdge) best = {a, b, combined.evaluate(points[b])};
+        if (!onBorder[b] || borderEdge) {
+          auto cost = combined.evaluate(points[a]);
+          if (cost < best.cost) best = {b, a, cost};
+        }
+        if (best.cost < HUGE_VAL) collapses.push_back(best);
+      }
+      std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) {
+        if (x.cost != y.cost) return x.cost < y.cost;
+        return getEdgeKey(x.from, x.to) < getEdgeKey(y.from, y.to);
+      });
+
+      std::vector<bool> locked(points.size(), false);
+      std::vector<unsigned int> target(points.size());
+      for (size_t p = 0; p < points.size(); p++) target[p] = (unsigned int) p;
+
+      size_t removed = 0, collapsed = 0;
+      for (auto &collapse : collapses) {
+        if (removed >= trianglesToRemove) break;
+        if (locked[collapse.from] || locked[collapse.to]) continue;
+        if (flipsTriangle(collapse, adjacency, adjacencyStart)) continue;
+
+        target[collapse.from] = collapse.to;
+        quadrics[collapse.to] += quadrics[collapse.from];
+        collapsed++;
+
+        // The one-ring of the collapsed position changes shape, its edges are evaluated again in the next pass
+        for (auto i = adjacencyStart[collapse.from]; i < adjacencyStart[collapse.from + 1]; i++) {
+          auto t = adjacency[i] * 3;
+          bool shared = false;
+          for (int c = 0; c < 3; c++) {
+            auto p = positionOf[triangles[t + c]];
+            locked[p] = true;
+            shared |= p == collapse.to;
+          }
+          if (shared) removed++;
+        }
+      }
+      if (!collapsed) return false;
+
+      remapVertices(target);
+      return true;
+    }
+
+    bool flipsTriangle(const Collapse &collapse, const std::vector<unsigned int> &adjacency,
+                       const std::vector<unsigned int> &adjacencyStart) const {
+      for (auto i = adjacencyStart[collapse.from]; i < adjacencyStart[collapse.from + 1]; i++) {
+        auto t = adjacency[i] * 3;
+        unsigned int p[3] = {positionOf[triangles[t]], positionOf[triangles[t + 1]], positionOf[triangles[t + 2]]};
+        if (p[0] == collapse.to || p[1] == collapse.to || p[2] == collapse.to) continue;
+
+        auto before = getNormal(p[0], p[1], p[2]);
+        for (auto &v : p)
+          if (v == collapse.from) v = collapse.to;
+        auto after = getNormal(p[0], p[1], p[2]);
+        if (glm::dot(before, after) <= 0.0) return true;
+      }
+      return false;
+    }
+
+    float getAttributeDistance(unsigned int a, unsigned int b) const {
+      float distance = 0.0f;
+      if (hasNormals)
+        for (int c = 0; c < 3; c++) distance += std::pow(shape.normals[a * 3 + c] - shape.normals[b * 3 + c], 2.0f);
+      if (hasTexcoords)
+        for (int c = 0; c < 2; c++)
+          distance += std::pow(shape.texcoords[a * 2 + c] - shape.texcoords[b * 2 + c], 2.0f);
+      return distance;
+    }
+
+    void remapVertices(const std::vector<unsigned int> &target) {
+      // Every vertex of a collapsed position is replaced with the most similar vertex of the remaining position
+      std::unordered_map<unsigned int, unsigned int> replacement;
+      for (auto &v : triangles) {
+        auto to = target[positionOf[v]];
+        if (to == positionOf[v]) continue;
+
+        auto found = replacement.find(v);
+        if (found == replacement.end()) {
+          auto best = groupVertices[groupStart[to]];
+          auto bestDistance = getAttributeDistance(v, best);
+          for (auto i = groupStart[to] + 1; i < groupStart[to + 1]; i++) {
+            auto distance = getAttributeDistance(v, groupVertices[i]);
+            if (distance < bestDistance) {
+              best = groupVertices[i];
+              bestDistance = distance;
+            }
+          }
+          found = replacement.emplace(v, best).first;
+        }
+        v = found->second;
+      }
+    }
+
+    const ppgso::ShapeView &shape;
+    bool hasTexcoords, hasNormals;
+    std::vector<unsigned int> positionOf;
+    std::vector<glm::dvec3> points;
+    std::vector<Quadric> quadrics;
+    std::vector<unsigned int> groupStart, groupVertices;
+  };
+}
+
+std::vector<unsigned int> ppgso::simplifyMesh(const ShapeView &shape, const std::vector<unsigned int> &indices,
+                                              size_t targetTriangles) {
+  Simplifier simplifier{shape, indices};
+  simplifier.simplify(targetTriangles);
+  return std::move(simplifier.triangles);
+}
+
+void ppgso::generateLods(ShapeData &shape, const std::vector<float> &ratios) {
+  auto fullTriangles = shape.indices.size() / 3;
+  if (fullTriangles < LOD_MIN_TRIANGLES || !shape.lodIndexCounts.empty()) return;
+
+  auto vertexCount = shape.positions.size() / 3;
+  std::vector<unsigned int> lods{(unsigned int) shape.indices.size()};
+  std::vector<unsigned int> previous = shape.indices;
+  for (auto ratio : ratios) {
+    auto target = (size_t) (fullTriangles * ratio);
+    auto simplified = simplifyMesh(shape.view(), previous, target);
+    if (simplified.empty() || simplified.size() > previous.size() * 9 / 10) break;
+
+    optimizeVertexCache(simplified, vertexCount);
+    lods.push_back((unsigned int) simplified.size());
+    shape.indices.insert(shape.indices.end(), simplified.begin(), simplified.end());
+    previous = std::move(simplified);
+  }
+
+  if (lods.size() > 1) shape.lodIndexCounts = std::move(lods);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+
+#include "mesh_base.h"
+
+namespace ppgso {
+
+  /*!
+   * Reduce the number of triangles with quadric error metric edge collapses.
+   *
+   * Vertices are welded by position, so attribute seams do not stop the simplification, and every collapse moves a
+   * position onto a neighbouring one. The vertices of the collapsed position are replaced by the vertices of the
+   * remaining position with the closest normal and texture coordinate, so the result indexes the original vertex
+   * arrays and can share the vertex buffer with the full detail mesh. Open borders only collapse along themselves
+   * and collapses flipping a triangle are rejected.
+   *
+   * @param shape - Vertex attributes of the shape.
+   * @param indices - Triangle list to simplify.
+   * @param targetTriangles - Number of triangles to reduce to, the result may stay above it when the mesh cannot be
+   * simplified further.
+   * @return - Simplified triangle list.
+   */
+  std::vector<unsigned int> simplifyMesh(const ShapeView &shape, const std::vector<unsigned int> &indices,
+                                         size_t targetTriangles);
+
+  /*!
+   * Append levels of detail to a shape, each one simplified from the previous one and ordered for the vertex cache.
+   * Levels that would not drop at least a tenth of the triangles of the previous one are skipped.
+   *
+   * @param shape - Shape with a single level of detail, its indices and lodIndexCounts are extended.
+   * @param ratios - Triangle counts of the levels relative to the full detail mesh, in decreasing order.
+   */
+  void generateLods(ShapeData &shape, const std::vector<float> &ratios = {0.5f, 0.25f, 0.1f});
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace ppgso {
+
+  /*!
+   * Unbounded lock-free queue with many producers and a single consumer.
+   *
+   * Producers never block each other, a push is a single atomic exchange. Only one thread may call pop at a time.
+   * The queue always keeps one node as a stub, so the value type has to be default constructible.
+   */
+  template<typename T>
+  class MpscQueue {
+  public:
+    MpscQueue() : head{new Node}, tail{head.load()} {}
+
+    ~MpscQueue() {
+      while (tail) {
+        auto next = tail->next.load();
+        delete tail;
+        tail = next;
+      }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /*!
+     * Add a value to the queue, safe to call from any thread.
+     *
+     * @param value - Value to move into the queue.
+     */
+    void push(T value) {
+      auto node = new Node;
+      node->value = std::move(value);
+      auto previous = head.exchange(node, std::memory_order_acq_rel);
+      previous->next.store(node, std::memory_order_release);
+    }
+
+    /*!
+     * Take the oldest value from the queue, only from the consumer thread.
+     *
+     * @param value - Receives the value when the queue is not empty.
+     * @return - False when the queue is empty.
+     */
+    bool pop(T &value) {
+      auto next = tail->next.load(std::memory_order_acquire);
+      if (!next) return false;
+      value = std::move(next->value);
+      delete tail;
+      tail = next;
+      return true;
+    }
+
+  private:
+    struct Node {
+      std::atomic<Node *> next{nullptr};
+      T value{};
+    };
+
+    std::atomic<Node *> head;
+    Node *tail;
+  };
+
+}
@@ -18,12 +18,16 @@ namespace ppgso {
 #endif
 }
 
+#include "gl_state.h"
 #include "shader.h"
+#include "shader_variants.h"
 #include "image.h"
 #include "image_bmp.h"
 #include "image_raw.h"
 #include "texture.h"
 #include "window.h"
+#include "asset_loader.h"
+#include "asset_cache.h"
 
 namespace ppgso {
   /*!
@@ -1,65 +1,188 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+  #include <direct.h>
+#endif
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_state.h"
 #include "texture.h"
 #include "shader.h"
 
 
-ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
-  // Create shaders
-  auto vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-  auto fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
-  auto result = GL_FALSE;
-  auto info_length = 0;
+namespace {
+  const char BINARY_MAGIC[4] = {'P', 'P', 'S', 'B'};
 
-  // Compile vertex shader
-  auto vertex_shader_code_ptr = vertex_shader_code.c_str();
-  glShaderSource(vertex_shader_id, 1, &vertex_shader_code_ptr, nullptr);
-  glCompileShader(vertex_shader_id);
+  struct BinaryHeader {
+    char magic[4];
+    uint32_t format;
+    uint64_t key;
+    uint32_t length;
+    uint32_t reserved;
+  };
 
-  // Check vertex shader log
-  glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderiv(vertex_shader_id, GL_INFO_LOG_LENGTH, &info_length);
-    std::string vertex_shader_log((unsigned int) info_length, ' ');
-    glGetShaderInfoLog(vertex_shader_id, info_length, nullptr,
-                       &vertex_shader_log[0]);
-    std::stringstream msg;
-    msg << "Error Compiling Vertex Shader ..." << std::endl;
-    msg << vertex_shader_log;
-    throw std::runtime_error(msg.str());
+  // FNV-1a, strings are terminated so "ab" + "c" and "a" + "bc" differ
+  void hashString(uint64_t &hash, const char *text) {
+    if (!text) text = "";
+    do {
+      hash ^= (unsigned char) *text;
+      hash *= 1099511628211ull;
+    } while (*text++);
   }
 
-  // Compile fragment shader
-  auto fragment_shader_code_ptr = fragment_shader_code.c_str();
-  glShaderSource(fragment_shader_id, 1, &fragment_shader_code_ptr, nullptr);
-  glCompileShader(fragment_shader_id);
+  bool binariesSupported() {
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+  }
 
-  // Check fragment shader log
-  glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderiv(fragment_shader_id, GL_INFO_LOG_LENGTH, &info_length);
-    std::string fragment_shader_log((unsigned long) info_length, ' ');
-    glGetShaderInfoLog(fragment_shader_id, info_length, nullptr,
-                       &fragment_shader_log[0]);
-    std::stringstream msg;
-    msg << "Error Compiling Fragment Shader ..." << std::endl;
-    msg << fragment_shader_log << std::endl;
-    throw std::runtime_error(msg.str());
+  bool makeDirectory(const std::string &directory) {
+    struct stat info{};
+    if (stat(directory.c_str(), &info) == 0) return (info.st_mode & S_IFDIR) != 0;
+#ifdef _WIN32
+    return _mkdir(directory.c_str()) == 0;
+#else
+    return mkdir(directory.c_str(), 0755) == 0;
+#endif
+  }
+
+  std::string applyDefines(const std::string &code, const ppgso::ShaderDefines &defines) {
+    std::stringstream lines;
+    for (auto &define : defines)
+      lines << "#define " << define.first << " " << define.second << "\n";
+    return ppgso::Shader::addPrefix(code, lines.str());
+  }
+
+  GLuint compileStage(GLenum type, const std::string &code) {
+    auto shader_id = glCreateShader(type);
+    auto code_ptr = code.c_str();
+    glShaderSource(shader_id, 1, &code_ptr, nullptr);
+    glCompileShader(shader_id);
+
+    // Check shader log
+    auto result = GL_FALSE;
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      auto info_length = 0;
+      glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &info_length);
+      std::string shader_log((unsigned long) info_length, ' ');
+      glGetShaderInfoLog(shader_id, info_length, nullptr, &shader_log[0]);
+      const char *stage = type == GL_VERTEX_SHADER ? "Vertex" : type == GL_GEOMETRY_SHADER ? "Geometry" : "Fragment";
+      std::stringstream msg;
+      msg << "Error Compiling " << stage << " Shader ..." << std::endl;
+      msg << shader_log << std::endl;
+      throw std::runtime_error(msg.str());
+    }
+    return shader_id;
+  }
+
+  double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
   }
+}
+
+// Prefixes must follow #version, which has to be the first statement of the source
+std::string ppgso::Shader::addPrefix(const std::string &code, const std::string &prefix) {
+  auto version = code.find("#version");
+  if (version == std::string::npos) return prefix + code;
+  auto end = code.find('\n', version);
+  if (end == std::string::npos) return code + "\n" + prefix;
+  return code.substr(0, end + 1) + prefix + code.substr(end + 1);
+}
+
+ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
+  link(vertex_shader_code, "", fragment_shader_code, {});
+}
+
+ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code,
+                      const ShaderDefines &defines)
+        : Shader(applyDefines(vertex_shader_code, defines), applyDefines(fragment_shader_code, defines)) {}
+
+ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &geometry_shader_code,
+                      const std::string &fragment_shader_code, const std::vector<std::string> &feedback_varyings) {
+  link(vertex_shader_code, geometry_shader_code, fragment_shader_code, feedback_varyings);
+}
+
+void ppgso::Shader::link(const std::string &vertex_shader_code, const std::string &geometry_shader_code,
+                         const std::string &fragment_shader_code, const std::vector<std::string> &feedback_varyings) {
+  auto start = std::chrono::steady_clock::now();
+  auto &stats = getLinkStats();
 
+  // The cache is only used when the driver can return binaries and the directory is writable
+  std::string path;
+  uint64_t key = 14695981039346656037ull;
+  if (!binaryCache.empty() && binariesSupported() && makeDirectory(binaryCache)) {
+    hashString(key, (const char *) glGetString(GL_VENDOR));
+    hashString(key, (const char *) glGetString(GL_RENDERER));
+    hashString(key, (const char *) glGetString(GL_VERSION));
+    hashString(key, vertex_shader_code.c_str());
+    hashString(key, fragment_shader_code.c_str());
+    // Programs without these stages keep the keys they had before geometry shaders were supported
+    if (!geometry_shader_code.empty()) hashString(key, geometry_shader_code.c_str());
+    for (auto &varying : feedback_varyings)
+      hashString(key, varying.c_str());
+
+    std::stringstream name;
+    name << binaryCache << "/" << std::hex << key << ".bin";
+    path = name.str();
+  }
+
+  if (!path.empty() && loadBinary(path, key)) {
+    stats.cached++;
+    stats.cacheTime += millisecondsSince(start);
+  } else {
+    compile(vertex_shader_code, geometry_shader_code, fragment_shader_code, feedback_varyings, !path.empty());
+    if (!path.empty()) saveBinary(path, key);
+    stats.compiled++;
+    stats.compileTime += millisecondsSince(start);
+  }
+
+  resolveUniforms();
+  use();
+}
+
+void ppgso::Shader::compile(const std::string &vertex_shader_code, const std::string &geometry_shader_code,
+                            const std::string &fragment_shader_code,
+                            const std::vector<std::string> &feedback_varyings, bool retrievable) {
   // Create and link the program
   auto program_id = glCreateProgram();
-  glAttachShader(program_id, vertex_shader_id);
-  glAttachShader(program_id, fragment_shader_id);
+  std::vector<GLuint> shaders;
+  const std::pair<GLenum, const std::string *> stages[] = {
+          {GL_VERTEX_SHADER, &vertex_shader_code},
+          {GL_GEOMETRY_SHADER, &geometry_shader_code},
+          {GL_FRAGMENT_SHADER, &fragment_shader_code}
+  };
+  for (auto &stage : stages) {
+    if (stage.first != GL_VERTEX_SHADER && stage.second->empty()) continue;
+    auto shader_id = compileStage(stage.first, *stage.second);
+    glAttachShader(program_id, shader_id);
+    shaders.push_back(shader_id);
+  }
+
   glBindFragDataLocation(program_id, 0, "FragmentColor");
+  if (!feedback_varyings.empty()) {
+    std::vector<const char *> names;
+    for (auto &varying : feedback_varyings)
+      names.push_back(varying.c_str());
+    glTransformFeedbackVaryings(program_id, (GLsizei) names.size(), names.data(), GL_INTERLEAVED_ATTRIBS);
+  }
+  if (retrievable) glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glLinkProgram(program_id);
 
   // Check program log
+  auto result = GL_FALSE;
+  auto info_length = 0;
   glGetProgramiv(program_id, GL_LINK_STATUS, &result);
   if (result == GL_FALSE) {
     glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_length);
@@ -70,19 +193,141 @@ ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &
     msg << program_log;
     throw std::runtime_error(msg.str());
   }
-  glDeleteShader(vertex_shader_id);
-  glDeleteShader(fragment_shader_id);
+  for (auto shader_id : shaders)
+    glDeleteShader(shader_id);
 
   program = program_id;
-  use();
+}
+
+bool ppgso::Shader::loadBinary(const std::string &path, uint64_t key) {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file) return false;
+  auto size = (uint64_t) file.tellg();
+  file.seekg(0);
+
+  BinaryHeader header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file || std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 || header.key != key)
+    return false;
+
+  // A truncated or corrupt file must not decide how much memory is allocated, saveBinary writes nothing else
+  if (header.length == 0 || header.length != size - sizeof(header))
+    return false;
+
+  std::vector<char> binary(header.length);
+  file.read(binary.data(), (std::streamsize) binary.size());
+  if (!file) return false;
+
+  auto program_id = glCreateProgram();
+  glProgramBinary(program_id, (GLenum) header.format, binary.data(), (GLsizei) binary.size());
+
+  // Drivers reject binaries of other versions, the program is then compiled as if there was no cache
+  auto result = GL_FALSE;
+  glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+  if (result == GL_FALSE) {
+    glDeleteProgram(program_id);
+    getLinkStats().rejected++;
+    return false;
+  }
+
+  program = program_id;
+  return true;
+}
+
+void ppgso::Shader::saveBinary(const std::string &path, uint64_t key) const {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+
+  std::vector<char> binary((size_t) length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  BinaryHeader header{};
+  std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  header.format = format;
+  header.key = key;
+  header.length = (uint32_t) length;
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(binary.data(), length);
+  if (!file) std::cerr << "Could not write shader binary " << path << std::endl;
 }
 
 ppgso::Shader::~Shader() {
+  // A new program may get the same name, it must not be taken as bound
+  GLState::deleteProgram(program);
   glDeleteProgram( program );
 }
 
+std::string ppgso::Shader::binaryCache;
+
+void ppgso::Shader::setBinaryCache(const std::string &directory) {
+  binaryCache = directory;
+}
+
+ppgso::Shader::LinkStats &ppgso::Shader::getLinkStats() {
+  static LinkStats stats;
+  return stats;
+}
+
+ppgso::Shader::CallStats &ppgso::Shader::getCallStats() {
+  static CallStats stats;
+  return stats;
+}
+
+void ppgso::Shader::resolveUniforms() {
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+  std::string name((size_t) std::max(maxLength, 1), '\0');
+  for (GLint i = 0; i < count; i++) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program, (GLuint) i, (GLsizei) name.size(), &length, &size, &type, &name[0]);
+    std::string uniform = name.substr(0, (size_t) length);
+
+    // Members of uniform blocks have no location
+    auto location = glGetUniformLocation(program, uniform.c_str());
+    if (location < 0) continue;
+    uniforms[uniform] = location;
+
+    // Arrays are reported once as "name[0]", their elements are not guaranteed to have consecutive locations
+    auto suffix = uniform.rfind("[0]");
+    if (suffix == std::string::npos || suffix + 3 != uniform.size()) continue;
+    auto base = uniform.substr(0, suffix);
+    uniforms[base] = location;
+    for (GLint element = 1; element < size; element++) {
+      auto elementName = base + "[" + std::to_string(element) + "]";
+      auto elementLocation = glGetUniformLocation(program, elementName.c_str());
+      if (elementLocation >= 0) uniforms[elementName] = elementLocation;
+    }
+  }
+}
+
+GLint ppgso::Shader::findUniform(const std::string &name) const {
+  getCallStats().elided++;
+  auto uniform = uniforms.find(name);
+  return uniform == uniforms.end() ? -1 : uniform->second;
+}
+
+bool ppgso::Shader::prepareUniform(UniformHandle uniform) const {
+  use();
+  // OpenGL ignores location -1, so the call is not worth making
+  auto &stats = getCallStats();
+  if (uniform.location < 0) {
+    stats.elided++;
+    return false;
+  }
+  stats.issued++;
+  return true;
+}
+
 void ppgso::Shader::use() const {
-  glUseProgram(program);
+  GLState::useProgram(program);
 }
 
 GLuint ppgso::Shader::getAttribLocation(const std::string &name) const {
@@ -92,32 +337,37 @@ GLuint ppgso::Shader::getAttribLocation(const std::string &name) const {
 
 GLuint ppgso::Shader::getUniformLocation(const std::string &name) const {
   use();
-  return (GLuint) glGetUniformLocation(program, name.c_str());
+  return (GLuint) findUniform(name);
+}
+
+ppgso::UniformHandle ppgso::Shader::getUniform(const std::string &name) const {
+  UniformHandle handle;
+  auto uniform = uniforms.find(name);
+  if (uniform != uniforms.end()) handle.location = uniform->second;
+  return handle;
+}
+
+bool ppgso::Shader::bindUniformBlock(const std::string &name, GLuint binding) const {
+  auto index = glGetUniformBlockIndex(program, name.c_str());
+  if (index == GL_INVALID_INDEX) return false;
+  glUniformBlockBinding(program, index, binding);
+  return true;
 }
 
 void ppgso::Shader::setUniform(const std::string &name, const Texture &texture, const int id) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform1i(uniform, id);
-  texture.bind(id);
+  setUniform(UniformHandle{findUniform(name)}, texture, id);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::mat4 matrix) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniformMatrix4fv(uniform, 1, GL_FALSE, value_ptr(matrix));
+  setUniform(UniformHandle{findUniform(name)}, matrix);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::mat3 matrix) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniformMatrix3fv(uniform, 1, GL_FALSE, value_ptr(matrix));
+  setUniform(UniformHandle{findUniform(name)}, matrix);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, float value) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform1f(uniform, value);
+  setUniform(UniformHandle{findUniform(name)}, value);
 }
 
 GLuint ppgso::Shader::getProgram() const {
@@ -125,19 +375,54 @@ GLuint ppgso::Shader::getProgram() const {
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::vec2 vector) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform2fv(uniform, 1, value_ptr(vector));
+  setUniform(UniformHandle{findUniform(name)}, vector);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::vec3 vector) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform3fv(uniform, 1, value_ptr(vector));
+  setUniform(UniformHandle{findUniform(name)}, vector);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::vec4 vector) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform4fv(uniform, 1, value_ptr(vector));
+  setUniform(UniformHandle{findUniform(name)}, vector);
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, const Texture &texture, const int id) const {
+  if (prepareUniform(uniform))
+    glUniform1i(uniform.location, id);
+  texture.bind(id);
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, glm::mat4 matrix) const {
+  if (prepareUniform(uniform))
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, value_ptr(matrix));
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, glm::mat3 matrix) const {
+  if (prepareUniform(uniform))
+    glUniformMatrix3fv(uniform.location, 1, GL_FALSE, value_ptr(matrix));
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, float value) const {
+  if (prepareUniform(uniform))
+    glUniform1f(uniform.location, value);
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, int value) const {
+  if (prepareUniform(uniform))
+    glUniform1i(uniform.location, value);
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, glm::vec2 vector) const {
+  if (prepareUniform(uniform))
+    glUniform2fv(uniform.location, 1, value_ptr(vector));
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, glm::vec3 vector) const {
+  if (prepareUniform(uniform))
+    glUniform3fv(uniform.location, 1, value_ptr(vector));
+}
+
+void ppgso::Shader::setUniform(UniformHandle uniform, glm::vec4 vector) const {
+  if (prepareUniform(uniform))
+    glUniform4fv(uniform.location, 1, value_ptr(vector));
 }
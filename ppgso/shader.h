@@ -1,6 +1,10 @@
 #pragma once
+#include <cstdint>
+#include <map>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -9,8 +13,45 @@
 
 namespace ppgso {
 
+  /*!
+   * Uniform location resolved once, setting a uniform through it needs no name lookup.
+   * Handles of uniforms the program does not use are ignored by setUniform, the same as unknown names.
+   */
+  struct UniformHandle {
+    GLint location = -1;
+  };
+
+  /*!
+   * Preprocessor values compiled into a shader program, e.g. {"POINT_LIGHTS", 4} becomes "#define POINT_LIGHTS 4".
+   */
+  using ShaderDefines = std::map<std::string, int>;
+
   class Shader {
   public:
+    /*!
+     * Uniform calls made by all shaders, and calls they avoided compared to looking up every uniform by name.
+     * Binding the programs is counted by GLState.
+     */
+    struct CallStats {
+      // glUniform calls issued
+      size_t issued = 0;
+      // glUniform calls for uniforms the program does not use and glGetUniformLocation calls answered from the cache
+      size_t elided = 0;
+    };
+
+    /*!
+     * Programs created by all shaders and the time spent linking them, split by where the program came from.
+     */
+    struct LinkStats {
+      // Programs compiled and linked from source, all of them on a cold start
+      size_t compiled = 0;
+      double compileTime = 0.0;
+      // Programs loaded from the binary cache on a warm start
+      size_t cached = 0;
+      double cacheTime = 0.0;
+      // Cached binaries the driver did not accept, e.g. after a driver update, compiled from source instead
+      size_t rejected = 0;
+    };
 
     /*!
      * Compile and manage an GLSL program and its inputs.
@@ -20,10 +61,34 @@ namespace ppgso {
      */
     Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code);
 
+    /*!
+     * Compile a variant of a GLSL program specialized by preprocessor defines.
+     * The defines are inserted after the #version line of both shaders.
+     *
+     * @param vertex_shader_code - String containing the source of the vertex shader.
+     * @param fragment_shader_code - String containing the source of the fragment shader.
+     * @param defines - Names and values to define in both shaders.
+     */
+    Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code,
+           const ShaderDefines &defines);
+
+    /*!
+     * Compile a GLSL program with a geometry shader whose outputs can be captured with transform feedback.
+     *
+     * @param vertex_shader_code - String containing the source of the vertex shader.
+     * @param geometry_shader_code - String containing the source of the geometry shader, empty for none.
+     * @param fragment_shader_code - String containing the source of the fragment shader, empty for programs only
+     * used with GL_RASTERIZER_DISCARD.
+     * @param feedback_varyings - Outputs of the last vertex processing stage captured into one interleaved buffer.
+     */
+    Shader(const std::string &vertex_shader_code, const std::string &geometry_shader_code,
+           const std::string &fragment_shader_code, const std::vector<std::string> &feedback_varyings);
+
     ~Shader();
 
     /*!
      * Set up the program for use in OpenGL state.
+     * Nothing is called when the program is already bound, see GLState.
      */
     void use() const;
 
@@ -43,6 +108,24 @@ namespace ppgso {
      */
     GLuint getUniformLocation(const std::string &name) const;
 
+    /*!
+     * Get a handle of the uniform "name" from the locations resolved when the program was linked.
+     * Arrays are available both by their name and by the names of their elements, e.g. "lights[2].position".
+     *
+     * @param name - Name of the shader program uniform input variable.
+     * @return - Handle for setUniform, invalid when the program does not use the uniform.
+     */
+    UniformHandle getUniform(const std::string &name) const;
+
+    /*!
+     * Attach the uniform block "name" to a uniform buffer binding point.
+     *
+     * @param name - Name of the uniform block in the shader program.
+     * @param binding - Binding point the buffer is bound to with glBindBufferRange.
+     * @return - False when the program does not use the block.
+     */
+    bool bindUniformBlock(const std::string &name, GLuint binding) const;
+
     /*!
      * Get OpenGL program identifier number.
      *
@@ -108,8 +191,156 @@ namespace ppgso {
      */
     void setUniform(const std::string &name, glm::mat3 matrix) const;
 
+    /*!
+     * Set a floating point value as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param value - Value to set input to.
+     */
+    void setUniform(UniformHandle uniform, float value) const;
+
+    /*!
+     * Set a vector as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param vector - Vector to set input to.
+     */
+    void setUniform(UniformHandle uniform, glm::vec2 vector) const;
+
+    /*!
+     * Set a vector as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param vector - Vector to set input to.
+     */
+    void setUniform(UniformHandle uniform, glm::vec3 vector) const;
+
+    /*!
+     * Set a vector as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param vector - Vector to set input to.
+     */
+    void setUniform(UniformHandle uniform, glm::vec4 vector) const;
+
+    /*!
+     * Set texture as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param texture - Texture to set input to.
+     * @param id - Texture ID to use when multi-texturing (0 is default).
+     */
+    void setUniform(UniformHandle uniform, const Texture &texture, const int id = 0) const;
+
+    /*!
+     * Set matrix as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param matrix - Matrix to set input to.
+     */
+    void setUniform(UniformHandle uniform, glm::mat4 matrix) const;
+
+    /*!
+     * Set matrix as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param matrix - Matrix to set input to.
+     */
+    void setUniform(UniformHandle uniform, glm::mat3 matrix) const;
+
+    /*!
+     * Set an integer, e.g. a texture unit of a sampler, as an input for a uniform resolved by getUniform
+     *
+     * @param uniform - Handle of the shader program uniform input variable.
+     * @param value - Value to set input to.
+     */
+    void setUniform(UniformHandle uniform, int value) const;
+
+    /*!
+     * Insert code after the #version line of a shader source, e.g. declarations shared by several programs.
+     * Defines of a variant are inserted in the same place later, so the inserted code can use them.
+     *
+     * @param code - Source of a shader.
+     * @param prefix - GLSL code to insert.
+     * @return - Source with the prefix.
+     */
+    static std::string addPrefix(const std::string &code, const std::string &prefix);
+
+    /*!
+     * Get the programs created since the start, times are in milliseconds.
+     *
+     * @return - Counters shared by all shaders.
+     */
+    static LinkStats &getLinkStats();
+
+    /*!
+     * Keep linked programs in a directory and load them from there instead of compiling them again.
+     * Binaries are found by a hash of both sources and the OpenGL vendor, renderer and version, so changing a
+     * shader or the driver creates a new one. Without driver support for program binaries the cache is not used.
+     *
+     * @param directory - Directory for the binaries, created when missing. Empty disables the cache, the default.
+     */
+    static void setBinaryCache(const std::string &directory);
+
+    /*!
+     * Get the calls counted since the last reset.
+     *
+     * @return - Counters shared by all shaders, reset them by assigning CallStats{}.
+     */
+    static CallStats &getCallStats();
+
   private:
+    /*!
+     * Compile the shaders and link them into the program, stages with empty sources are left out.
+     *
+     * @param retrievable - Ask the driver to keep the binary of the program for saveBinary.
+     */
+    void compile(const std::string &vertex_shader_code, const std::string &geometry_shader_code,
+                 const std::string &fragment_shader_code, const std::vector<std::string> &feedback_varyings,
+                 bool retrievable);
+
+    /*!
+     * Load the program from the binary cache or compile it, shared by the constructors.
+     */
+    void link(const std::string &vertex_shader_code, const std::string &geometry_shader_code,
+              const std::string &fragment_shader_code, const std::vector<std::string> &feedback_varyings);
+
+    /*!
+     * Create the program from a binary stored by saveBinary.
+     *
+     * @param path - File path of the binary.
+     * @param key - Hash the binary was saved with.
+     * @return - False when there is no usable binary and the program must be compiled.
+     */
+    bool loadBinary(const std::string &path, uint64_t key);
+
+    /*!
+     * Store the binary of the linked program, failures only disable caching of this program.
+     *
+     * @param path - File path of the binary.
+     * @param key - Hash of the sources and the driver.
+     */
+    void saveBinary(const std::string &path, uint64_t key) const;
+
+    /*!
+     * Store the locations of all active uniforms of the linked program.
+     */
+    void resolveUniforms();
+
+    GLint findUniform(const std::string &name) const;
+
+    /*!
+     * Bind the program for setting a uniform and count the call.
+     *
+     * @return - False when the uniform is not used by the program and setting it can be skipped.
+     */
+    bool prepareUniform(UniformHandle uniform) const;
+
     GLuint program;
+    std::unordered_map<std::string, GLint> uniforms;
+
+    // Directory of cached program binaries, empty when disabled
+    static std::string binaryCache;
   };
 
 }
@@ -0,0 +1,21 @@
+#include <utility>
+
+#include "shader_variants.h"
+
+ppgso::ShaderVariants::ShaderVariants(std::string vertex_shader_code, std::string fragment_shader_code,
+                                      std::function<void(Shader &)> setup)
+        : vertexCode{std::move(vertex_shader_code)}, fragmentCode{std::move(fragment_shader_code)},
+          setup{std::move(setup)} {}
+
+ppgso::Shader &ppgso::ShaderVariants::get(const ShaderDefines &defines) {
+  auto &variant = variants[defines];
+  if (!variant) {
+    variant = std::make_unique<Shader>(vertexCode, fragmentCode, defines);
+    if (setup) setup(*variant);
+  }
+  return *variant;
+}
+
+size_t ppgso::ShaderVariants::size() const {
+  return variants.size();
+}
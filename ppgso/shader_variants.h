@@ -0,0 +1,50 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "shader.h"
+
+namespace ppgso {
+
+  /*!
+   * Variants of one GLSL program specialized by preprocessor defines, compiled on the first request.
+   *
+   * Shaders select features with #if on the defines, so every variant contains only the code it runs,
+   * e.g. a loop over 4 instead of 16 lights. Variants with the same defines are compiled once and shared.
+   */
+  class ShaderVariants {
+  public:
+    /*!
+     * Keep the sources of the variants, nothing is compiled yet.
+     *
+     * @param vertex_shader_code - String containing the source of the vertex shader.
+     * @param fragment_shader_code - String containing the source of the fragment shader.
+     * @param setup - Called once for every new variant, e.g. to bind uniform blocks and samplers.
+     */
+    ShaderVariants(std::string vertex_shader_code, std::string fragment_shader_code,
+                   std::function<void(Shader &)> setup = nullptr);
+
+    /*!
+     * Get the variant compiled with the defines, compiling it when requested for the first time.
+     *
+     * @param defines - Names and values to define in both shaders.
+     * @return - Shader valid while this object exists.
+     */
+    Shader &get(const ShaderDefines &defines);
+
+    /*!
+     * Get the number of variants compiled so far.
+     *
+     * @return - Number of distinct define sets requested.
+     */
+    size_t size() const;
+
+  private:
+    std::string vertexCode, fragmentCode;
+    std::function<void(Shader &)> setup;
+    std::map<ShaderDefines, std::unique_ptr<Shader>> variants;
+  };
+
+}
@@ -1,53 +1,155 @@
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+#include "gl_state.h"
 #include "texture.h"
 
+// Number of mipmap levels reserved for every texture
+static const int MIP_LEVELS = 3;
+
 ppgso::Texture::Texture(int width, int height) : image{width, height} {
-    initGL();
+    initGL(width, height, MIP_LEVELS, GL_RGB8);
     update();
 }
 
 ppgso::Texture::Texture(Image&& image) : image{std::move(image)} {
-    initGL();
+    initGL(this->image.width, this->image.height, MIP_LEVELS, GL_RGB8);
     update();
 }
 
+ppgso::Texture::Texture(const image::MappedBMP &bmp) : image{0, 0} {
+    initGL(bmp.width, bmp.height, MIP_LEVELS, GL_RGB8);
+    upload(bmp);
+}
+
+ppgso::Texture::Texture(const TextureFile &file) : image{0, 0} {
+    upload(file);
+}
+
 ppgso::Texture::~Texture() {
+    GLState::deleteTexture(texture);
+    glDeleteTextures(1, &texture);
+}
+
+void ppgso::Texture::setImage(Image &&newImage) {
+    // Texture storage is immutable, so a new texture object is needed for the new size
+    GLState::deleteTexture(texture);
     glDeleteTextures(1, &texture);
+    image = std::move(newImage);
+    initGL(image.width, image.height, MIP_LEVELS, GL_RGB8);
+    update();
+}
+
+void ppgso::Texture::setImage(const image::MappedBMP &bmp) {
+    GLState::deleteTexture(texture);
+    glDeleteTextures(1, &texture);
+    image = Image{0, 0};
+    initGL(bmp.width, bmp.height, MIP_LEVELS, GL_RGB8);
+    upload(bmp);
 }
 
-void ppgso::Texture::initGL() {
+void ppgso::Texture::setImage(const TextureFile &file) {
+    GLState::deleteTexture(texture);
+    glDeleteTextures(1, &texture);
+    image = Image{0, 0};
+    upload(file);
+}
+
+void ppgso::Texture::initGL(int textureWidth, int textureHeight, int levels, GLenum internalFormat) {
+    width = textureWidth;
+    height = textureHeight;
+
+    byteSize = 0;
+    for (int level = 0; level < levels; level++) {
+        size_t levelWidth = std::max(width >> level, 1);
+        size_t levelHeight = std::max(height >> level, 1);
+        byteSize += levelWidth * levelHeight * sizeof(Image::Pixel);
+    }
+
     // Create new texture object
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    GLState::bindTexture(0, GL_TEXTURE_2D, texture);
 
     // Reserve texture storage
-    glTexStorage2D(GL_TEXTURE_2D, 3, GL_RGB8, image.width, image.height);
+    glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
 
     // Set up mipmapping
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-    // Update texture with data from image framebuffer
-    update();
 }
 
 void ppgso::Texture::update() {
     bind();
-    // Upload texture to GPU
+    // Upload texture to GPU, framebuffer rows are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGB, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
     // Re-generate mipmaps
     glGenerateMipmap(GL_TEXTURE_2D);
 }
 
+void ppgso::Texture::upload(const image::MappedBMP &bmp) {
+    bind();
+    // The driver converts BGR while copying, BMP rows are padded to the default 4 byte unpack alignment
+    if (bmp.isTopDown()) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, bmp.getRow(0));
+    } else {
+        // Bottom-up files are flipped once into a staging copy to keep the orientation of loadBMP
+        size_t stride = bmp.getStride();
+        std::vector<uint8_t> rows(stride * height);
+        for (int y = 0; y < height; y++)
+            std::memcpy(rows.data() + stride * y, bmp.getRow(y), stride);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, rows.data());
+    }
+
+    // Re-generate mipmaps
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void ppgso::Texture::upload(const TextureFile &file) {
+    auto &levels = file.getLevels();
+    auto format = file.getFormat();
+    GLenum compressedFormat = format == TextureFile::BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+    if (format != TextureFile::RGB8 && GLEW_EXT_texture_compression_s3tc) {
+        initGL(levels[0].width, levels[0].height, (int) levels.size(), compressedFormat);
+        // Blocks go to the GPU as they are stored, every level comes from the file
+        byteSize = 0;
+        for (size_t level = 0; level < levels.size(); level++) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint) level, 0, 0, levels[level].width, levels[level].height,
+                                      compressedFormat, (GLsizei) levels[level].size, levels[level].data);
+            byteSize += levels[level].size;
+        }
+        return;
+    }
+
+    // Uncompressed files and drivers without S3TC get plain RGB levels, the mipmaps still come from the file
+    initGL(levels[0].width, levels[0].height, (int) levels.size(), GL_RGB8);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < levels.size(); level++) {
+        if (format == TextureFile::RGB8) {
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint) level, 0, 0, levels[level].width, levels[level].height,
+                            GL_RGB, GL_UNSIGNED_BYTE, levels[level].data);
+        } else {
+            auto decoded = file.decode(level);
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint) level, 0, 0, decoded.width, decoded.height,
+                            GL_RGB, GL_UNSIGNED_BYTE, decoded.getFramebuffer().data());
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 void ppgso::Texture::bind(int id) const {
-    glActiveTexture((GLenum) (GL_TEXTURE0 + id));
-    glBindTexture(GL_TEXTURE_2D, texture);
+    GLState::bindTexture((GLuint) id, GL_TEXTURE_2D, texture);
 }
 
 GLuint ppgso::Texture::getTexture() {
     return texture;
-}
\ No newline at end of file
+}
+size_t ppgso::Texture::getByteSize() const {
+    return byteSize;
+}
@@ -7,6 +7,8 @@
 #include <GL/glew.h>
 
 #include "image.h"
+#include "image_bmp.h"
+#include "texture_file.h"
 
 namespace ppgso {
 
@@ -28,8 +30,45 @@ namespace ppgso {
          */
         Texture(Image&& image);
 
+        /*!
+         * Load straight from a mapped BMP file. The BGR rows are uploaded without converting them on the CPU,
+         * the image of such texture stays empty.
+         *
+         * @param bmp - Mapped BMP image to use
+         */
+        Texture(const image::MappedBMP &bmp);
+
+        /*!
+         * Load from a .pptex file with precomputed mipmaps. Compressed levels are uploaded as they are stored,
+         * the image of such texture stays empty.
+         *
+         * @param file - Mapped texture file to use
+         */
+        Texture(const TextureFile &file);
+
         ~Texture();
 
+        /*!
+         * Replace the image with one of a different size and reallocate the OpenGL texture storage.
+         *
+         * @param newImage - Image to use
+         */
+        void setImage(Image &&newImage);
+
+        /*!
+         * Replace the image with a mapped BMP file, the image of the texture becomes empty.
+         *
+         * @param bmp - Mapped BMP image to use
+         */
+        void setImage(const image::MappedBMP &bmp);
+
+        /*!
+         * Replace the image with a .pptex file, the image of the texture becomes empty.
+         *
+         * @param file - Mapped texture file to use
+         */
+        void setImage(const TextureFile &file);
+
         /*!
          * Update the OpenGL texture in memory.
          */
@@ -49,9 +88,20 @@ namespace ppgso {
          */
         void bind(int id = 0) const;
 
+        /*!
+         * Get the size of the texture storage including mipmaps.
+         *
+         * @return - Size in bytes.
+         */
+        size_t getByteSize() const;
+
         Image image;
     private:
-        void initGL();
+        void initGL(int textureWidth, int textureHeight, int levels, GLenum internalFormat);
+        void upload(const image::MappedBMP &bmp);
+        void upload(const TextureFile &file);
         GLuint texture;
+        int width = 0, height = 0;
+        size_t byteSize = 0;
     };
 }
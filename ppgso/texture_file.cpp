@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "texture_file.h"
+#include "image_bc.h"
+
+namespace {
+  const char MAGIC[4] = {'P', 'P', 'T', 'X'};
+
+  // 1x1 is reached in at most 32 halvings of a 32 bit size
+  const uint32_t MAX_LEVELS = 32;
+
+  struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t levelCount;
+  };
+
+  struct LevelHeader {
+    uint32_t width;
+    uint32_t height;
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  size_t getLevelSize(ppgso::TextureFile::Format format, int width, int height) {
+    switch (format) {
+      case ppgso::TextureFile::BC1:
+        return ppgso::image::getBlockCompressedSize(width, height, 8);
+      case ppgso::TextureFile::BC3:
+        return ppgso::image::getBlockCompressedSize(width, height, 16);
+      default:
+        return (size_t) width * height * sizeof(ppgso::Image::Pixel);
+    }
+  }
+}
+
+ppgso::TextureFile::TextureFile(const std::string &path) : file{path} {
+  auto fail = [&path](const char *reason) {
+    std::stringstream msg;
+    msg << "Invalid texture file " << path << ": " << reason;
+    throw std::runtime_error(msg.str());
+  };
+
+  auto data = file.data();
+  auto size = file.size();
+  if (size < sizeof(FileHeader))
+    fail("truncated header");
+
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    fail("bad magic");
+  if (header.version != VERSION)
+    fail("unsupported version");
+  if (header.format > BC3)
+    fail("unknown format");
+  if (header.levelCount == 0 || header.levelCount > MAX_LEVELS)
+    fail("bad level count");
+  if (header.levelCount > (size - sizeof(FileHeader)) / sizeof(LevelHeader))
+    fail("truncated level table");
+  format = (Format) header.format;
+
+  levels.reserve(header.levelCount);
+  for (uint32_t i = 0; i < header.levelCount; i++) {
+    LevelHeader entry;
+    std::memcpy(&entry, data + sizeof(FileHeader) + i * sizeof(LevelHeader), sizeof(entry));
+
+    if (entry.width == 0 || entry.height == 0 || entry.width > INT32_MAX || entry.height > INT32_MAX)
+      fail("bad level size");
+    // The chain has to match what glTexStorage2D allocates, each level half of the previous one
+    if (i > 0 && ((int) entry.width != std::max(levels.back().width / 2, 1) ||
+                  (int) entry.height != std::max(levels.back().height / 2, 1)))
+      fail("incomplete mipmap chain");
+    if (entry.offset > size || entry.size > size - entry.offset)
+      fail("data out of bounds");
+    if (entry.size != getLevelSize(format, entry.width, entry.height))
+      fail("level size does not match format");
+
+    levels.push_back({(int) entry.width, (int) entry.height, data + entry.offset, entry.size});
+  }
+
+  if (levels.back().width != 1 || levels.back().height != 1)
+    fail("incomplete mipmap chain");
+}
+
+ppgso::TextureFile::Format ppgso::TextureFile::getFormat() const {
+  return format;
+}
+
+const std::vector<ppgso::TextureFile::Level> &ppgso::TextureFile::getLevels() const {
+  return levels;
+}
+
+void ppgso::TextureFile::prefault() const {
+  file.prefault();
+}
+
+ppgso::Image ppgso::TextureFile::decode(size_t level) const {
+  auto &entry = levels.at(level);
+  switch (format) {
+    case BC1:
+      return image::decompressBC1(entry.data, entry.width, entry.height);
+    case BC3:
+      return image::decompressBC3(entry.data, entry.width, entry.height);
+    default: {
+      Image result{entry.width, entry.height};
+      std::memcpy(result.getFramebuffer().data(), entry.data, entry.size);
+      return result;
+    }
+  }
+}
+
+void ppgso::TextureFile::save(const std::string &path, Format format, const std::vector<Image> &levels) {
+  FileHeader header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.format = format;
+  header.levelCount = (uint32_t) levels.size();
+
+  // Encode every level and lay them out one after another behind the level table
+  std::vector<std::vector<uint8_t>> encoded;
+  std::vector<LevelHeader> table(levels.size());
+  size_t offset = sizeof(FileHeader) + levels.size() * sizeof(LevelHeader);
+  for (size_t i = 0; i < levels.size(); i++) {
+    auto &level = levels[i];
+    switch (format) {
+      case BC1:
+        encoded.push_back(image::compressBC1(level));
+        break;
+      case BC3:
+        encoded.push_back(image::compressBC3(level));
+        break;
+      default: {
+        auto pixels = reinterpret_cast<const uint8_t *>(level.getFramebuffer().data());
+        encoded.emplace_back(pixels, pixels + level.getFramebuffer().size() * sizeof(Image::Pixel));
+        break;
+      }
+    }
+
+    table[i].width = (uint32_t) level.width;
+    table[i].height = (uint32_t) level.height;
+    table[i].offset = (uint32_t) offset;
+    table[i].size = (uint32_t) encoded.back().size();
+    offset += encoded.back().size();
+  }
+  if (offset > UINT32_MAX) {
+    std::stringstream msg;
+    msg << "Texture too large for " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  if (!out) {
+    std::stringstream msg;
+    msg << "Could not write file " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(LevelHeader));
+  for (auto &data : encoded)
+    out.write(reinterpret_cast<const char *>(data.data()), data.size());
+
+  if (!out) {
+    std::stringstream msg;
+    msg << "Could not write file " << path;
+    throw std::runtime_error(msg.str());
+  }
+}
+
+std::string ppgso::TextureFile::getBinaryPath(const std::string &bmp) {
+  auto dot = bmp.find_last_of('.');
+  auto slash = bmp.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return bmp + ".pptex";
+  return bmp.substr(0, dot) + ".pptex";
+}
+
+bool ppgso::TextureFile::isUpToDate(const std::string &bmp) {
+  auto binaryTime = MappedFile::getModificationTime(getBinaryPath(bmp));
+  return binaryTime != 0 && binaryTime >= MappedFile::getModificationTime(bmp);
+}
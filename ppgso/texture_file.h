@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "mapped_file.h"
+
+namespace ppgso {
+
+  /*!
+   * Binary .pptex file holding a texture with its complete mipmap chain, optionally block compressed.
+   *
+   * The file starts with a header followed by one table entry per mipmap level with its size and the byte offset
+   * of its data. Level data can be passed to glCompressedTexSubImage2D directly from the memory mapping, so loading
+   * the texture needs neither decoding nor glGenerateMipmap. Rows are stored from the top of the image like in
+   * ppgso::Image.
+   */
+  class TextureFile {
+  public:
+    static const unsigned int VERSION = 1;
+
+    enum Format : uint32_t {
+      RGB8 = 0, // Uncompressed tightly packed RGB
+      BC1 = 1,  // DXT1 blocks, 8 bytes per 4x4 pixels
+      BC3 = 2   // DXT5 blocks with opaque alpha, 16 bytes per 4x4 pixels
+    };
+
+    struct Level {
+      int width, height;
+      const uint8_t *data;
+      size_t size;
+    };
+
+    /*!
+     * Map a .pptex file into memory and validate its layout.
+     *
+     * @param path - File path to the .pptex file.
+     */
+    explicit TextureFile(const std::string &path);
+
+    /*!
+     * Get the format of all levels.
+     *
+     * @return - Pixel format of the file.
+     */
+    Format getFormat() const;
+
+    /*!
+     * Get the mipmap levels stored in the file, the first one is the full size texture.
+     *
+     * @return - Levels pointing into the mapped file, valid while this object exists.
+     */
+    const std::vector<Level> &getLevels() const;
+
+    /*!
+     * Read the level data once, so later accesses do not wait for the disk.
+     */
+    void prefault() const;
+
+    /*!
+     * Decode a level into an image, used where the GPU cannot sample the compressed format.
+     *
+     * @param level - Index of the mipmap level.
+     * @return - Decoded level.
+     */
+    Image decode(size_t level) const;
+
+    /*!
+     * Encode mipmap levels and write them into a .pptex file.
+     *
+     * @param path - File path to write.
+     * @param format - Format to encode the levels with.
+     * @param levels - Complete mipmap chain as produced by image::generateMipmaps.
+     */
+    static void save(const std::string &path, Format format, const std::vector<Image> &levels);
+
+    /*!
+     * Get the path of the binary file belonging to a BMP file.
+     *
+     * @param bmp - File path to the BMP file.
+     * @return - The same path with the .pptex extension.
+     */
+    static std::string getBinaryPath(const std::string &bmp);
+
+    /*!
+     * Check whether the binary file exists and is not older than the BMP file.
+     *
+     * @param bmp - File path to the BMP file.
+     * @return - True when the binary file can be used instead of the BMP file.
+     */
+    static bool isUpToDate(const std::string &bmp);
+
+  private:
+    MappedFile file;
+    Format format;
+    std::vector<Level> levels;
+  };
+
+}
@@ -5,6 +5,7 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "gl_state.h"
 #include "window.h"
 
 bool ppgso::Window::pollEvents() {
@@ -78,7 +79,9 @@ void ppgso::Window::glfw_error_callback(int error, const char *description) {
 void ppgso::Window::resetViewport() {
   int fbWidth, fbHeight;
   glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
-  glViewport(0, 0, fbWidth, fbHeight);
+  // Callers render to their own framebuffers and viewports directly, so nothing cached can be trusted
+  GLState::invalidate();
+  GLState::viewport(0, 0, fbWidth, fbHeight);
 }
 
 void ppgso::Window::showCursor() {
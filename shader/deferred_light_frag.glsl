@@ -0,0 +1,168 @@
+#version 330
+
+// Lighting pass of the deferred path, a fullscreen quad drawn with quad_vert.glsl into the HDR scene target.
+// Lights the G-buffer with the sun, its shadow map and the point lights of the cluster of every pixel, with
+// the same terms as scene_frag.glsl so both paths give the same image.
+
+// Five texels of the LightData buffer texture, see LightClusters
+struct PointLight {
+    // radius the light reaches in w
+    vec4 position;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    // constant, linear and quadratic attenuation
+    vec4 attenuation;
+};
+
+// Set by DeferredShading from LightClusters, the loop covers the fullest cluster
+#ifndef MAX_CLUSTER_LIGHTS
+#define MAX_CLUSTER_LIGHTS 32
+#endif
+#ifndef CLUSTER_TILES_X
+#define CLUSTER_TILES_X 16
+#endif
+#ifndef CLUSTER_TILES_Y
+#define CLUSTER_TILES_Y 9
+#endif
+#ifndef CLUSTER_SLICES
+#define CLUSTER_SLICES 24
+#endif
+// Width of the percentage-closer filter kernel in texels
+#define PCF 3
+// FrameData block of frame_data.glsl and the CASCADES define, inserted by FrameUniforms::declare
+
+// G-buffer written by gbuffer_frag.glsl
+uniform sampler2D GBufferAlbedo;
+uniform sampler2D GBufferNormal;
+uniform sampler2D GBufferDepth;
+uniform mat4 InverseViewProjection;
+
+uniform sampler2DArrayShadow ShadowMap;
+uniform samplerBuffer LightData;
+uniform usamplerBuffer ClusterRanges;
+uniform usamplerBuffer LightIndices;
+
+in vec2 TexCoords;
+
+out vec4 FragmentColor;
+
+PointLight FetchPointLight(int index);
+int FindCluster(vec3 fragPos);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor,
+                    float shininess, float specularLevel);
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir);
+
+void main() {
+    // Pixels without geometry keep the far depth, the sky is drawn there later
+    float depth = texture(GBufferDepth, TexCoords).r;
+    if (depth >= 1.0) discard;
+
+    vec4 world = InverseViewProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+    vec4 albedo = texture(GBufferAlbedo, TexCoords);
+    vec4 normalMaterial = texture(GBufferNormal, TexCoords);
+
+    vec3 norm = normalize(normalMaterial.xyz);
+    vec3 texColor = albedo.rgb;
+    float materialId = round(normalMaterial.w);
+    float shininess = floor(materialId / 16.0);
+    float specularLevel = mod(materialId, 16.0) / 15.0;
+    vec3 viewDir = normalize(ViewPosition.xyz - fragPos);
+
+    vec3 ambient = SunAmbient.xyz * texColor;
+    vec3 dirLightDir = normalize(-SunDirection.xyz);
+    float diff = max(dot(norm, dirLightDir), 0.0);
+    vec3 diffuse = SunDiffuse.xyz * diff * texColor;
+    vec3 reflectDir = reflect(-dirLightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = SunSpecular.xyz * spec * specularLevel;
+
+    // Screen tile and depth slice of the pixel, the nearest lights of the cluster come first
+    uvec2 range = texelFetch(ClusterRanges, FindCluster(fragPos)).xy;
+    for (int i = 0; i < MAX_CLUSTER_LIGHTS; i++) {
+        if (i >= int(range.y)) break;
+        PointLight light = FetchPointLight(int(texelFetch(LightIndices, int(range.x) + i).r));
+        vec3 pointLightContribution = CalcPointLight(light, norm, fragPos, viewDir, texColor,
+                                                     shininess, specularLevel);
+        ambient += pointLightContribution * light.ambient.xyz;
+        diffuse += pointLightContribution * light.diffuse.xyz;
+        specular += pointLightContribution * light.specular.xyz;
+    }
+
+    float shadow = albedo.a > 0.5 ? ShadowCalculation(fragPos, norm, dirLightDir) : 0.0;
+
+    // combine lighting
+    vec3 result = texColor * (ambient + (diffuse + specular) * (1.0 - shadow));
+
+    FragmentColor = vec4(result, 1.0);
+}
+
+// Shadowed fraction of the fragment in the cascade covering its view depth, 0 is fully lit
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir) {
+    float viewDepth = -(ViewMatrix * vec4(fragPos, 1.0)).z;
+    int cascade = int(dot(vec4(greaterThan(vec4(viewDepth), CascadeSplits)), vec4(1.0)));
+    if (cascade >= CASCADES) return 0.0;
+
+    vec4 fragPosLightSpace = CascadeMatrices[cascade] * vec4(fragPos, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = projCoords * 0.5 + 0.5; // Transform to [0, 1] range
+
+    // nothing was drawn into the map outside of the volume of the cascade
+    if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
+        return 0.0;
+
+    // bias for reducing shadow acne, about one texel of the cascade
+    float bias = max(CascadeBias[cascade] * (1.0 - dot(normal, lightDir)), CascadeBias[cascade]);
+
+    // percentage-closer filtering over PCF x PCF texels, every lookup is 1 where the fragment is lit
+    const int radius = PCF / 2;
+    float lit = 0.0;
+    vec2 texelSize = 1.0 / vec2(textureSize(ShadowMap, 0).xy);
+    for (int x = -radius; x <= radius; ++x) {
+        for (int y = -radius; y <= radius; ++y) {
+            lit += texture(ShadowMap, vec4(projCoords.xy + vec2(x, y) * texelSize, cascade, projCoords.z - bias));
+        }
+    }
+
+    return 1.0 - lit / float(PCF * PCF);
+}
+
+PointLight FetchPointLight(int index) {
+    int texel = index * 5;
+    return PointLight(texelFetch(LightData, texel), texelFetch(LightData, texel + 1),
+                      texelFetch(LightData, texel + 2), texelFetch(LightData, texel + 3),
+                      texelFetch(LightData, texel + 4));
+}
+
+// Tile of the position on screen and exponential slice of its view space depth, the same as LightClusters
+int FindCluster(vec3 fragPos) {
+    vec4 clip = ProjectionMatrix * ViewMatrix * vec4(fragPos, 1.0);
+    vec2 tiles = vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y);
+    ivec2 tile = ivec2(clamp((clip.xy / clip.w * 0.5 + 0.5) * tiles, vec2(0.0), tiles - 1.0));
+    // w of a perspective projection is the depth in front of the camera
+    int slice = int(clamp(log(max(clip.w, 1e-4)) * ClusterSlices.x + ClusterSlices.y, 0.0, CLUSTER_SLICES - 1.0));
+    return (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
+
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor,
+                    float shininess, float specularLevel) {
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // attenuation
+    float distance = length(light.position.xyz - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+                               light.attenuation.z * (distance * distance));
+    // fades to zero at the radius, lights are assigned only to the clusters within it
+    float falloff = clamp(1.0 - pow(distance / light.position.w, 4.0), 0.0, 1.0);
+    attenuation *= falloff * falloff;
+    // combine results
+    vec3 ambient = light.ambient.xyz * texColor;
+    vec3 diffuse = light.diffuse.xyz * diff * texColor;
+    vec3 specular = light.specular.xyz * spec * specularLevel;
+    return (ambient + diffuse + specular) * attenuation;
+}
@@ -2,9 +2,29 @@
 
 layout(location = 0) in vec3 Position;
 
-uniform mat4 LightSpaceMatrix;
+// Dequantization of packed meshes set by ppgso::MeshBase, PackedVertices is 0 for float vertices
+layout(location = 3) in vec3 PositionScale;
+layout(location = 4) in vec3 PositionOffset;
+layout(location = 6) in float PackedVertices;
+
+// FrameData block of frame_data.glsl, inserted by FrameUniforms::declare
+
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+
+#if INSTANCED
+// Model matrix of the instance set by ppgso::MeshBase::renderInstanced
+layout(location = 7) in mat4 InstanceMatrix;
+#define ModelMatrix InstanceMatrix
+#else
 uniform mat4 ModelMatrix;
+#endif
+
+// Shadow cascade the depth pass is drawing, set once per cascade, selects its light space from CascadeMatrices
+uniform int Cascade;
 
 void main() {
-    gl_Position = LightSpaceMatrix * ModelMatrix * vec4(Position, 1.0);
+    vec3 position = PackedVertices != 0.0 ? Position * PositionScale + PositionOffset : Position;
+    gl_Position = CascadeMatrices[Cascade] * ModelMatrix * vec4(position, 1.0);
 }
@@ -0,0 +1,16 @@
+// Per frame data shared by all programs, binding point 0. Inserted after the #version line by
+// FrameUniforms::declare together with the CASCADES define of ShadowCascades, the layout must match the FrameData
+// struct of frame_uniforms.h.
+layout(std140) uniform FrameData {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec4 ViewPosition;
+    vec4 SunDirection;
+    vec4 SunAmbient;
+    vec4 SunDiffuse;
+    vec4 SunSpecular;
+    vec4 ClusterSlices;
+    mat4 CascadeMatrices[CASCADES];
+    vec4 CascadeSplits;
+    vec4 CascadeBias;
+};
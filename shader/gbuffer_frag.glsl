@@ -0,0 +1,40 @@
+#version 330
+
+// Geometry pass of the deferred path, drawn with scene_vert.glsl. Writes what deferred_light_frag.glsl needs
+// to light the fragment the same way scene_frag.glsl does.
+
+struct Material {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+// Variant defines inserted by ppgso::Shader
+// SHADOWS - The object receives shadows from the sun: 0 or 1
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+
+uniform sampler2D Texture;
+uniform Material material;
+
+in vec2 texCoord;
+in vec3 FragPos;
+in vec3 NormalDir;
+
+// RGBA8: texture color times the diffuse material, 1 in alpha when the fragment receives shadows
+layout(location = 0) out vec4 GBufferAlbedo;
+// RGBA16F: world space normal, the material packed into one ID in w
+layout(location = 1) out vec4 GBufferNormal;
+
+void main() {
+    // Objects use the same ambient and diffuse material, the lighting pass applies the albedo to both
+    vec3 texColor = texture(Texture, texCoord).rgb * material.diffuse;
+    GBufferAlbedo = vec4(texColor, SHADOWS);
+
+    // Material ID is shininess * 16 + specular level 0..15, an integer below 2048 is exact in a half float
+    float shininess = clamp(round(material.shininess), 1.0, 127.0);
+    float specular = round(clamp(dot(material.specular, vec3(1.0 / 3.0)), 0.0, 1.0) * 15.0);
+    GBufferNormal = vec4(normalize(NormalDir), shininess * 16.0 + specular);
+}
@@ -0,0 +1,31 @@
+#version 330
+
+// Compaction of the culled instances, transform feedback captures the model matrices of the visible ones
+layout(points) in;
+layout(points, max_vertices = 1) out;
+
+in vec4 modelColumn0[];
+in vec4 modelColumn1[];
+in vec4 modelColumn2[];
+in vec4 modelColumn3[];
+flat in int visible[];
+flat in int lod[];
+
+// Every level of detail is captured into its own buffer by a separate draw
+uniform int Lod;
+
+out vec4 outModelColumn0;
+out vec4 outModelColumn1;
+out vec4 outModelColumn2;
+out vec4 outModelColumn3;
+
+void main() {
+  if (visible[0] == 0 || lod[0] != Lod) return;
+
+  outModelColumn0 = modelColumn0[0];
+  outModelColumn1 = modelColumn1[0];
+  outModelColumn2 = modelColumn2[0];
+  outModelColumn3 = modelColumn3[0];
+  EmitVertex();
+  EndPrimitive();
+}
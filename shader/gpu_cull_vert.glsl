@@ -0,0 +1,41 @@
+#version 330
+
+// Instance of a static object culled on the GPU, see GpuCulling
+layout(location = 0) in vec4 ModelColumn0;
+layout(location = 1) in vec4 ModelColumn1;
+layout(location = 2) in vec4 ModelColumn2;
+layout(location = 3) in vec4 ModelColumn3;
+// Bounding sphere in world space, center and radius
+layout(location = 4) in vec4 Sphere;
+
+// Planes of the culling volume with normals pointing inside, see Frustum
+uniform vec4 Planes[6];
+// Levels of detail are picked by the camera in both passes, like LodSelector does without hysteresis
+uniform vec3 CameraPosition;
+uniform float ProjectionScale;
+uniform vec4 LodThresholds;
+uniform int LodCount;
+
+out vec4 modelColumn0;
+out vec4 modelColumn1;
+out vec4 modelColumn2;
+out vec4 modelColumn3;
+flat out int visible;
+flat out int lod;
+
+void main() {
+  modelColumn0 = ModelColumn0;
+  modelColumn1 = ModelColumn1;
+  modelColumn2 = ModelColumn2;
+  modelColumn3 = ModelColumn3;
+
+  visible = 1;
+  for (int plane = 0; plane < 6; plane++) {
+    if (dot(Planes[plane].xyz, Sphere.xyz) + Planes[plane].w < -Sphere.w) visible = 0;
+  }
+
+  // Radius projected to normalized device coordinates, 1 covers half the viewport height
+  float projected = Sphere.w * ProjectionScale / max(length(Sphere.xyz - CameraPosition), 0.001);
+  lod = 0;
+  while (lod + 1 < LodCount && projected < LodThresholds[lod + 1]) lod++;
+}
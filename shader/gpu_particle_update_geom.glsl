@@ -0,0 +1,70 @@
+#version 330
+
+// One step of the particle simulation, the outputs are captured with transform feedback
+layout(points) in;
+layout(points, max_vertices = 64) out;
+
+in vec4 positionAge[];
+in vec4 velocityLifetime[];
+in vec4 colorType[];
+
+out vec4 outPositionAge;
+out vec4 outVelocityLifetime;
+out vec4 outColorType;
+
+// Type stored in ColorType.w
+const float RAIN = 0.0;
+const float SPLASH = 1.0;
+
+// Splashes of one drop, limited by the output components a geometry shader may emit
+const int SPLASHES_PER_DROP = 64;
+
+uniform float DeltaTime;
+uniform vec3 Wind;
+uniform vec3 Gravity;
+uniform float Floor;
+uniform int Frame;
+
+// Integer hash, the same particle gets different numbers every frame
+float random(uint seed) {
+  seed ^= seed >> 16;
+  seed *= 0x7feb352dU;
+  seed ^= seed >> 15;
+  seed *= 0x846ca68bU;
+  seed ^= seed >> 16;
+  return float(seed) / 4294967295.0;
+}
+
+void emit(vec3 position, float age, vec3 velocity, float lifetime, vec4 color) {
+  outPositionAge = vec4(position, age);
+  outVelocityLifetime = vec4(velocity, lifetime);
+  outColorType = color;
+  EmitVertex();
+  EndPrimitive();
+}
+
+void main() {
+  vec3 position = positionAge[0].xyz;
+  vec3 velocity = velocityLifetime[0].xyz;
+  float age = positionAge[0].w + DeltaTime;
+  float lifetime = velocityLifetime[0].w;
+  bool rain = colorType[0].w == RAIN;
+
+  // Drops are pushed by the wind, splashes fall
+  velocity += (rain ? Wind : Gravity) * DeltaTime;
+  position += velocity * DeltaTime;
+
+  // A drop that hit the ground is replaced by its splashes
+  if (rain && position.y < Floor) {
+    uint seed = uint(gl_PrimitiveIDIn) * 7919U + uint(Frame) * 104729U;
+    for (int i = 0; i < SPLASHES_PER_DROP; i++) {
+      float angle = random(seed + uint(2 * i)) * 6.2831853;
+      float speed = mix(0.1, 0.5, random(seed + uint(2 * i + 1)));
+      emit(position, 0.0, vec3(cos(angle), 0.5, sin(angle)) * speed, 1.0, vec4(colorType[0].rgb, SPLASH));
+    }
+    return;
+  }
+
+  if (age < lifetime)
+    emit(position, age, velocity, lifetime, colorType[0]);
+}
@@ -0,0 +1,17 @@
+#version 330
+
+// Particle state captured by the previous update or spawned on the CPU, see GpuParticleSystem
+layout(location = 0) in vec4 PositionAge;
+layout(location = 1) in vec4 VelocityLifetime;
+layout(location = 2) in vec4 ColorType;
+
+out vec4 positionAge;
+out vec4 velocityLifetime;
+out vec4 colorType;
+
+void main() {
+  // The simulation runs in the geometry shader, which can drop particles and emit new ones
+  positionAge = PositionAge;
+  velocityLifetime = VelocityLifetime;
+  colorType = ColorType;
+}
@@ -0,0 +1,24 @@
+#version 330
+
+// Particle state written by the transform feedback update, drawn without leaving the GPU
+layout(location = 0) in vec4 PositionAge;
+layout(location = 1) in vec4 VelocityLifetime;
+layout(location = 2) in vec4 ColorType;
+
+// FrameData block of frame_data.glsl, inserted by FrameUniforms::declare
+
+// Radius of a new particle in world units and pixels covered by one world unit at distance 1
+uniform float Radius;
+uniform float PixelScale;
+
+out vec3 vertexColor;
+
+void main() {
+  vec4 viewPosition = ViewMatrix * vec4(PositionAge.xyz, 1.0);
+  gl_Position = ProjectionMatrix * viewPosition;
+
+  // Particles shrink as they age, an infinite lifetime keeps the full size
+  float radius = Radius * (1.0 - clamp(PositionAge.w / VelocityLifetime.w, 0.0, 1.0));
+  gl_PointSize = max(2.0 * radius * PixelScale / max(-viewPosition.z, 0.001), 1.0);
+  vertexColor = ColorType.rgb;
+}
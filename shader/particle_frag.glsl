@@ -0,0 +1,12 @@
+#version 330
+in vec3 vertexColor;
+
+// The final color
+out vec4 FragmentColor;
+
+void main() {
+  // Round sprites, the corners of the point square are dropped
+  vec2 offset = gl_PointCoord * 2.0 - 1.0;
+  if (dot(offset, offset) > 1.0) discard;
+  FragmentColor = vec4(vertexColor, 1.0);
+}
@@ -0,0 +1,29 @@
+#version 330
+
+// One point sprite per particle, every attribute comes from its own array of the particle pool
+layout(location = 0) in float X;
+layout(location = 1) in float Y;
+layout(location = 2) in float Z;
+layout(location = 3) in float Red;
+layout(location = 4) in float Green;
+layout(location = 5) in float Blue;
+layout(location = 6) in float Age;
+layout(location = 7) in float Lifetime;
+
+// FrameData block of frame_data.glsl, inserted by FrameUniforms::declare
+
+// Radius of a new particle in world units and pixels covered by one world unit at distance 1
+uniform float Radius;
+uniform float PixelScale;
+
+out vec3 vertexColor;
+
+void main() {
+  vec4 viewPosition = ViewMatrix * vec4(X, Y, Z, 1.0);
+  gl_Position = ProjectionMatrix * viewPosition;
+
+  // Particles shrink as they age, an infinite lifetime keeps the full size
+  float radius = Radius * (1.0 - clamp(Age / Lifetime, 0.0, 1.0));
+  gl_PointSize = max(2.0 * radius * PixelScale / max(-viewPosition.z, 0.001), 1.0);
+  vertexColor = vec3(Red, Green, Blue);
+}
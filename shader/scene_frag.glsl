@@ -0,0 +1,193 @@
+#version 330
+
+struct Material {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+// Five texels of the LightData buffer texture, see LightClusters
+struct PointLight {
+    // radius the light reaches in w
+    vec4 position;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    // constant, linear and quadratic attenuation
+    vec4 attenuation;
+};
+
+// Variant defines inserted by ppgso::Shader, the defaults give the most expensive variant
+// POINT_LIGHTS - Point lights of the cluster evaluated per fragment at most: 0, 4, 8, 16 or 32
+// SHADOWS - Sample the shadow map: 0 or 1
+// PCF - Width of the percentage-closer filter kernel in texels: 1, 3 or 5
+#ifndef POINT_LIGHTS
+#define POINT_LIGHTS 32
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+#ifndef PCF
+#define PCF 3
+#endif
+// Clusters on screen and in depth, set by SceneShader from LightClusters
+#ifndef CLUSTER_TILES_X
+#define CLUSTER_TILES_X 16
+#endif
+#ifndef CLUSTER_TILES_Y
+#define CLUSTER_TILES_Y 9
+#endif
+#ifndef CLUSTER_SLICES
+#define CLUSTER_SLICES 24
+#endif
+// FrameData block of frame_data.glsl and the CASCADES define, inserted by FrameUniforms::declare
+
+uniform sampler2D Texture;
+#if SHADOWS
+uniform sampler2DArrayShadow ShadowMap;
+#endif
+#if POINT_LIGHTS > 0
+// All lights in the view, offset and count of the lights of every cluster in LightIndices, and the indices
+uniform samplerBuffer LightData;
+uniform usamplerBuffer ClusterRanges;
+uniform usamplerBuffer LightIndices;
+#endif
+
+uniform Material material;
+
+in vec2 texCoord;
+in vec3 FragPos;
+in vec3 NormalDir;
+
+out vec4 FragmentColor;
+
+#if POINT_LIGHTS > 0
+PointLight FetchPointLight(int index);
+int FindCluster(vec3 fragPos);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor);
+#endif
+#if SHADOWS
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir);
+#endif
+
+void main() {
+    vec3 norm = normalize(NormalDir);
+    vec3 viewDir = normalize(ViewPosition.xyz - FragPos);
+    vec3 texColor = texture(Texture, texCoord).rgb;
+
+    vec3 ambient = vec3(0.0);
+    vec3 diffuse = vec3(0.0);
+    vec3 specular = vec3(0.0);
+
+    vec3 dirAmbient = SunAmbient.xyz * texColor * material.ambient;
+    vec3 dirLightDir = normalize(-SunDirection.xyz);
+    float diff = max(dot(norm, dirLightDir), 0.0);
+    vec3 dirDiffuse = SunDiffuse.xyz * diff * texColor * material.diffuse;
+    vec3 reflectDir = reflect(-dirLightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 dirSpecular = SunSpecular.xyz * spec * material.specular;
+
+    ambient += dirAmbient;
+    diffuse += dirDiffuse;
+    specular += dirSpecular;
+
+#if POINT_LIGHTS > 0
+    // Only the lights overlapping the cluster of the fragment, the nearest ones come first
+    uvec2 range = texelFetch(ClusterRanges, FindCluster(FragPos)).xy;
+    for (int i = 0; i < POINT_LIGHTS; i++) {
+        if (i >= int(range.y)) break;
+        PointLight light = FetchPointLight(int(texelFetch(LightIndices, int(range.x) + i).r));
+        vec3 pointLightContribution = CalcPointLight(light, norm, FragPos, viewDir, texColor);
+        ambient += pointLightContribution * light.ambient.xyz;
+        diffuse += pointLightContribution * light.diffuse.xyz;
+        specular += pointLightContribution * light.specular.xyz;
+    }
+#endif
+
+#if SHADOWS
+    float shadow = ShadowCalculation(FragPos, norm, dirLightDir);
+#else
+    float shadow = 0.0;
+#endif
+
+    // combine lighting
+    vec3 result = texColor * (ambient + (diffuse + specular) * (1.0 - shadow));
+
+    FragmentColor = vec4(result, 1.0);
+}
+
+#if SHADOWS
+// Shadowed fraction of the fragment in the cascade covering its view depth, 0 is fully lit
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir) {
+    float viewDepth = -(ViewMatrix * vec4(fragPos, 1.0)).z;
+    int cascade = int(dot(vec4(greaterThan(vec4(viewDepth), CascadeSplits)), vec4(1.0)));
+    if (cascade >= CASCADES) return 0.0;
+
+    vec4 fragPosLightSpace = CascadeMatrices[cascade] * vec4(fragPos, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = projCoords * 0.5 + 0.5; // Transform to [0, 1] range
+
+    // nothing was drawn into the map outside of the volume of the cascade
+    if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
+        return 0.0;
+
+    // bias for reducing shadow acne, about one texel of the cascade
+    float bias = max(CascadeBias[cascade] * (1.0 - dot(normal, lightDir)), CascadeBias[cascade]);
+
+    // percentage-closer filtering over PCF x PCF texels, every lookup is 1 where the fragment is lit
+    const int radius = PCF / 2;
+    float lit = 0.0;
+    vec2 texelSize = 1.0 / vec2(textureSize(ShadowMap, 0).xy);
+    for (int x = -radius; x <= radius; ++x) {
+        for (int y = -radius; y <= radius; ++y) {
+            lit += texture(ShadowMap, vec4(projCoords.xy + vec2(x, y) * texelSize, cascade, projCoords.z - bias));
+        }
+    }
+
+    return 1.0 - lit / float(PCF * PCF);
+}
+#endif
+
+#if POINT_LIGHTS > 0
+PointLight FetchPointLight(int index) {
+    int texel = index * 5;
+    return PointLight(texelFetch(LightData, texel), texelFetch(LightData, texel + 1),
+                      texelFetch(LightData, texel + 2), texelFetch(LightData, texel + 3),
+                      texelFetch(LightData, texel + 4));
+}
+
+// Tile of the position on screen and exponential slice of its view space depth, the same as LightClusters
+int FindCluster(vec3 fragPos) {
+    vec4 clip = ProjectionMatrix * ViewMatrix * vec4(fragPos, 1.0);
+    vec2 tiles = vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y);
+    ivec2 tile = ivec2(clamp((clip.xy / clip.w * 0.5 + 0.5) * tiles, vec2(0.0), tiles - 1.0));
+    // w of a perspective projection is the depth in front of the camera
+    int slice = int(clamp(log(max(clip.w, 1e-4)) * ClusterSlices.x + ClusterSlices.y, 0.0, CLUSTER_SLICES - 1.0));
+    return (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
+
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor) {
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    // attenuation
+    float distance = length(light.position.xyz - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+                               light.attenuation.z * (distance * distance));
+    // fades to zero at the radius, lights are assigned only to the clusters within it
+    float falloff = clamp(1.0 - pow(distance / light.position.w, 4.0), 0.0, 1.0);
+    attenuation *= falloff * falloff;
+    // combine results
+    vec3 ambient = light.ambient.xyz * texColor * material.ambient;
+    vec3 diffuse = light.diffuse.xyz * diff * texColor * material.diffuse;
+    vec3 specular = light.specular.xyz * spec * material.specular;
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
+#endif
@@ -0,0 +1,50 @@
+#version 330
+
+layout(location = 0) in vec3 Position;
+layout(location = 1) in vec2 TexCoord;
+layout(location = 2) in vec3 Normal;
+
+// Dequantization of packed meshes set by ppgso::MeshBase, PackedVertices is 0 for float vertices
+layout(location = 3) in vec3 PositionScale;
+layout(location = 4) in vec3 PositionOffset;
+layout(location = 5) in vec4 TexCoordScaleOffset;
+layout(location = 6) in float PackedVertices;
+
+// FrameData block of frame_data.glsl, inserted by FrameUniforms::declare
+
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+
+#if INSTANCED
+// Model matrix of the instance set by ppgso::MeshBase::renderInstanced
+layout(location = 7) in mat4 InstanceMatrix;
+#define ModelMatrix InstanceMatrix
+#else
+uniform mat4 ModelMatrix;
+#endif
+
+out vec2 texCoord;
+out vec3 FragPos;
+out vec3 NormalDir;
+
+vec3 decodeNormal() {
+    // Fold the lower half of the octahedron back
+    vec2 e = Normal.xy * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
+void main() {
+    bool isPacked = PackedVertices != 0.0;
+    vec3 position = isPacked ? Position * PositionScale + PositionOffset : Position;
+    vec3 normal = isPacked ? decodeNormal() : Normal;
+
+    vec4 worldPosition = ModelMatrix * vec4(position, 1.0);
+    FragPos = vec3(worldPosition);
+    NormalDir = mat3(transpose(inverse(ModelMatrix))) * normal;
+    gl_Position = ProjectionMatrix * ViewMatrix * worldPosition;
+    texCoord = isPacked ? TexCoord * TexCoordScaleOffset.xy + TexCoordScaleOffset.zw : TexCoord;
+}
@@ -2,12 +2,12 @@
 
 layout(location = 0) in vec3 position;
 
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
+// FrameData block of frame_data.glsl, inserted by FrameUniforms::declare
 
 out vec3 TexCoords;
 
 void main() {
     TexCoords = position;
-    gl_Position = ProjectionMatrix * ViewMatrix * vec4(position, 1.0);
+    // The sky stays centered on the camera, only the rotation of the view applies
+    gl_Position = ProjectionMatrix * mat4(mat3(ViewMatrix)) * vec4(position, 1.0);
 }
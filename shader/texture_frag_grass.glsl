@@ -46,29 +46,28 @@ struct SpotLight {
 
 uniform sampler2D Texture;
 uniform vec2 TextureOffset;
-uniform sampler2DShadow ShadowMap;
+uniform sampler2DArrayShadow ShadowMap;
+
+// FrameData block of frame_data.glsl, inserted by FrameUniforms::declare
 
 uniform Material material;
-uniform DirectionalLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
 uniform SpotLight spotLight;
-uniform vec3 viewPos;
 
 in vec2 texCoord;
 in vec3 FragPos;
 in vec3 NormalDir;
-in vec4 FragPosLightSpace;
 
 out vec4 FragmentColor;
 
 vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 texColor);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor);
-float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir);
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir);
 
 void main() {
+    DirectionalLight dirLight = DirectionalLight(SunDirection.xyz, SunAmbient.xyz, SunDiffuse.xyz, SunSpecular.xyz);
     vec3 norm = normalize(NormalDir);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(ViewPosition.xyz - FragPos);
     vec3 texColor = texture(Texture, texCoord).rgb;
 
     // calculate lighting components
@@ -89,7 +88,7 @@ void main() {
     diffuse += dirDiffuse;
     specular += dirSpecular;
 
-    float shadow = ShadowCalculation(FragPosLightSpace, norm, dirLightDir);
+    float shadow = ShadowCalculation(FragPos, norm, dirLightDir);
 
     // combine lighting
     vec3 result = CalcDirLight(dirLight, norm, viewDir, texColor);
@@ -112,20 +111,23 @@ vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 texCol
     return (ambient + diffuse + specular);
 }
 
-float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
+// Shadowed fraction of the fragment in the cascade covering its view depth, 0 is fully lit
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir) {
+    float viewDepth = -(ViewMatrix * vec4(fragPos, 1.0)).z;
+    int cascade = int(dot(vec4(greaterThan(vec4(viewDepth), CascadeSplits)), vec4(1.0)));
+    if (cascade >= CASCADES) return 0.0;
+
+    vec4 fragPosLightSpace = CascadeMatrices[cascade] * vec4(fragPos, 1.0);
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
 
-    // if outside the lights frustum
+    // if outside the volume of the cascade
     if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
-        return 1.0;
+        return 0.0;
 
-    float shadow = texture(ShadowMap, projCoords);
     // bias for reducing shadow acne
-    float bias = max(0.005 * (1.0 - dot(normal, lightDir)), 0.005);
-    shadow = projCoords.z > shadow + bias ? 0.0 : 1.0;
-
-    return shadow;
+    float bias = max(CascadeBias[cascade] * (1.0 - dot(normal, lightDir)), CascadeBias[cascade]);
+    return 1.0 - texture(ShadowMap, vec4(projCoords.xy, cascade, projCoords.z - bias));
 }
 
 
@@ -1,17 +1,24 @@
 #include "grasstile.h"
+#include "render_queue.h"
 #include "camera.h"
 #include <glm/gtc/matrix_transform.hpp>
+#include "frame_uniforms.h"
 #include <shaders/texture_vert_grass_glsl.h>
 #include <shaders/texture_frag_grass_glsl.h>
 
-std::unique_ptr<ppgso::Mesh> GrassTile::mesh;
+std::shared_ptr<ppgso::Mesh> GrassTile::mesh;
 std::unique_ptr<ppgso::Shader> GrassTile::shader;
-std::unique_ptr<ppgso::Texture> GrassTile::texture;
+std::shared_ptr<ppgso::Texture> GrassTile::texture;
 
 GrassTile::GrassTile(const glm::vec3& position, const glm::vec3& scale) : position(position), scale(scale) {
-    if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_grass_glsl, texture_frag_grass_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("quad.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("models/grass.bmp"));
+    if (!shader) {
+        shader = std::make_unique<ppgso::Shader>(FrameUniforms::declare(texture_vert_grass_glsl),
+                                                 FrameUniforms::declare(texture_frag_grass_glsl));
+        FrameUniforms::bindBlocks(*shader);
+        shader->setUniform(shader->getUniform("ShadowMap"), 1);
+    }
+    if (!mesh) mesh = ppgso::AssetCache::instance().mesh("quad.obj");
+    if (!texture) texture = ppgso::AssetCache::instance().texture("models/grass.bmp");
 }
 
 ppgso::Shader* GrassTile::getShader() const {
@@ -30,6 +37,14 @@ void GrassTile::renderDepth(ppgso::Shader& depthShader) {
     mesh->render();
 }
 
+void GrassTile::submit(RenderQueue& queue) {
+    queue.submit(this, shader.get(), texture.get(), mesh.get(), position);
+}
+
+void GrassTile::submitDepth(RenderQueue& queue) {
+    queue.submitDepth(this, mesh.get());
+}
+
 
 bool GrassTile::update(float dTime, Scene &scene) {
     return true;
@@ -46,8 +61,6 @@ void GrassTile::render(const Camera& camera) {
     modelMatrix = glm::rotate(modelMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 
     shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("ViewMatrix", camera.viewMatrix);
-    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
 
     shader->setUniform("material.ambient", glm::vec3(1.0f));
     shader->setUniform("material.diffuse", glm::vec3(1.0f));
@@ -6,9 +6,9 @@
 #include <memory>
 
 class GrassTile final : public Renderable {
-    static std::unique_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Mesh> mesh;
     static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Texture> texture;
 
     glm::vec3 position;
     glm::vec3 scale = {1.0f, 1.0f, 1.0f};
@@ -20,6 +20,8 @@ public:
     void render(const Camera& camera) override;
     ppgso::Shader* getShader() const override;
     void renderDepth(ppgso::Shader& depthShader) override;
+    void submit(RenderQueue& queue) override;
+    void submitDepth(RenderQueue& queue) override;
 
 };
 
@@ -11,11 +11,11 @@ PostProcessor::PostProcessor(unsigned int width, unsigned int height)
 {
     // HDR Framebuffer
     glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+    ppgso::GLState::bindFramebuffer(hdrFBO);
 
     glGenTextures(2, colorBuffers);
     for (unsigned int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
+        ppgso::GLState::bindTexture(0, GL_TEXTURE_2D, colorBuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -33,14 +33,14 @@ PostProcessor::PostProcessor(unsigned int width, unsigned int height)
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cerr << "ERROR: HDR framebuffer not complete!\n";
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ppgso::GLState::bindFramebuffer(0);
 
     // init ping-pong framebuffers for blur effect
     glGenFramebuffers(2, pingpongFBO);
     glGenTextures(2, pingpongColorbuffers);
     for (unsigned int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
+        ppgso::GLState::bindFramebuffer(pingpongFBO[i]);
+        ppgso::GLState::bindTexture(0, GL_TEXTURE_2D, pingpongColorbuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -48,7 +48,7 @@ PostProcessor::PostProcessor(unsigned int width, unsigned int height)
         if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
             std::cerr << "ERROR: Ping-pong framebuffer not complete!\n";
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ppgso::GLState::bindFramebuffer(0);
 
     if (!brightExtractShader)
         brightExtractShader = std::make_unique<ppgso::Shader>(quad_vert_glsl, bright_frag_glsl);
@@ -70,31 +70,38 @@ PostProcessor::PostProcessor(unsigned int width, unsigned int height)
 
     glGenVertexArrays(1, &quadVAO);
     glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
+    ppgso::GLState::bindVertexArray(quadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glBindVertexArray(0);
+    ppgso::GLState::bindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 PostProcessor::~PostProcessor() {
+    ppgso::GLState::deleteFramebuffer(hdrFBO);
     glDeleteFramebuffers(1, &hdrFBO);
     glDeleteRenderbuffers(1, &rboDepth);
+    for (unsigned int i = 0; i < 2; i++) {
+        ppgso::GLState::deleteTexture(colorBuffers[i]);
+        ppgso::GLState::deleteFramebuffer(pingpongFBO[i]);
+        ppgso::GLState::deleteTexture(pingpongColorbuffers[i]);
+    }
     glDeleteTextures(2, colorBuffers);
 
     glDeleteFramebuffers(2, pingpongFBO);
     glDeleteTextures(2, pingpongColorbuffers);
 
+    ppgso::GLState::deleteVertexArray(quadVAO);
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
 }
 
 void PostProcessor::BeginRender() {
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+    ppgso::GLState::bindFramebuffer(hdrFBO);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
@@ -116,10 +123,8 @@ void PostProcessor::EndRender() {
     // chromatic aberration parameter
     finalShader->setUniform("chromaticAberration", 0.01f);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[0]);
+    ppgso::GLState::bindTexture(0, GL_TEXTURE_2D, colorBuffers[0]);
+    ppgso::GLState::bindTexture(1, GL_TEXTURE_2D, pingpongColorbuffers[0]);
 
     renderQuad();
 }
@@ -128,9 +133,8 @@ void PostProcessor::applyBloom() {
     // extract bright areas
     brightExtractShader->use();
     brightExtractShader->setUniform("scene", 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, colorBuffers[1]);
-    glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[0]);
+    ppgso::GLState::bindTexture(0, GL_TEXTURE_2D, colorBuffers[1]);
+    ppgso::GLState::bindFramebuffer(pingpongFBO[0]);
     glClear(GL_COLOR_BUFFER_BIT);
     renderQuad();
 
@@ -139,20 +143,18 @@ void PostProcessor::applyBloom() {
     bool horizontal = true, first_iteration = true;
     unsigned int amount = 5; // blur passes
     for (unsigned int i = 0; i < amount; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
+        ppgso::GLState::bindFramebuffer(pingpongFBO[horizontal]);
         blurShader->setUniform("image", 0);
         blurShader->setUniform("horizontal", horizontal);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, first_iteration ? pingpongColorbuffers[0] : pingpongColorbuffers[!horizontal]);
+        ppgso::GLState::bindTexture(0, GL_TEXTURE_2D, first_iteration ? pingpongColorbuffers[0] : pingpongColorbuffers[!horizontal]);
         renderQuad();
         horizontal = !horizontal;
         if (first_iteration) first_iteration = false;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ppgso::GLState::bindFramebuffer(0);
 }
 
 void PostProcessor::renderQuad() {
-    glBindVertexArray(quadVAO);
+    ppgso::GLState::bindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
 }
@@ -2,6 +2,7 @@
 
 #include <GL/glew.h>
 #include <memory>
+#include "gl_state.h"
 #include "shader.h"
 
 class PostProcessor {
@@ -14,6 +15,12 @@ public:
 
     void setBloomEnabled(bool enabled) { bloomEnabled = enabled; }
 
+    // HDR framebuffer the scene is drawn into, its depth is a DEPTH_COMPONENT24 renderbuffer
+    unsigned int getSceneFramebuffer() const { return hdrFBO; }
+
+    // Fullscreen quad with texture coordinates for quad_vert.glsl, also used by passes drawing into the scene
+    void renderQuad();
+
 private:
     unsigned int width, height;
 
@@ -34,5 +41,4 @@ private:
     unsigned int quadVBO = 0;
 
     void applyBloom();
-    void renderQuad();
 };
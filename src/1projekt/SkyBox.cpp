@@ -1,45 +1,42 @@
 #include "Skybox.h"
+#include "render_queue.h"
 #include "camera.h"
+#include "frame_uniforms.h"
 #include <shaders/skybox_vert_glsl.h>
 #include <shaders/skybox_frag_glsl.h>
 #include <iostream>
 
 std::unique_ptr<ppgso::Shader> Skybox::shader;
-std::unique_ptr<ppgso::Mesh> Skybox::mesh;
+std::shared_ptr<ppgso::Mesh> Skybox::mesh;
 
 Skybox::Skybox(const std::vector<std::string>& faces) {
-    if (!shader) shader = std::make_unique<ppgso::Shader>(skybox_vert_glsl, skybox_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("cube.obj");
+    if (!shader) {
+        shader = std::make_unique<ppgso::Shader>(FrameUniforms::declare(skybox_vert_glsl), skybox_frag_glsl);
+        FrameUniforms::bindBlocks(*shader);
+    }
+    if (!mesh) mesh = ppgso::AssetCache::instance().mesh("cube.obj");
 
     loadCubemap(faces);
 }
 
 Skybox::~Skybox() {
+    ppgso::GLState::deleteTexture(cubemapTextureID);
     glDeleteTextures(1, &cubemapTextureID);
 }
 
 void Skybox::loadCubemap(const std::vector<std::string>& faces) {
     glGenTextures(1, &cubemapTextureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTextureID);
+    ppgso::GLState::bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTextureID);
 
     for (unsigned int i = 0; i < faces.size(); i++) {
         auto image = ppgso::image::loadBMP(faces[i]);
 
         if (image.width > 0 && image.height > 0) {
-            std::vector<unsigned char> rawData;
-            rawData.reserve(image.width * image.height * 3);
-
-            for (int y = 0; y < image.height; ++y) {
-                for (int x = 0; x < image.width; ++x) {
-                    auto pixel = image.getPixel(x, y);
-                    rawData.push_back(pixel.r);
-                    rawData.push_back(pixel.g);
-                    rawData.push_back(pixel.b);
-                }
-            }
-
+            // loadBMP already stores tightly packed RGB rows, upload the framebuffer as it is
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB,
-                         image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, rawData.data());
+                         image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         } else {
             std::cerr << "Failed to load cubemap texture at: " << faces[i] << std::endl;
         }
@@ -57,8 +54,14 @@ ppgso::Shader* Skybox::getShader() const {
 }
 
 void Skybox::renderDepth(ppgso::Shader& depthShader) {
-    depthShader.use();
-    mesh->render();
+}
+
+void Skybox::submit(RenderQueue& queue) {
+    queue.submit(this, shader.get(), nullptr, mesh.get(), glm::vec3(0.0f), RenderPass::Skybox);
+}
+
+// the sky surrounds the whole scene and never casts shadows
+void Skybox::submitDepth(RenderQueue& queue) {
 }
 
 
@@ -67,26 +70,21 @@ bool Skybox::update(float dTime, Scene &scene) {
 }
 
 void Skybox::render(const Camera& camera) {
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_FALSE);
+    ppgso::GLState::depthFunc(GL_LEQUAL);
+    ppgso::GLState::depthMask(false);
 
     shader->use();
 
-    glm::mat4 viewMatrix = glm::mat4(glm::mat3(camera.viewMatrix));
-    shader->setUniform("ViewMatrix", viewMatrix);
-    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
-
     shader->setUniform("material.ambient", glm::vec3(1.0f, 1.0f, 1.0f));
     shader->setUniform("material.diffuse", glm::vec3(1.0f, 1.0f, 1.0f));
     shader->setUniform("material.specular", glm::vec3(0.5f, 0.5f, 0.5f));
     shader->setUniform("material.shininess", 32.0f);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTextureID);
+    ppgso::GLState::bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTextureID);
     shader->setUniform("Skybox", 0);
 
     mesh->render();
 
-    glDepthMask(GL_TRUE);
-    glDepthFunc(GL_LESS);
+    ppgso::GLState::depthMask(true);
+    ppgso::GLState::depthFunc(GL_LESS);
 }
@@ -9,7 +9,7 @@
 
 class Skybox final : public Renderable {
     static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Mesh> mesh;
     GLuint cubemapTextureID;
 
     void loadCubemap(const std::vector<std::string>& faces);
@@ -22,6 +22,8 @@ public:
     void render(const Camera& camera) override;
     ppgso::Shader* getShader() const override;
     void renderDepth(ppgso::Shader& depthShader) override;
+    void submit(RenderQueue& queue) override;
+    void submitDepth(RenderQueue& queue) override;
 
 };
 
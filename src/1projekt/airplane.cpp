@@ -1,23 +1,18 @@
 #include "airplane.h"
+#include "render_queue.h"
 #include "camera.h"
 #include "renderable.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <shaders/texture_vert_glsl.h>
-#include <shaders/texture_frag_glsl.h>
+#include "scene_shader.h"
 #include <iostream>
 #include <cmath>
 
-std::unique_ptr<ppgso::Shader> Airplane::shader;
 glm::vec3 Airplane::ambientLightColor = glm::vec3(0.8f, 0.7f, 0.6f);
 
 Airplane::Airplane()
     : position(0.0f, 50.0f, 0.0f), rotation(0.0f, 0.0f, 0.0f) {
-    if (!shader) {
-        shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-    }
-
-    mesh = std::make_unique<ppgso::Mesh>("models/plane.obj");
-    texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("models/plane.bmp"));
+    mesh = ppgso::AssetCache::instance().mesh("models/plane.obj", ppgso::VertexFormat::Packed);
+    texture = ppgso::AssetCache::instance().texture("models/plane.bmp");
 
     float A = 70.0f;
     float B = 70.0f;
@@ -79,48 +74,56 @@ bool Airplane::update(float dTime, Scene& scene) {
 }
 
 void Airplane::render(const Camera& camera) {
-    shader->use();
-
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.y), glm::vec3(0, 1, 0));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.x), glm::vec3(1, 0, 0));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.z), glm::vec3(0, 0, 1));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+    glm::mat4 modelMatrix = getModelMatrix();
 
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("ViewMatrix", camera.viewMatrix);
-    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
-    shader->setUniform("LightSpaceMatrix", lightSpaceMatrix);
+    size_t lod = lodSelector.select(*mesh, modelMatrix, camera);
+    // the airplane flies above everything, nothing casts a shadow on it
+    auto variant = SceneShader::get(lod, false);
+    auto shader = variant.shader;
+    const auto& uniforms = *variant.uniforms;
+    shader->use();
 
-    shader->setUniform("material.ambient", glm::vec3(1.0f));
-    shader->setUniform("material.diffuse", glm::vec3(1.0f));
-    shader->setUniform("material.specular", glm::vec3(1.0f));
-    shader->setUniform("material.shininess", 64.0f);
+    shader->setUniform(uniforms.modelMatrix, modelMatrix);
 
-    shader->setUniform("Texture", *texture);
+    shader->setUniform(uniforms.materialAmbient, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialDiffuse, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialSpecular, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialShininess, 64.0f);
 
-    shader->setUniform("ShadowMap", 1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
+    shader->setUniform(uniforms.texture, *texture);
 
-    mesh->render();
+    mesh->render(lod);
 }
 
 void Airplane::renderDepth(ppgso::Shader& depthShader) {
     depthShader.use();
 
+    depthShader.setUniform(depthModelMatrix, getModelMatrix());
+    mesh->render(lodSelector.getLod());
+}
+
+glm::mat4 Airplane::getModelMatrix() const {
     glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
     modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.y), glm::vec3(0, 1, 0));
     modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.x), glm::vec3(1, 0, 0));
     modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.z), glm::vec3(0, 0, 1));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+    return glm::scale(modelMatrix, glm::vec3(scale));
+}
+
+void Airplane::submit(RenderQueue& queue) {
+    queue.submit(this, getShader(), texture.get(), mesh.get(), position);
+}
+
+void Airplane::submitDepth(RenderQueue& queue) {
+    queue.submitDepth(this, mesh.get(), lodSelector.getLod());
+}
 
-    depthShader.setUniform("ModelMatrix", modelMatrix);
-    mesh->render();
+bool Airplane::getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    return getMeshBounds(*mesh, getModelMatrix(), boundsMin, boundsMax);
 }
 
 ppgso::Shader* Airplane::getShader() const {
-    return shader.get();
+    return SceneShader::get(lodSelector.getLod(), false).shader;
 }
 
 void Airplane::finalizeAnimation() {
@@ -2,19 +2,23 @@
 #define PPGSO_AIRPLANE_H
 
 #include "renderable.h"
+#include "lod_selector.h"
+#include "scene_shader.h"
 #include "animation_curve.h"
 #include <ppgso/ppgso.h>
 #include <memory>
 #include <glm/vec3.hpp>
 
 class Airplane final : public Renderable {
-    static std::unique_ptr<ppgso::Shader> shader;
 
-    std::unique_ptr<ppgso::Mesh> mesh;
-    std::unique_ptr<ppgso::Texture> texture;
+    std::shared_ptr<ppgso::Mesh> mesh;
+    std::shared_ptr<ppgso::Texture> texture;
+    LodSelector lodSelector;
 
     float scale = 1.0f;
 
+    glm::mat4 getModelMatrix() const;
+
 public:
     static glm::vec3 ambientLightColor;
     glm::vec3 position;
@@ -29,6 +33,9 @@ public:
     bool update(float dTime, Scene& scene) override;
     void render(const Camera& camera) override;
     void renderDepth(ppgso::Shader& depthShader) override;
+    void submit(RenderQueue& queue) override;
+    void submitDepth(RenderQueue& queue) override;
+    bool getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const override;
     ppgso::Shader* getShader() const override;
 
     void setScale(float newScale) { scale = newScale; }
@@ -1,66 +1,137 @@
 #include "building.h"
+#include "render_queue.h"
 #include "camera.h"
 #include "renderable.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <shaders/texture_vert_glsl.h>
-#include <shaders/texture_frag_glsl.h>
+#include "scene_shader.h"
+#include "frame_uniforms.h"
+#include "instance_buffer.h"
+#include "gpu_culling.h"
+#include <shaders/depth_vert_glsl.h>
+#include <shaders/depth_frag_glsl.h>
+
+// props like lamps, bins and roadblocks are too small or thin to hide anything
+const float MIN_OCCLUDER_SIZE = 2.0f;
+// the occluder stays inside the walls and below the roof of the roughly box shaped building models
+const float OCCLUDER_WIDTH = 0.8f, OCCLUDER_HEIGHT = 0.9f;
 
-std::unique_ptr<ppgso::Shader> Building::shader;
 glm::vec3 Building::ambientLightColor = glm::vec3(0.8f, 0.7f, 0.6f);
 
-glm::mat4 Renderable::lightSpaceMatrix;
-GLuint Renderable::depthMap;
+Building::Batch Building::batch;
 
 Building::Building(const std::string& objFilename, const glm::vec3& initialPosition, const std::string& textureFilename)
         : position(initialPosition) {
-    if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-
-    mesh = std::make_unique<ppgso::Mesh>(objFilename);
-    texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP(textureFilename));
+    mesh = ppgso::AssetCache::instance().mesh(objFilename, ppgso::VertexFormat::Packed);
+    texture = ppgso::AssetCache::instance().texture(textureFilename);
 }
 
 bool Building::update(float dTime, Scene& scene) {
     return true;
 }
 
-void Building::render(const Camera& camera) {
-    shader->use();
-
+glm::mat4 Building::getModelMatrix() const {
     glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
     modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0, 1, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+    return glm::scale(modelMatrix, glm::vec3(scale));
+}
 
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("ViewMatrix", camera.viewMatrix);
-    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
-    shader->setUniform("LightSpaceMatrix", lightSpaceMatrix);
+void Building::render(const Camera& camera) {
+    glm::mat4 modelMatrix = getModelMatrix();
+    size_t lod = lodSelector.select(*mesh, modelMatrix, camera);
+    addInstance(mesh.get(), texture.get(), lod, false, modelMatrix);
+}
 
-    shader->setUniform("material.ambient", glm::vec3(1.0f));
-    shader->setUniform("material.diffuse", glm::vec3(1.0f));
-    shader->setUniform("material.specular", glm::vec3(1.0f));
-    shader->setUniform("material.shininess", 64.0f);
+void Building::renderDepth(ppgso::Shader& depthShader) {
+    addInstance(mesh.get(), nullptr, lodSelector.getLod(), true, getModelMatrix());
+}
 
-    shader->setUniform("Texture", *texture);
+void Building::addInstance(ppgso::Mesh* mesh, ppgso::Texture* texture, size_t lod, bool depth,
+                           const glm::mat4& modelMatrix) {
+    if (mesh != batch.mesh || texture != batch.texture || lod != batch.lod || depth != batch.depth) {
+        flushInstances();
+        batch.mesh = mesh;
+        batch.texture = texture;
+        batch.lod = lod;
+        batch.depth = depth;
+    }
+    batch.modelMatrices.push_back(modelMatrix);
+}
 
-    shader->setUniform("ShadowMap", 1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
+void Building::flushInstances() {
+    if (batch.modelMatrices.empty()) return;
 
-    mesh->render();
+    static InstanceBuffer instances;
+    GLuint buffer = instances.upload(batch.modelMatrices);
+    drawInstances(batch.mesh, batch.texture, batch.lod, batch.depth, buffer, batch.modelMatrices.size());
+    batch.modelMatrices.clear();
 }
 
-void Building::renderDepth(ppgso::Shader& depthShader) {
-    depthShader.use();
+void Building::drawInstances(ppgso::Mesh* mesh, ppgso::Texture* texture, size_t lod, bool depth,
+                             GLuint instanceBuffer, size_t count) {
+    if (depth) {
+        static std::unique_ptr<ppgso::Shader> depthShader;
+        static ppgso::UniformHandle cascade;
+        static int shaderCascade = -1;
+        if (!depthShader) {
+            depthShader = std::make_unique<ppgso::Shader>(FrameUniforms::declare(depth_vert_glsl), depth_frag_glsl,
+                                                          ppgso::ShaderDefines{{"INSTANCED", 1}});
+            FrameUniforms::bindBlocks(*depthShader);
+            cascade = depthShader->getUniform("Cascade");
+        }
+        // the cascade only changes between the passes, not between the batches drawn in one of them
+        if (shaderCascade != Renderable::depthCascade) {
+            depthShader->setUniform(cascade, Renderable::depthCascade);
+            shaderCascade = Renderable::depthCascade;
+        }
+        depthShader->use();
+    } else {
+        auto variant = SceneShader::get(lod, true, true);
+        auto shader = variant.shader;
+        const auto& uniforms = *variant.uniforms;
+        shader->use();
+
+        shader->setUniform(uniforms.materialAmbient, glm::vec3(1.0f));
+        shader->setUniform(uniforms.materialDiffuse, glm::vec3(1.0f));
+        shader->setUniform(uniforms.materialSpecular, glm::vec3(1.0f));
+        shader->setUniform(uniforms.materialShininess, 64.0f);
+
+        shader->setUniform(uniforms.texture, *texture);
+    }
+
+    mesh->renderInstanced(lod, instanceBuffer, count);
+}
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0, 1, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+void Building::submit(RenderQueue& queue) {
+    queue.submit(this, getShader(), texture.get(), mesh.get(), position);
+}
 
-    depthShader.setUniform("ModelMatrix", modelMatrix);
+void Building::submitDepth(RenderQueue& queue) {
+    queue.submitDepth(this, mesh.get(), lodSelector.getLod());
+}
+
+bool Building::getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    return getMeshBounds(*mesh, getModelMatrix(), boundsMin, boundsMax);
+}
 
-    mesh->render();
+bool Building::getOccluder(glm::mat4& boxMatrix) const {
+    glm::vec3 meshMin = mesh->getBoundsMin(), meshMax = mesh->getBoundsMax();
+    if (!staticPosition || glm::any(glm::greaterThan(meshMin, meshMax))) return false;
+    glm::vec3 size = meshMax - meshMin;
+    if (glm::any(glm::lessThan(size * scale, glm::vec3(MIN_OCCLUDER_SIZE)))) return false;
+
+    // shrunk around the vertical axis, the base stays on the ground
+    glm::vec3 half = size * glm::vec3(OCCLUDER_WIDTH, OCCLUDER_HEIGHT, OCCLUDER_WIDTH) * 0.5f;
+    glm::vec3 center{(meshMin.x + meshMax.x) * 0.5f, meshMin.y + half.y, (meshMin.z + meshMax.z) * 0.5f};
+    boxMatrix = glm::scale(glm::translate(getModelMatrix(), center), half);
+    return true;
+}
+
+bool Building::addToGpuCulling(GpuCulling& culling) const {
+    if (!staticPosition || glm::any(glm::greaterThan(mesh->getBoundsMin(), mesh->getBoundsMax()))) return false;
+    culling.add(mesh.get(), texture.get(), getModelMatrix());
+    return true;
 }
 
 ppgso::Shader* Building::getShader() const {
-    return shader.get();
+    return SceneShader::get(lodSelector.getLod(), true, true).shader;
 }
@@ -2,19 +2,38 @@
 #define PPGSO_BUILDING_H
 
 #include "renderable.h"
+#include "lod_selector.h"
+#include "scene_shader.h"
 #include "car.h"
 #include <ppgso/ppgso.h>
 #include <memory>
+#include <vector>
 #include <glm/vec3.hpp>
 
 class Building final : public Renderable {
-    static std::unique_ptr<ppgso::Shader> shader;
 
-    std::unique_ptr<ppgso::Mesh> mesh;
-    std::unique_ptr<ppgso::Texture> texture;
+    std::shared_ptr<ppgso::Mesh> mesh;
+    std::shared_ptr<ppgso::Texture> texture;
+    LodSelector lodSelector;
 
     float scale = 1.0f;
     float rotation = 0.0f;
+    bool staticPosition = true;
+
+    // Instances collected by render and renderDepth, drawn with one instanced call once an instance with a
+    // different mesh, texture or level of detail comes or the window flushes them
+    struct Batch {
+        ppgso::Mesh* mesh = nullptr;
+        ppgso::Texture* texture = nullptr;
+        size_t lod = 0;
+        bool depth = false;
+        std::vector<glm::mat4> modelMatrices;
+    };
+    static Batch batch;
+    static void addInstance(ppgso::Mesh* mesh, ppgso::Texture* texture, size_t lod, bool depth,
+                            const glm::mat4& modelMatrix);
+
+    glm::mat4 getModelMatrix() const;
 
 public:
     static glm::vec3 ambientLightColor;
@@ -25,10 +44,24 @@ public:
     bool update(float dTime, Scene& scene) override;
     void render(const Camera& camera) override;
     void renderDepth(ppgso::Shader& depthShader) override;
+    void submit(RenderQueue& queue) override;
+    void submitDepth(RenderQueue& queue) override;
+    bool getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const override;
+    bool isStatic() const override { return staticPosition; }
+    bool getOccluder(glm::mat4& boxMatrix) const override;
+    bool addToGpuCulling(GpuCulling& culling) const override;
     ppgso::Shader* getShader() const override;
 
+    // Draw the collected instances, the window calls it at the end of every pass
+    static void flushInstances();
+    // Draw count instances with model matrices from a buffer, the depth pass uses the instanced depth shader
+    static void drawInstances(ppgso::Mesh* mesh, ppgso::Texture* texture, size_t lod, bool depth,
+                              GLuint instanceBuffer, size_t count);
+
     void setScale(float newScale) { scale = newScale; }
     void setRotation(float angle) { rotation = angle; }
+    // Buildings stay where they were placed unless something moves them around, like the trailer its bin
+    void setStatic(bool isStatic) { staticPosition = isStatic; }
 };
 
 #endif // PPGSO_BUILDING_H
@@ -22,3 +22,7 @@ void Camera::update() {
     target = position + front;
     viewMatrix = glm::lookAt(position, target, up);
 }
+
+Frustum Camera::getFrustum() const {
+    return Frustum{projectionMatrix * viewMatrix};
+}
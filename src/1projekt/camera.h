@@ -4,6 +4,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "frustum.h"
 
 class Camera {
 public:
@@ -20,6 +21,9 @@ public:
     Camera(float fov = 45.0f, float ratio = 1.0f, float near = 0.1f, float far = 150.0f);
 
     void update();
+
+    // Planes of the volume seen by the camera, taken from projectionMatrix * viewMatrix
+    Frustum getFrustum() const;
 };
 
 #endif //PPGSO_CAMERA_H
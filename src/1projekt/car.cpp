@@ -1,29 +1,29 @@
 #include "car.h"
+#include "render_queue.h"
 #include "camera.h"
 #include "renderable.h"
-#include "splash_particle.h"
+#include "particle_system.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <shaders/texture_vert_glsl.h>
-#include <shaders/texture_frag_glsl.h>
+#include "scene_shader.h"
 #include <random>
 
-std::unique_ptr<ppgso::Shader> Car::shader;
 glm::vec3 Car::ambientLightColor = glm::vec3(0.8f, 0.7f, 0.6f);
-static std::vector<Car*> allCars;
+ParticleSystem* Car::particles = nullptr;
+SpatialGrid<Car*>* Car::index = nullptr;
 
 Car::Car(const std::string& objFilename, const glm::vec3& initialPosition, const std::string& textureFilename)
         : direction(1.0f, 0.0f, 0.0f), boundingBox(glm::vec3(1.0f)), position(initialPosition), startPosition(initialPosition) {
-    if (!shader) {
-        shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-    }
-
-    mesh = std::make_unique<ppgso::Mesh>(objFilename);
-    texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP(textureFilename));
+    mesh = ppgso::AssetCache::instance().mesh(objFilename, ppgso::VertexFormat::Packed);
+    texture = ppgso::AssetCache::instance().texture(textureFilename);
 
     if (objFilename.find("truck") != std::string::npos) { isTruck = true; }
     else { isTruck = false; }
 
-    allCars.push_back(this);
+    if (index) indexHandle = index->insert(this, position);
+}
+
+Car::~Car() {
+    if (index) index->remove(indexHandle);
 }
 
 void Car::simulateCollision(Car& other, Scene& scene) {
@@ -86,8 +86,7 @@ void Car::simulateCollision(Car& other, Scene& scene) {
 
             float lifetime = lifetimeDist(gen);
 
-            auto particle = std::make_unique<SplashParticle>(particlePosition, velocity, color, lifetime);
-            scene.push_back(std::move(particle));
+            if (particles) particles->spawnSplash(particlePosition, velocity, color, lifetime);
         }
     };
 
@@ -97,15 +96,18 @@ void Car::simulateCollision(Car& other, Scene& scene) {
 
 
 void Car::checkCollision(Scene& scene) {
-    for (Car* other : allCars) {
-        if (other == this || other->crashed) continue;
+    if (!index) return;
+
+    // only cars around this one are candidates
+    index->queryBox(position - boundingBox, position + boundingBox, [&](Car* other) {
+        if (other == this || other->crashed) return;
 
         if (glm::abs(position.x - other->position.x) < boundingBox.x &&
             glm::abs(position.y - other->position.y) < boundingBox.y &&
             glm::abs(position.z - other->position.z) < boundingBox.z) {
             simulateCollision(*other, scene);
             }
-    }
+    });
 }
 
 
@@ -132,6 +134,7 @@ bool Car::update(float dTime, Scene& scene) {
             atIntersection = false;
         }
 
+        if (index) index->update(indexHandle, position);
         return true;
     }
 
@@ -148,6 +151,7 @@ bool Car::update(float dTime, Scene& scene) {
     }
 
     position += direction * dTime * 5.0f;
+    if (index) index->update(indexHandle, position);
 
     checkCollision(scene);
 
@@ -197,40 +201,52 @@ bool Car::update(float dTime, Scene& scene) {
 
 
 void Car::render(const Camera& camera) {
-    shader->use();
-
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0, 1, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+    glm::mat4 modelMatrix = getModelMatrix();
 
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("ViewMatrix", camera.viewMatrix);
-    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
+    size_t lod = lodSelector.select(*mesh, modelMatrix, camera);
+    auto variant = SceneShader::get(lod);
+    auto shader = variant.shader;
+    const auto& uniforms = *variant.uniforms;
+    shader->use();
 
-    shader->setUniform("ambientLight", ambientLightColor);
+    shader->setUniform(uniforms.modelMatrix, modelMatrix);
 
-    shader->setUniform("material.ambient", glm::vec3(1.0f));
-    shader->setUniform("material.diffuse", glm::vec3(1.0f));
-    shader->setUniform("material.specular", glm::vec3(1.0f));
-    shader->setUniform("material.shininess", 64.0f);
+    shader->setUniform(uniforms.materialAmbient, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialDiffuse, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialSpecular, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialShininess, 64.0f);
 
-    shader->setUniform("Texture", *texture);
-    mesh->render();
+    shader->setUniform(uniforms.texture, *texture);
+    mesh->render(lod);
 }
 
 void Car::renderDepth(ppgso::Shader& depthShader) {
     if (crashed) return;
     depthShader.use();
 
+    depthShader.setUniform(depthModelMatrix, getModelMatrix());
+    mesh->render(lodSelector.getLod());
+}
+
+glm::mat4 Car::getModelMatrix() const {
     glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
     modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0, 1, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+    return glm::scale(modelMatrix, glm::vec3(scale));
+}
 
-    depthShader.setUniform("ModelMatrix", modelMatrix);
-    mesh->render();
+void Car::submit(RenderQueue& queue) {
+    queue.submit(this, getShader(), texture.get(), mesh.get(), position);
 }
 
+void Car::submitDepth(RenderQueue& queue) {
+    queue.submitDepth(this, mesh.get(), lodSelector.getLod());
+}
+
+
+bool Car::getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    return getMeshBounds(*mesh, getModelMatrix(), boundsMin, boundsMax);
+}
 
 ppgso::Shader* Car::getShader() const {
-    return shader.get();
+    return SceneShader::get(lodSelector.getLod()).shader;
 }
\ No newline at end of file
@@ -2,7 +2,10 @@
 #define CAR_H
 
 #include "renderable.h"
+#include "lod_selector.h"
+#include "scene_shader.h"
 #include "camera.h"
+#include "spatial_grid.h"
 #include <ppgso/ppgso.h>
 #include <memory>
 #include <glm/vec3.hpp>
@@ -10,20 +13,29 @@
 #include <string>
 
 
+class ParticleSystem;
+
 class Car : public Renderable {
 
     glm::vec3 direction;
     bool crashed = false;
     glm::vec3 boundingBox;
+    SpatialGrid<Car*>::Handle indexHandle = 0;
+
+    glm::mat4 getModelMatrix() const;
 
 public:
-    std::unique_ptr<ppgso::Mesh> mesh;
-    std::unique_ptr<ppgso::Texture> texture;
+    std::shared_ptr<ppgso::Mesh> mesh;
+    std::shared_ptr<ppgso::Texture> texture;
+    LodSelector lodSelector;
     glm::vec3 position;
     float scale = 1.0f;
     float rotation = 0.0f;
-    static std::unique_ptr<ppgso::Shader> shader;
     static glm::vec3 ambientLightColor;
+    // Receives the debris of collisions, set by the window
+    static ParticleSystem* particles;
+    // Positions of all cars for the collision tests, set by the window before the cars are created
+    static SpatialGrid<Car*>* index;
     bool atIntersection = false;
     float animationTime{};
     float rotationTimer;
@@ -38,12 +50,16 @@ public:
 
 
     Car(const std::string& objFilename, const glm::vec3& initialPosition, const std::string& textureFilename);
+    ~Car() override;
 
     bool isAtIntersection();
 
     bool update(float dTime, Scene& scene) override;
     void render(const Camera& camera) override;
     void renderDepth(ppgso::Shader& depthShader) override;
+    void submit(RenderQueue& queue) override;
+    void submitDepth(RenderQueue& queue) override;
+    bool getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const override;
     ppgso::Shader* getShader() const override;
 
 
@@ -0,0 +1,117 @@
+#include "cpu_particle_system.h"
+#include "render_queue.h"
+#include "camera.h"
+#include "frame_uniforms.h"
+#include <glm/gtc/random.hpp>
+#include <shaders/particle_vert_glsl.h>
+#include <shaders/particle_frag_glsl.h>
+#include <chrono>
+#include <limits>
+
+namespace {
+    // Arrays of the pools read by the vertex shader, in the order of its attribute locations
+    const ParticlePool::Array UPLOADED[] = {
+            ParticlePool::X, ParticlePool::Y, ParticlePool::Z,
+            ParticlePool::RED, ParticlePool::GREEN, ParticlePool::BLUE,
+            ParticlePool::AGE, ParticlePool::LIFETIME
+    };
+    const size_t UPLOADED_COUNT = sizeof(UPLOADED) / sizeof(UPLOADED[0]);
+
+    const glm::vec3 GRAVITY{0.0f, -9.8f, 0.0f};
+}
+
+std::unique_ptr<ppgso::Shader> CpuParticleSystem::shader;
+ppgso::UniformHandle CpuParticleSystem::radius;
+ppgso::UniformHandle CpuParticleSystem::pixelScale;
+
+CpuParticleSystem::CpuParticleSystem(size_t rainCapacity, size_t splashCapacity)
+        : rain(rainCapacity), splashes(splashCapacity) {
+    if (!shader) {
+        shader = std::make_unique<ppgso::Shader>(FrameUniforms::declare(particle_vert_glsl), particle_frag_glsl);
+        FrameUniforms::bindBlocks(*shader);
+        radius = shader->getUniform("Radius");
+        pixelScale = shader->getUniform("PixelScale");
+    }
+
+    // Every attribute is a plain float array, sections are sized for both pools at full capacity
+    size_t capacity = rainCapacity + splashCapacity;
+    glGenVertexArrays(1, &vao);
+    ppgso::GLState::bindVertexArray(vao);
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, UPLOADED_COUNT * capacity * sizeof(float), nullptr, GL_STREAM_DRAW);
+    for (GLuint location = 0; location < UPLOADED_COUNT; location++) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 1, GL_FLOAT, GL_FALSE, 0, (void*) (location * capacity * sizeof(float)));
+    }
+}
+
+CpuParticleSystem::~CpuParticleSystem() {
+    glDeleteBuffers(1, &vbo);
+    ppgso::GLState::deleteVertexArray(vao);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void CpuParticleSystem::spawnRain(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color) {
+    rain.spawn(position, velocity, color, std::numeric_limits<float>::infinity());
+}
+
+void CpuParticleSystem::spawnSplash(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color,
+                                 float lifetime) {
+    splashes.spawn(position, velocity, color, lifetime);
+}
+
+bool CpuParticleSystem::update(float dTime, Scene& scene) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    landed.clear();
+    rain.update(dTime, wind, RAIN_FLOOR, &landed);
+    splashes.update(dTime, GRAVITY, -std::numeric_limits<float>::infinity());
+
+    for (auto& position : landed) {
+        for (int i = 0; i < SPLASHES_PER_DROP; ++i) {
+            float angle = glm::linearRand(0.0f, glm::two_pi<float>());
+            float speedValue = glm::linearRand(0.1f, 0.5f);
+            glm::vec3 splashSpeed = glm::vec3(cos(angle), 0.5f, sin(angle)) * speedValue;
+            spawnSplash(position, splashSpeed, glm::vec3(0.0f, 0.0f, 1.0f), 1.0f);
+        }
+    }
+
+    updateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return true;
+}
+
+void CpuParticleSystem::render(const Camera& camera) {
+    if (size() == 0) return;
+
+    // Orphan the buffer so the upload does not wait for the previous frame, then copy every array as it is
+    size_t capacity = rain.getCapacity() + splashes.getCapacity();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, UPLOADED_COUNT * capacity * sizeof(float), nullptr, GL_STREAM_DRAW);
+    for (size_t i = 0; i < UPLOADED_COUNT; i++) {
+        GLintptr section = i * capacity * sizeof(float);
+        glBufferSubData(GL_ARRAY_BUFFER, section, rain.size() * sizeof(float), rain.data(UPLOADED[i]));
+        glBufferSubData(GL_ARRAY_BUFFER, section + rain.size() * sizeof(float), splashes.size() * sizeof(float),
+                        splashes.data(UPLOADED[i]));
+    }
+
+    // Pixels covered by one world unit at distance 1
+    GLint viewport[4];
+    ppgso::GLState::getViewport(viewport);
+
+    shader->use();
+    shader->setUniform(radius, PARTICLE_RADIUS);
+    shader->setUniform(pixelScale, 0.5f * viewport[3] * camera.projectionMatrix[1][1]);
+
+    ppgso::GLState::setEnabled(GL_PROGRAM_POINT_SIZE, true);
+    ppgso::GLState::bindVertexArray(vao);
+    glDrawArrays(GL_POINTS, 0, (GLsizei) size());
+}
+
+ppgso::Shader* CpuParticleSystem::getShader() const {
+    return shader.get();
+}
+
+void CpuParticleSystem::submit(RenderQueue& queue) {
+    queue.submit(this, shader.get(), nullptr, nullptr, glm::vec3(0.0f));
+}
@@ -0,0 +1,41 @@
+#ifndef PPGSO_CPU_PARTICLE_SYSTEM_H
+#define PPGSO_CPU_PARTICLE_SYSTEM_H
+
+#include "particle_system.h"
+#include "particle_pool.h"
+#include <vector>
+
+// Particles simulated in two ParticlePools on the CPU. The arrays are uploaded as they are into one buffer
+// every frame, one section per attribute.
+class CpuParticleSystem final : public ParticleSystem {
+    static std::unique_ptr<ppgso::Shader> shader;
+    static ppgso::UniformHandle radius, pixelScale;
+
+    ParticlePool rain;
+    ParticlePool splashes;
+    std::vector<glm::vec3> landed;
+
+    // One buffer section per uploaded array, rain drops followed by splashes
+    GLuint vao = 0;
+    GLuint vbo = 0;
+
+public:
+    static const int SPLASHES_PER_DROP = 100;
+
+    CpuParticleSystem(size_t rainCapacity, size_t splashCapacity);
+    ~CpuParticleSystem() override;
+    CpuParticleSystem(const CpuParticleSystem&) = delete;
+    CpuParticleSystem& operator=(const CpuParticleSystem&) = delete;
+
+    void spawnRain(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color) override;
+    void spawnSplash(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color,
+                     float lifetime) override;
+    size_t size() const override { return rain.size() + splashes.size(); }
+
+    bool update(float dTime, Scene& scene) override;
+    void render(const Camera& camera) override;
+    ppgso::Shader* getShader() const override;
+    void submit(RenderQueue& queue) override;
+};
+
+#endif //PPGSO_CPU_PARTICLE_SYSTEM_H
@@ -0,0 +1,96 @@
+#include "deferred_shading.h"
+#include "frame_uniforms.h"
+#include "light_clusters.h"
+#include <shaders/quad_vert_glsl.h>
+#include <shaders/deferred_light_frag_glsl.h>
+#include <iostream>
+
+const GLuint DeferredShading::ALBEDO_UNIT;
+const GLuint DeferredShading::NORMAL_UNIT;
+const GLuint DeferredShading::DEPTH_UNIT;
+
+namespace {
+    GLuint createTexture(GLenum internalFormat, GLenum format, GLenum type, unsigned int width, unsigned int height) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        ppgso::GLState::bindTexture(0, GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        // the lighting pass reads exactly one texel per pixel
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+}
+
+DeferredShading::DeferredShading(PostProcessor& target, unsigned int width, unsigned int height)
+        : target(target), width(width), height(height) {
+    glGenFramebuffers(1, &gBufferFBO);
+    ppgso::GLState::bindFramebuffer(gBufferFBO);
+
+    albedoBuffer = createTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoBuffer, 0);
+    normalBuffer = createTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT, width, height);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalBuffer, 0);
+    // the same format as the depth of the HDR target, so it can be copied there with a blit
+    depthBuffer = createTexture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, width, height);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthBuffer, 0);
+
+    GLenum attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, attachments);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "ERROR: G-buffer framebuffer not complete!\n";
+    ppgso::GLState::bindFramebuffer(0);
+
+    lightShader = std::make_unique<ppgso::Shader>(
+            quad_vert_glsl, FrameUniforms::declare(deferred_light_frag_glsl), ppgso::ShaderDefines{
+            {"MAX_CLUSTER_LIGHTS", LightClusters::MAX_CLUSTER_LIGHTS},
+            {"CLUSTER_TILES_X", LightClusters::TILES_X},
+            {"CLUSTER_TILES_Y", LightClusters::TILES_Y},
+            {"CLUSTER_SLICES", LightClusters::SLICES}});
+    FrameUniforms::bindBlocks(*lightShader);
+    LightClusters::bindSamplers(*lightShader);
+    lightShader->setUniform(lightShader->getUniform("ShadowMap"), 1);
+    lightShader->setUniform(lightShader->getUniform("GBufferAlbedo"), (int) ALBEDO_UNIT);
+    lightShader->setUniform(lightShader->getUniform("GBufferNormal"), (int) NORMAL_UNIT);
+    lightShader->setUniform(lightShader->getUniform("GBufferDepth"), (int) DEPTH_UNIT);
+    inverseViewProjection = lightShader->getUniform("InverseViewProjection");
+}
+
+DeferredShading::~DeferredShading() {
+    ppgso::GLState::deleteFramebuffer(gBufferFBO);
+    glDeleteFramebuffers(1, &gBufferFBO);
+    for (GLuint texture : {albedoBuffer, normalBuffer, depthBuffer}) {
+        ppgso::GLState::deleteTexture(texture);
+        glDeleteTextures(1, &texture);
+    }
+}
+
+void DeferredShading::beginGeometry() {
+    // colors need no clear, pixels without geometry keep the far depth and are skipped by the lighting pass
+    ppgso::GLState::bindFramebuffer(gBufferFBO);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void DeferredShading::light(const Camera& camera) {
+    // Forward shaded objects test against the depth of the deferred ones. GLState tracks one framebuffer for
+    // both targets, so the read target is restored after the blit.
+    GLuint sceneFBO = target.getSceneFramebuffer();
+    ppgso::GLState::bindFramebuffer(sceneFBO);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gBufferFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+
+    lightShader->use();
+    lightShader->setUniform(inverseViewProjection, glm::inverse(camera.projectionMatrix * camera.viewMatrix));
+    ppgso::GLState::bindTexture(ALBEDO_UNIT, GL_TEXTURE_2D, albedoBuffer);
+    ppgso::GLState::bindTexture(NORMAL_UNIT, GL_TEXTURE_2D, normalBuffer);
+    ppgso::GLState::bindTexture(DEPTH_UNIT, GL_TEXTURE_2D, depthBuffer);
+
+    // every pixel is lit once, the quad neither tests nor writes depth
+    ppgso::GLState::setEnabled(GL_DEPTH_TEST, false);
+    target.renderQuad();
+    ppgso::GLState::setEnabled(GL_DEPTH_TEST, true);
+}
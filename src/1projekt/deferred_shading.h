@@ -0,0 +1,47 @@
+#ifndef PPGSO_DEFERRED_SHADING_H
+#define PPGSO_DEFERRED_SHADING_H
+
+#include "camera.h"
+#include "PostProcessor.h"
+#include <ppgso/ppgso.h>
+#include <memory>
+
+
+// Deferred path for the objects drawn with the scene shader. Their geometry pass writes albedo, normal, a packed
+// material ID and depth into a G-buffer, then one fullscreen pass lights every pixel once with the sun, its
+// shadow map and the point lights of the light cluster of the pixel. Overdrawn fragments cost only the G-buffer
+// writes. The lit result and the depth go into the HDR target of the PostProcessor, so the sky, particles and
+// other forward shaded objects are drawn on top and bloom and final_frag.glsl run unchanged.
+class DeferredShading {
+public:
+    // Texture units of the G-buffer in the lighting pass, after the ones of the scene shader and LightClusters
+    static const GLuint ALBEDO_UNIT = 5;
+    static const GLuint NORMAL_UNIT = 6;
+    static const GLuint DEPTH_UNIT = 7;
+
+    DeferredShading(PostProcessor& target, unsigned int width, unsigned int height);
+    ~DeferredShading();
+    DeferredShading(const DeferredShading&) = delete;
+    DeferredShading& operator=(const DeferredShading&) = delete;
+
+    // Bind the G-buffer and clear its depth, G-buffer variants of the scene shader draw into it
+    void beginGeometry();
+
+    // Copy the depth into the HDR target and light the G-buffer into it. The shadow map and the light clusters
+    // must be bound to their units, the HDR target stays bound for the forward shaded objects.
+    void light(const Camera& camera);
+
+private:
+    PostProcessor& target;
+    unsigned int width, height;
+
+    GLuint gBufferFBO = 0;
+    GLuint albedoBuffer = 0;
+    GLuint normalBuffer = 0;
+    GLuint depthBuffer = 0;
+
+    std::unique_ptr<ppgso::Shader> lightShader;
+    ppgso::UniformHandle inverseViewProjection;
+};
+
+#endif //PPGSO_DEFERRED_SHADING_H
@@ -0,0 +1,30 @@
+#include "frame_uniforms.h"
+#include <shaders/frame_data_glsl.h>
+
+FrameUniforms::FrameUniforms() {
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms() {
+    glDeleteBuffers(1, &buffer);
+}
+
+std::string FrameUniforms::declare(const std::string& code) {
+    return ppgso::Shader::addPrefix(code, "#define CASCADES " + std::to_string(ShadowCascades::CASCADES) + "\n" +
+                                          frame_data_glsl);
+}
+
+void FrameUniforms::bindBlocks(const ppgso::Shader& shader) {
+    shader.bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+}
+
+void FrameUniforms::update(const FrameData& frame) {
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, buffer);
+}
@@ -0,0 +1,54 @@
+#ifndef PPGSO_FRAME_UNIFORMS_H
+#define PPGSO_FRAME_UNIFORMS_H
+
+#include "shadow_cascades.h"
+#include <ppgso/ppgso.h>
+#include <glm/glm.hpp>
+#include <string>
+
+
+// Mirror of the std140 FrameData block, vec3 values are padded to vec4
+struct FrameData {
+    glm::mat4 viewMatrix;
+    glm::mat4 projectionMatrix;
+    glm::vec4 viewPosition;
+    glm::vec4 sunDirection;
+    glm::vec4 sunAmbient;
+    glm::vec4 sunDiffuse;
+    glm::vec4 sunSpecular;
+    // Light cluster slice of a view space depth is log(depth) * x + y, see LightClusters
+    glm::vec4 clusterSlices;
+    // Light space of every shadow cascade, the view space depths where they end and their depth bias
+    glm::mat4 cascadeMatrices[ShadowCascades::CASCADES];
+    glm::vec4 cascadeSplits;
+    glm::vec4 cascadeBias;
+};
+
+static_assert(sizeof(FrameData) == 512, "FrameData does not match the std140 layout");
+
+// Uniform buffer with the camera and the sun shared by all programs, uploaded once per frame instead of setting
+// the same uniforms on every shader. Point lights are in the buffer textures of LightClusters.
+class FrameUniforms {
+public:
+    static const GLuint FRAME_DATA_BINDING = 0;
+
+    FrameUniforms();
+    ~FrameUniforms();
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    // Insert the FrameData block of frame_data.glsl and the CASCADES define sizing it into a shader source, every
+    // shader using it is created from the returned source
+    static std::string declare(const std::string& code);
+
+    // Attach the FrameData block of a program to its binding point, call once after creating it
+    static void bindBlocks(const ppgso::Shader& shader);
+
+    // Upload the block and bind the buffer
+    void update(const FrameData& frame);
+
+private:
+    GLuint buffer = 0;
+};
+
+#endif //PPGSO_FRAME_UNIFORMS_H
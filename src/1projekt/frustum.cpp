@@ -0,0 +1,56 @@
+#include "frustum.h"
+#include <limits>
+
+Frustum::Frustum()
+        : cornersMin(-std::numeric_limits<float>::infinity()), cornersMax(std::numeric_limits<float>::infinity()) {
+    for (auto& plane : planes) plane = glm::vec4(0.0f);
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    // glm matrices are stored by columns, row i of the matrix is element i of every column
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; row++)
+        rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row],
+                              viewProjection[3][row]);
+
+    // a clip space point is inside when -w <= x, y, z <= w
+    for (int axis = 0; axis < 3; axis++) {
+        planes[axis * 2] = rows[3] + rows[axis];
+        planes[axis * 2 + 1] = rows[3] - rows[axis];
+    }
+
+    // unit normals make the distances comparable to the box extents
+    for (auto& plane : planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) plane /= length;
+    }
+
+    // corners of the clip space cube taken back to the world
+    glm::mat4 inverse = glm::inverse(viewProjection);
+    cornersMin = glm::vec3(std::numeric_limits<float>::max());
+    cornersMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 clip{corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 1.0f};
+        glm::vec4 world = inverse * clip;
+        cornersMin = glm::min(cornersMin, glm::vec3(world) / world.w);
+        cornersMax = glm::max(cornersMax, glm::vec3(world) / world.w);
+    }
+}
+
+bool Frustum::intersects(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+    // boxes next to a corner are behind no plane, the box around the corners rejects most of them
+    if (glm::any(glm::greaterThan(boundsMin, cornersMax)) || glm::any(glm::lessThan(boundsMax, cornersMin)))
+        return false;
+
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+    // outside when even the corner furthest along the normal is behind a plane
+    for (const auto& plane : planes) {
+        glm::vec3 normal = glm::vec3(plane);
+        float distance = glm::dot(normal, center) + plane.w;
+        float radius = glm::dot(glm::abs(normal), extent);
+        if (distance + radius < 0.0f) return false;
+    }
+    return true;
+}
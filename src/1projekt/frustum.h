@@ -0,0 +1,33 @@
+#ifndef PPGSO_FRUSTUM_H
+#define PPGSO_FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+
+// Volume a view projection matrix maps into clip space, bounded by six planes with normals pointing inside.
+// Perspective and orthographic matrices are handled the same way, so it serves the camera and the shadow map.
+class Frustum {
+public:
+    static const int PLANE_COUNT = 6;
+
+    // Empty frustum without planes, nothing is outside of it
+    Frustum();
+    // Left, right, bottom, top, near and far planes extracted from the rows of the matrix
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    // Test a world space bounding box, a few boxes near an edge of the frustum pass without touching it
+    bool intersects(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+    // World space box around the eight corners of the volume, infinite for the empty frustum
+    const glm::vec3& getBoundsMin() const { return cornersMin; }
+    const glm::vec3& getBoundsMax() const { return cornersMax; }
+
+    // Plane as normal and distance from the origin, points with dot(normal, point) + distance < 0 are outside
+    const glm::vec4& getPlane(int plane) const { return planes[plane]; }
+
+private:
+    glm::vec4 planes[PLANE_COUNT];
+    glm::vec3 cornersMin, cornersMax;
+};
+
+#endif //PPGSO_FRUSTUM_H
@@ -0,0 +1,199 @@
+#include "gpu_culling.h"
+#include "building.h"
+#include <shaders/gpu_cull_vert_glsl.h>
+#include <shaders/gpu_cull_geom_glsl.h>
+#include <algorithm>
+#include <string>
+
+std::unique_ptr<ppgso::Shader> GpuCulling::cullShader;
+GpuCulling::Uniforms GpuCulling::uniforms;
+
+GpuCulling::GpuCulling() {
+    if (!cullShader) {
+        cullShader = std::make_unique<ppgso::Shader>(
+                gpu_cull_vert_glsl, gpu_cull_geom_glsl, "",
+                std::vector<std::string>{"outModelColumn0", "outModelColumn1", "outModelColumn2", "outModelColumn3"});
+
+        for (int plane = 0; plane < Frustum::PLANE_COUNT; plane++)
+            uniforms.planes[plane] = cullShader->getUniform("Planes[" + std::to_string(plane) + "]");
+        uniforms.cameraPosition = cullShader->getUniform("CameraPosition");
+        uniforms.projectionScale = cullShader->getUniform("ProjectionScale");
+        uniforms.lodThresholds = cullShader->getUniform("LodThresholds");
+        uniforms.lodCount = cullShader->getUniform("LodCount");
+        uniforms.lod = cullShader->getUniform("Lod");
+    }
+}
+
+GpuCulling::~GpuCulling() {
+    for (auto& group : groups) {
+        ppgso::GLState::deleteVertexArray(group->vao);
+        glDeleteVertexArrays(1, &group->vao);
+        glDeleteBuffers(1, &group->instanceBuffer);
+        for (auto& view : group->views) {
+            for (auto& capture : view.captures) {
+                glDeleteBuffers((GLsizei) group->levels, capture.buffers);
+                glDeleteQueries((GLsizei) group->levels, capture.queries);
+            }
+        }
+    }
+}
+
+void GpuCulling::add(ppgso::Mesh* mesh, ppgso::Texture* texture, const glm::mat4& modelMatrix) {
+    auto& group = groupsByKey[{mesh, texture}];
+    if (!group) {
+        groups.push_back(std::make_unique<Group>());
+        group = groups.back().get();
+        group->mesh = mesh;
+        group->texture = texture;
+        group->levels = std::min(mesh->getLodCount(), (size_t) LodSelector::MAX_LEVELS);
+
+        glGenBuffers(1, &group->instanceBuffer);
+        glGenVertexArrays(1, &group->vao);
+        for (auto& view : group->views) {
+            for (auto& capture : view.captures) {
+                glGenBuffers((GLsizei) group->levels, capture.buffers);
+                glGenQueries((GLsizei) group->levels, capture.queries);
+            }
+        }
+
+        // Columns of the model matrix and the bounding sphere, one instance per point
+        ppgso::GLState::bindVertexArray(group->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, group->instanceBuffer);
+        for (GLuint location = 0; location < 5; location++) {
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  (void*) (location * sizeof(glm::vec4)));
+        }
+    }
+
+    // Bounding sphere in world space, non-uniform scale is covered by its largest axis like in LodSelector
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(mesh->getBoundingCenter(), 1.0f));
+    float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+                            glm::length(glm::vec3(modelMatrix[2]))});
+    group->instances.push_back({modelMatrix, glm::vec4(center, mesh->getBoundingRadius() * scale)});
+    group->dirty = true;
+    instanceCount++;
+}
+
+void GpuCulling::upload(Group& group) {
+    size_t count = group.instances.size();
+    glBindBuffer(GL_ARRAY_BUFFER, group.instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(Instance), group.instances.data(), GL_STATIC_DRAW);
+
+    // Every level may hold all instances, the GPU writes them and the draws read them. Earlier captures are
+    // gone with the old storage.
+    for (auto& view : group.views) {
+        for (auto& capture : view.captures) {
+            for (size_t level = 0; level < group.levels; level++) {
+                glBindBuffer(GL_ARRAY_BUFFER, capture.buffers[level]);
+                glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+            }
+        }
+        view.drawn = view.pending = -1;
+    }
+    group.dirty = false;
+}
+
+bool GpuCulling::collect(Group& group, Capture& capture, bool wait) {
+    if (!wait) {
+        for (size_t level = 0; level < group.levels; level++) {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(capture.queries[level], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return false;
+        }
+    }
+    for (size_t level = 0; level < group.levels; level++) {
+        GLuint written = 0;
+        glGetQueryObjectuiv(capture.queries[level], GL_QUERY_RESULT, &written);
+        capture.counts[level] = written;
+    }
+    return true;
+}
+
+void GpuCulling::cull(Pass pass, const glm::mat4& viewProjection, const Camera& camera, int cascade) {
+    if (groups.empty()) return;
+    int index = getView(pass, cascade);
+
+    cullShader->use();
+    Frustum frustum{viewProjection};
+    for (int plane = 0; plane < Frustum::PLANE_COUNT; plane++)
+        cullShader->setUniform(uniforms.planes[plane], frustum.getPlane(plane));
+    cullShader->setUniform(uniforms.cameraPosition, camera.position);
+    cullShader->setUniform(uniforms.projectionScale, camera.projectionMatrix[1][1]);
+    cullShader->setUniform(uniforms.lodThresholds,
+                           glm::vec4(LodSelector::getThreshold(0), LodSelector::getThreshold(1),
+                                     LodSelector::getThreshold(2), LodSelector::getThreshold(3)));
+
+    // Every level is a separate capture, the instances of other levels are dropped by the geometry shader
+    ppgso::GLState::setEnabled(GL_RASTERIZER_DISCARD, true);
+    for (auto& group : groups) {
+        if (group->dirty) upload(*group);
+        auto& view = group->views[index];
+
+        // The capture of an earlier frame is drawn once the GPU finished it. While it has not, the GPU is
+        // behind and the view keeps drawing the capture before it instead of queueing another one.
+        if (view.pending >= 0 && collect(*group, view.captures[view.pending], false)) {
+            view.drawn = view.pending;
+            view.pending = -1;
+        }
+        if (view.pending >= 0) continue;
+
+        view.pending = view.drawn == 0 ? 1 : 0;
+        auto& capture = view.captures[view.pending];
+        cullShader->setUniform(uniforms.lodCount, (int) group->levels);
+        ppgso::GLState::bindVertexArray(group->vao);
+        for (size_t level = 0; level < group->levels; level++) {
+            cullShader->setUniform(uniforms.lod, (int) level);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, capture.buffers[level]);
+            glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, capture.queries[level]);
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, (GLsizei) group->instances.size());
+            glEndTransformFeedback();
+            glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+        }
+    }
+    ppgso::GLState::setEnabled(GL_RASTERIZER_DISCARD, false);
+
+    // Without an earlier capture, on the first frame and after new instances, the fresh one is waited for
+    for (auto& group : groups) {
+        auto& view = group->views[index];
+        if (view.drawn < 0 && view.pending >= 0) {
+            collect(*group, view.captures[view.pending], true);
+            view.drawn = view.pending;
+            view.pending = -1;
+        }
+    }
+}
+
+void GpuCulling::render(Pass pass, int cascade) {
+    int index = getView(pass, cascade);
+    for (auto& group : groups) {
+        auto& view = group->views[index];
+        if (view.drawn < 0) continue;
+        auto& capture = view.captures[view.drawn];
+        for (size_t level = 0; level < group->levels; level++) {
+            size_t count = capture.counts[level];
+            if (count == 0) continue;
+            Building::drawInstances(group->mesh, group->texture, level, pass == SHADOW,
+                                    capture.buffers[level], count);
+
+            if (pass == MAIN) {
+                auto& stats = LodSelector::stats();
+                stats.fullTriangles += group->mesh->getTriangleCount(0) * count;
+                stats.renderedTriangles += group->mesh->getTriangleCount(level) * count;
+                stats.objects += count;
+            }
+        }
+    }
+}
+
+size_t GpuCulling::getVisible(Pass pass, int cascade) const {
+    int index = getView(pass, cascade);
+    size_t visible = 0;
+    for (auto& group : groups) {
+        auto& view = group->views[index];
+        if (view.drawn < 0) continue;
+        for (size_t level = 0; level < group->levels; level++) visible += view.captures[view.drawn].counts[level];
+    }
+    return visible;
+}
@@ -0,0 +1,108 @@
+#ifndef PPGSO_GPU_CULLING_H
+#define PPGSO_GPU_CULLING_H
+
+#include "camera.h"
+#include "frustum.h"
+#include "lod_selector.h"
+#include "shadow_cascades.h"
+#include <ppgso/ppgso.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+// Static instanced objects culled on the GPU. Model matrices and bounding spheres of all instances are uploaded
+// once per group of the same mesh and texture. Every pass a transform feedback draw tests the instances against
+// the frustum in a vertex shader and a geometry shader copies the matrices of the visible ones into a compacted
+// buffer for every level of detail, which is then drawn with one instanced call. The CPU work per pass depends
+// on the number of groups and levels, not on the number of instances.
+//
+// GL 3.3 has no indirect draws, so the CPU needs the number of captured instances. Every view captures into one
+// of two sets of buffers while the other one, captured a frame earlier, is drawn. Its counts are read only once
+// the GPU has them, so the CPU never waits except for the first capture. Objects coming into view appear one
+// frame late.
+class GpuCulling {
+public:
+    enum Pass {
+        MAIN,
+        SHADOW
+    };
+
+    GpuCulling();
+    ~GpuCulling();
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    // Add an instance of a loaded mesh, instances stay until the culling is destroyed
+    void add(ppgso::Mesh* mesh, ppgso::Texture* texture, const glm::mat4& modelMatrix);
+
+    // Capture the instances inside the volume of viewProjection for the pass, the shadow pass once for every
+    // cascade. Levels of detail are picked by the camera in both passes, so the shadow pass draws the same
+    // levels as the main one.
+    void cull(Pass pass, const glm::mat4& viewProjection, const Camera& camera, int cascade = 0);
+
+    // Draw the latest instances with known counts of the pass with the instanced shaders of Building
+    void render(Pass pass, int cascade = 0);
+
+    size_t size() const { return instanceCount; }
+    // Instances drawn by render of the pass
+    size_t getVisible(Pass pass, int cascade = 0) const;
+
+private:
+    // Layout of one instance in the source buffer, read by gpu_cull_vert.glsl
+    struct Instance {
+        glm::mat4 modelMatrix;
+        glm::vec4 sphere;
+    };
+
+    // The camera and every shadow cascade
+    static const int VIEW_COUNT = 1 + ShadowCascades::CASCADES;
+
+    // Compacted model matrices of one cull with room for all instances, one buffer per level of detail
+    struct Capture {
+        GLuint buffers[LodSelector::MAX_LEVELS] = {};
+        GLuint queries[LodSelector::MAX_LEVELS] = {};
+        size_t counts[LodSelector::MAX_LEVELS] = {};
+    };
+
+    struct View {
+        Capture captures[2];
+        // Capture with known counts that render draws, and the one the GPU is still writing, -1 for none
+        int drawn = -1;
+        int pending = -1;
+    };
+
+    struct Group {
+        ppgso::Mesh* mesh;
+        ppgso::Texture* texture;
+        size_t levels;
+        std::vector<Instance> instances;
+        // Instances added since the last upload
+        bool dirty = true;
+        GLuint instanceBuffer = 0;
+        GLuint vao = 0;
+        View views[VIEW_COUNT];
+    };
+
+    // Uniforms of the cull shader, resolved once when it is created
+    struct Uniforms {
+        ppgso::UniformHandle planes[Frustum::PLANE_COUNT];
+        ppgso::UniformHandle cameraPosition, projectionScale, lodThresholds, lodCount, lod;
+    };
+
+    static int getView(Pass pass, int cascade) { return pass == MAIN ? 0 : 1 + cascade; }
+    void upload(Group& group);
+    // Read the counts of a capture, waiting for the GPU only when asked to
+    bool collect(Group& group, Capture& capture, bool wait);
+
+    static std::unique_ptr<ppgso::Shader> cullShader;
+    static Uniforms uniforms;
+    std::vector<std::unique_ptr<Group>> groups;
+    std::map<std::pair<ppgso::Mesh*, ppgso::Texture*>, Group*> groupsByKey;
+    size_t instanceCount = 0;
+};
+
+#endif //PPGSO_GPU_CULLING_H
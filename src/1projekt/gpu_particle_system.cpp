@@ -0,0 +1,203 @@
+#include "gpu_particle_system.h"
+#include "render_queue.h"
+#include "camera.h"
+#include "frame_uniforms.h"
+#include <shaders/gpu_particle_update_vert_glsl.h>
+#include <shaders/gpu_particle_update_geom_glsl.h>
+#include <shaders/gpu_particle_vert_glsl.h>
+#include <shaders/particle_frag_glsl.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+namespace {
+    // Values of ColorType.w, see gpu_particle_update_geom.glsl
+    const float RAIN = 0.0f;
+    const float SPLASH = 1.0f;
+    const glm::vec3 GRAVITY{0.0f, -9.8f, 0.0f};
+}
+
+std::unique_ptr<ppgso::Shader> GpuParticleSystem::updateShader;
+std::unique_ptr<ppgso::Shader> GpuParticleSystem::renderShader;
+GpuParticleSystem::Uniforms GpuParticleSystem::uniforms;
+
+GpuParticleSystem::GpuParticleSystem(size_t capacity)
+        : capacity(capacity), feedbackObjects(GLEW_VERSION_4_0 || GLEW_ARB_transform_feedback2) {
+    if (!updateShader) {
+        updateShader = std::make_unique<ppgso::Shader>(
+                gpu_particle_update_vert_glsl, gpu_particle_update_geom_glsl, "",
+                std::vector<std::string>{"outPositionAge", "outVelocityLifetime", "outColorType"});
+        renderShader = std::make_unique<ppgso::Shader>(FrameUniforms::declare(gpu_particle_vert_glsl),
+                                                       particle_frag_glsl);
+        FrameUniforms::bindBlocks(*renderShader);
+
+        uniforms.deltaTime = updateShader->getUniform("DeltaTime");
+        uniforms.wind = updateShader->getUniform("Wind");
+        uniforms.gravity = updateShader->getUniform("Gravity");
+        uniforms.floor = updateShader->getUniform("Floor");
+        uniforms.frame = updateShader->getUniform("Frame");
+        uniforms.radius = renderShader->getUniform("Radius");
+        uniforms.pixelScale = renderShader->getUniform("PixelScale");
+    }
+
+    // The same vertex arrays feed the update and the drawing of a buffer
+    auto setupAttributes = [](GLuint vao, GLuint buffer) {
+        ppgso::GLState::bindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        for (GLuint location = 0; location < 3; location++) {
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                  (void*) (location * sizeof(glm::vec4)));
+        }
+    };
+
+    glGenBuffers(2, buffers);
+    glGenVertexArrays(2, vaos);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Vertex), nullptr, GL_DYNAMIC_COPY);
+        setupAttributes(vaos[i], buffers[i]);
+    }
+    glGenBuffers(1, &spawnBuffer);
+    glGenVertexArrays(1, &spawnVao);
+    setupAttributes(spawnVao, spawnBuffer);
+
+    if (feedbackObjects) {
+        glGenTransformFeedbacks(2, feedbacks);
+        for (int i = 0; i < 2; i++) {
+            glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedbacks[i]);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[i]);
+        }
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    }
+    glGenQueries(1, &query);
+}
+
+GpuParticleSystem::~GpuParticleSystem() {
+    glDeleteQueries(1, &query);
+    if (feedbackObjects) glDeleteTransformFeedbacks(2, feedbacks);
+    for (GLuint vao : {vaos[0], vaos[1], spawnVao})
+        ppgso::GLState::deleteVertexArray(vao);
+    glDeleteVertexArrays(2, vaos);
+    glDeleteVertexArrays(1, &spawnVao);
+    glDeleteBuffers(2, buffers);
+    glDeleteBuffers(1, &spawnBuffer);
+}
+
+void GpuParticleSystem::spawn(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color,
+                              float lifetime, float type) {
+    if (spawned.size() == capacity) return;
+    spawned.push_back({glm::vec4(position, 0.0f), glm::vec4(velocity, lifetime), glm::vec4(color, type)});
+}
+
+void GpuParticleSystem::spawnRain(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color) {
+    spawn(position, velocity, color, std::numeric_limits<float>::infinity(), RAIN);
+}
+
+void GpuParticleSystem::spawnSplash(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color,
+                                    float lifetime) {
+    spawn(position, velocity, color, lifetime, SPLASH);
+}
+
+void GpuParticleSystem::draw(int buffer) {
+    if (feedbackObjects)
+        glDrawTransformFeedback(GL_POINTS, feedbacks[buffer]);
+    else
+        glDrawArrays(GL_POINTS, 0, (GLsizei) liveCount);
+}
+
+bool GpuParticleSystem::update(float dTime, Scene& scene) {
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!hasState && spawned.empty()) return true;
+
+    // The count of an earlier update is collected once the GPU got to it, waiting for it would stall the frame
+    if (queryPending) {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint written = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT, &written);
+            liveCount = written;
+            queryPending = false;
+        }
+    }
+
+    if (!spawned.empty()) {
+        glBindBuffer(GL_ARRAY_BUFFER, spawnBuffer);
+        spawnCapacity = std::max(spawnCapacity, spawned.size());
+        glBufferData(GL_ARRAY_BUFFER, spawnCapacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, spawned.size() * sizeof(Vertex), spawned.data());
+    }
+
+    updateShader->use();
+    updateShader->setUniform(uniforms.deltaTime, dTime);
+    updateShader->setUniform(uniforms.wind, wind);
+    updateShader->setUniform(uniforms.gravity, GRAVITY);
+    updateShader->setUniform(uniforms.floor, RAIN_FLOOR);
+    updateShader->setUniform(uniforms.frame, frame++);
+
+    // Capture into the other buffer, the spawned particles are appended after the surviving ones
+    int target = 1 - current;
+    if (feedbackObjects)
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedbacks[target]);
+    else
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[target]);
+
+    bool counting = !queryPending;
+    ppgso::GLState::setEnabled(GL_RASTERIZER_DISCARD, true);
+    if (counting) glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, query);
+    glBeginTransformFeedback(GL_POINTS);
+    if (hasState) {
+        ppgso::GLState::bindVertexArray(vaos[current]);
+        draw(current);
+    }
+    if (!spawned.empty()) {
+        ppgso::GLState::bindVertexArray(spawnVao);
+        glDrawArrays(GL_POINTS, 0, (GLsizei) spawned.size());
+    }
+    glEndTransformFeedback();
+    if (counting) glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+    ppgso::GLState::setEnabled(GL_RASTERIZER_DISCARD, false);
+
+    if (feedbackObjects) {
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+        queryPending = counting;
+    } else {
+        // The next draw needs the exact count
+        GLuint written = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &written);
+        liveCount = written;
+    }
+
+    current = target;
+    hasState = true;
+    spawned.clear();
+
+    updateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return true;
+}
+
+void GpuParticleSystem::render(const Camera& camera) {
+    if (!hasState) return;
+
+    // Pixels covered by one world unit at distance 1
+    GLint viewport[4];
+    ppgso::GLState::getViewport(viewport);
+
+    renderShader->use();
+    renderShader->setUniform(uniforms.radius, PARTICLE_RADIUS);
+    renderShader->setUniform(uniforms.pixelScale, 0.5f * viewport[3] * camera.projectionMatrix[1][1]);
+
+    ppgso::GLState::setEnabled(GL_PROGRAM_POINT_SIZE, true);
+    ppgso::GLState::bindVertexArray(vaos[current]);
+    draw(current);
+}
+
+ppgso::Shader* GpuParticleSystem::getShader() const {
+    return renderShader.get();
+}
+
+void GpuParticleSystem::submit(RenderQueue& queue) {
+    queue.submit(this, renderShader.get(), nullptr, nullptr, glm::vec3(0.0f));
+}
@@ -0,0 +1,72 @@
+#ifndef PPGSO_GPU_PARTICLE_SYSTEM_H
+#define PPGSO_GPU_PARTICLE_SYSTEM_H
+
+#include "particle_system.h"
+#include <vector>
+
+// Particles simulated on the GPU. The state ping-pongs between two buffers: every frame a geometry shader reads
+// one of them, moves, removes and splashes the particles and transform feedback captures the result into the
+// other one, which is then drawn as it is. The CPU only uploads newly spawned particles, so its cost does not
+// depend on the number of live ones.
+class GpuParticleSystem final : public ParticleSystem {
+    static std::unique_ptr<ppgso::Shader> updateShader;
+    static std::unique_ptr<ppgso::Shader> renderShader;
+
+    // Uniforms of both programs, resolved once when they are created
+    struct Uniforms {
+        ppgso::UniformHandle deltaTime, wind, gravity, floor, frame;
+        ppgso::UniformHandle radius, pixelScale;
+    };
+    static Uniforms uniforms;
+
+    // Layout of one particle in the buffers, the w components hold age, lifetime and type
+    struct Vertex {
+        glm::vec4 positionAge;
+        glm::vec4 velocityLifetime;
+        glm::vec4 colorType;
+    };
+
+    size_t capacity;
+    GLuint buffers[2] = {};
+    GLuint vaos[2] = {};
+    // Buffer with the latest state, empty until the first update
+    int current = 0;
+    bool hasState = false;
+
+    // Particles spawned on the CPU since the last update, appended to the captured ones
+    std::vector<Vertex> spawned;
+    GLuint spawnBuffer = 0;
+    GLuint spawnVao = 0;
+    size_t spawnCapacity = 0;
+
+    // Transform feedback objects keep the number of captured particles on the GPU for glDrawTransformFeedback.
+    // Without them the count is read back from the query right after the update.
+    bool feedbackObjects;
+    GLuint feedbacks[2] = {};
+    GLuint query = 0;
+    bool queryPending = false;
+    size_t liveCount = 0;
+    int frame = 0;
+
+    void draw(int buffer);
+    void spawn(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color, float lifetime,
+               float type);
+
+public:
+    explicit GpuParticleSystem(size_t capacity);
+    ~GpuParticleSystem() override;
+    GpuParticleSystem(const GpuParticleSystem&) = delete;
+    GpuParticleSystem& operator=(const GpuParticleSystem&) = delete;
+
+    void spawnRain(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color) override;
+    void spawnSplash(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color,
+                     float lifetime) override;
+    size_t size() const override { return liveCount; }
+
+    bool update(float dTime, Scene& scene) override;
+    void render(const Camera& camera) override;
+    ppgso::Shader* getShader() const override;
+    void submit(RenderQueue& queue) override;
+};
+
+#endif //PPGSO_GPU_PARTICLE_SYSTEM_H
@@ -0,0 +1,21 @@
+#include "instance_buffer.h"
+#include <algorithm>
+
+InstanceBuffer::InstanceBuffer() {
+    glGenBuffers(1, &vbo);
+}
+
+InstanceBuffer::~InstanceBuffer() {
+    glDeleteBuffers(1, &vbo);
+}
+
+GLuint InstanceBuffer::upload(const std::vector<glm::mat4>& modelMatrices) {
+    size_t size = modelMatrices.size() * sizeof(glm::mat4);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    // Orphan the storage, so earlier draws still reading it do not stall the upload
+    if (size > capacity) capacity = std::max(size, capacity * 2);
+    glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, modelMatrices.data());
+    return vbo;
+}
@@ -0,0 +1,26 @@
+#ifndef PPGSO_INSTANCE_BUFFER_H
+#define PPGSO_INSTANCE_BUFFER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+
+// Dynamic vertex buffer of per instance model matrices, refilled before every instanced draw
+class InstanceBuffer {
+public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Replace the contents with the matrices and return the buffer for ppgso::MeshBase::renderInstanced
+    GLuint upload(const std::vector<glm::mat4>& modelMatrices);
+
+private:
+    GLuint vbo = 0;
+    size_t capacity = 0;
+};
+
+#endif //PPGSO_INSTANCE_BUFFER_H
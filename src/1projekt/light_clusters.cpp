@@ -0,0 +1,158 @@
+#include "light_clusters.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Buffer textures of the lights, the cluster ranges and the light indices
+    const int LIGHTS = 0, RANGES = 1, INDICES = 2;
+
+    void upload(GLuint buffer, const void* data, size_t size) {
+        // An empty buffer texture would have no storage, the shader never reads it then
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr) std::max(size, sizeof(glm::vec4)), nullptr, GL_STREAM_DRAW);
+        if (size > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr) size, data);
+    }
+}
+
+const int LightClusters::TILES_X;
+const int LightClusters::TILES_Y;
+const int LightClusters::SLICES;
+const int LightClusters::CLUSTER_COUNT;
+const int LightClusters::MAX_CLUSTER_LIGHTS;
+const size_t LightClusters::MAX_LIGHTS;
+const GLuint LightClusters::LIGHTS_UNIT;
+const GLuint LightClusters::RANGES_UNIT;
+const GLuint LightClusters::INDICES_UNIT;
+
+LightClusters::LightClusters() : ranges(CLUSTER_COUNT * 2), counts(CLUSTER_COUNT) {
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+
+    const GLenum formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+    for (int i = 0; i < 3; i++) {
+        upload(buffers[i], nullptr, 0);
+        ppgso::GLState::bindTexture(LIGHTS_UNIT + i, GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+}
+
+LightClusters::~LightClusters() {
+    for (auto texture : textures) ppgso::GLState::deleteTexture(texture);
+    glDeleteTextures(3, textures);
+    glDeleteBuffers(3, buffers);
+}
+
+void LightClusters::bindSamplers(const ppgso::Shader& shader) {
+    shader.setUniform(shader.getUniform("LightData"), (int) LIGHTS_UNIT);
+    shader.setUniform(shader.getUniform("ClusterRanges"), (int) RANGES_UNIT);
+    shader.setUniform(shader.getUniform("LightIndices"), (int) INDICES_UNIT);
+}
+
+void LightClusters::add(const PointLightData& light) {
+    lights.push_back(light);
+}
+
+template <typename Visitor>
+void LightClusters::visitClusters(const glm::vec3& center, float radius, Visitor visit) const {
+    // the camera looks down -z, depths of the sphere clamped to the slices
+    float depth = -center.z;
+    float nearest = std::max(depth - radius, sliceDepths[0]);
+    float farthest = std::min(depth + radius, sliceDepths[SLICES]);
+    if (nearest > farthest) return;
+
+    int firstSlice = 0, lastSlice = SLICES - 1;
+    while (firstSlice < SLICES - 1 && sliceDepths[firstSlice + 1] < nearest) firstSlice++;
+    while (lastSlice > firstSlice && sliceDepths[lastSlice] > farthest) lastSlice--;
+
+    for (int slice = firstSlice; slice <= lastSlice; slice++) {
+        float sliceNear = std::max(sliceDepths[slice], nearest);
+        float sliceFar = std::min(sliceDepths[slice + 1], farthest);
+
+        // Box around the sphere projected over the depths of the slice, the widest side divides by the nearest
+        // depth and the narrowest by the farthest one
+        int first[2], last[2];
+        const int tiles[2] = {TILES_X, TILES_Y};
+        bool outside = false;
+        for (int axis = 0; axis < 2; axis++) {
+            float low = center[axis] - radius, high = center[axis] + radius;
+            float ndcLow = projectionScale[axis] * low / (low < 0.0f ? sliceNear : sliceFar);
+            float ndcHigh = projectionScale[axis] * high / (high > 0.0f ? sliceNear : sliceFar);
+            if (ndcHigh < -1.0f || ndcLow > 1.0f) {
+                outside = true;
+                break;
+            }
+            first[axis] = std::max(0, (int) std::floor((ndcLow * 0.5f + 0.5f) * tiles[axis]));
+            last[axis] = std::min(tiles[axis] - 1, (int) std::floor((ndcHigh * 0.5f + 0.5f) * tiles[axis]));
+        }
+        if (outside) continue;
+
+        for (int y = first[1]; y <= last[1]; y++)
+            for (int x = first[0]; x <= last[0]; x++)
+                visit((slice * TILES_Y + y) * TILES_X + x);
+    }
+}
+
+void LightClusters::update(const Camera& camera) {
+    // Perspective projection without skew, near and far come back from its depth terms
+    const glm::mat4& projection = camera.projectionMatrix;
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+    float logRatio = std::log(farPlane / nearPlane);
+    for (int slice = 0; slice <= SLICES; slice++)
+        sliceDepths[slice] = nearPlane * std::pow(farPlane / nearPlane, (float) slice / SLICES);
+    sliceParameters = glm::vec4(SLICES / logRatio, -SLICES * std::log(nearPlane) / logRatio, 0.0f, 0.0f);
+    projectionScale = glm::vec2(projection[0][0], projection[1][1]);
+
+    // Nearest lights first, they win the crowded clusters
+    glm::vec3 eye = camera.position;
+    std::sort(lights.begin(), lights.end(), [&](const PointLightData& a, const PointLightData& b) {
+        return glm::distance(glm::vec3(a.position), eye) < glm::distance(glm::vec3(b.position), eye);
+    });
+    auto toView = [&](const PointLightData& light) {
+        return glm::vec3(camera.viewMatrix * glm::vec4(glm::vec3(light.position), 1.0f));
+    };
+
+    // Count the lights of every cluster, lights outside of the frustum are dropped
+    std::fill(counts.begin(), counts.end(), 0);
+    size_t kept = 0;
+    for (size_t i = 0; i < lights.size() && kept < MAX_LIGHTS; i++) {
+        bool visible = false;
+        visitClusters(toView(lights[i]), lights[i].position.w, [&](int cluster) {
+            counts[cluster]++;
+            visible = true;
+        });
+        if (visible) lights[kept++] = lights[i];
+    }
+    lights.resize(kept);
+    visibleLights = kept;
+
+    // Ranges of the clusters in the index list, the counts become their capacities
+    std::uint32_t offset = 0;
+    maxClusterLights = 0;
+    for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        counts[cluster] = std::min<std::uint32_t>(counts[cluster], MAX_CLUSTER_LIGHTS);
+        ranges[cluster * 2] = offset;
+        ranges[cluster * 2 + 1] = 0;
+        offset += counts[cluster];
+        maxClusterLights = std::max(maxClusterLights, (int) counts[cluster]);
+    }
+
+    indices.resize(offset);
+    for (size_t i = 0; i < lights.size(); i++) {
+        visitClusters(toView(lights[i]), lights[i].position.w, [&](int cluster) {
+            auto& filled = ranges[cluster * 2 + 1];
+            if (filled < counts[cluster]) indices[ranges[cluster * 2] + filled++] = (std::uint16_t) i;
+        });
+    }
+
+    upload(buffers[LIGHTS], lights.data(), lights.size() * sizeof(PointLightData));
+    upload(buffers[RANGES], ranges.data(), ranges.size() * sizeof(std::uint32_t));
+    upload(buffers[INDICES], indices.data(), indices.size() * sizeof(std::uint16_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::bind() const {
+    ppgso::GLState::bindTexture(LIGHTS_UNIT, GL_TEXTURE_BUFFER, textures[LIGHTS]);
+    ppgso::GLState::bindTexture(RANGES_UNIT, GL_TEXTURE_BUFFER, textures[RANGES]);
+    ppgso::GLState::bindTexture(INDICES_UNIT, GL_TEXTURE_BUFFER, textures[INDICES]);
+}
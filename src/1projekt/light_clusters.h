@@ -0,0 +1,91 @@
+#ifndef PPGSO_LIGHT_CLUSTERS_H
+#define PPGSO_LIGHT_CLUSTERS_H
+
+#include "camera.h"
+#include <ppgso/ppgso.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// One point light in the light buffer texture, five texels per light. position.w is the radius the light reaches,
+// attenuation holds the constant, linear and quadratic terms.
+struct PointLightData {
+    glm::vec4 position;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec4 attenuation;
+};
+
+// Point lights sorted into clusters of the camera frustum, 16x9 tiles on screen times 24 slices in depth. Slices
+// grow exponentially with the distance, so clusters are about as deep as they are wide. Every frame the lights
+// are assigned to the clusters their spheres overlap on the CPU and uploaded as buffer textures: the lights,
+// the offset and count of every cluster in the index list and the index list itself. A fragment finds its
+// cluster from its position and evaluates only the lights listed there.
+class LightClusters {
+public:
+    static const int TILES_X = 16;
+    static const int TILES_Y = 9;
+    static const int SLICES = 24;
+    static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+    // Lights of one cluster, the ones nearest to the camera are kept when more overlap it
+    static const int MAX_CLUSTER_LIGHTS = 32;
+    // Indices are 16 bit
+    static const size_t MAX_LIGHTS = 65535;
+
+    // Texture units of the buffer textures, the scene shader samples its texture and the shadow map from 0 and 1
+    static const GLuint LIGHTS_UNIT = 2;
+    static const GLuint RANGES_UNIT = 3;
+    static const GLuint INDICES_UNIT = 4;
+
+    LightClusters();
+    ~LightClusters();
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // Point the samplers of a program using the clusters to the texture units, call once after creating it
+    static void bindSamplers(const ppgso::Shader& shader);
+
+    // Lights of the next update, the ones outside the camera frustum are dropped by it
+    void clear() { lights.clear(); }
+    void add(const PointLightData& light);
+
+    // Assign the lights to the clusters of the camera and upload the buffer textures
+    void update(const Camera& camera);
+
+    // Bind the buffer textures to their units for the main pass
+    void bind() const;
+
+    // Slices of a view space depth are log(depth) * x + y, for the FrameData block
+    glm::vec4 getSliceParameters() const { return sliceParameters; }
+
+    // Lights of the last update inside the frustum, and the most of them in one cluster
+    size_t getVisibleLights() const { return visibleLights; }
+    int getMaxClusterLights() const { return maxClusterLights; }
+    size_t getIndexCount() const { return indices.size(); }
+
+private:
+    template <typename Visitor>
+    void visitClusters(const glm::vec3& center, float radius, Visitor visit) const;
+
+    std::vector<PointLightData> lights;
+    // Offset and count in indices of every cluster, x fastest, then y, then the slice
+    std::vector<std::uint32_t> ranges;
+    std::vector<std::uint16_t> indices;
+    std::vector<std::uint32_t> counts;
+
+    // View space depths of the slice borders and the projection scales of the last update
+    float sliceDepths[SLICES + 1] = {};
+    glm::vec4 sliceParameters{0.0f};
+    glm::vec2 projectionScale{1.0f};
+
+    size_t visibleLights = 0;
+    int maxClusterLights = 0;
+
+    GLuint buffers[3] = {};
+    GLuint textures[3] = {};
+};
+
+#endif //PPGSO_LIGHT_CLUSTERS_H
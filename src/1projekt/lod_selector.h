@@ -0,0 +1,71 @@
+#ifndef PPGSO_LOD_SELECTOR_H
+#define PPGSO_LOD_SELECTOR_H
+
+#include "camera.h"
+#include <ppgso/ppgso.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+
+
+// Picks the level of detail of one object from the size of its bounding sphere on screen
+class LodSelector {
+public:
+    // Finest levels of a mesh that are used, coarser ones are never picked
+    static const size_t MAX_LEVELS = 4;
+
+    // Triangles drawn by the main pass, accumulated until the window reports and resets them
+    struct Stats {
+        size_t fullTriangles = 0;
+        size_t renderedTriangles = 0;
+        size_t objects = 0;
+    };
+
+    static Stats& stats() {
+        static Stats frameStats;
+        return frameStats;
+    }
+
+    size_t select(const ppgso::Mesh& mesh, const glm::mat4& modelMatrix, const Camera& camera) {
+        // Bounding sphere in world space, non-uniform scale is covered by its largest axis
+        glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(mesh.getBoundingCenter(), 1.0f));
+        float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+                                glm::length(glm::vec3(modelMatrix[2]))});
+        float distance = std::max(glm::length(center - camera.position), 0.001f);
+
+        // Radius projected to normalized device coordinates, 1 covers half the viewport height
+        float projected = mesh.getBoundingRadius() * scale * camera.projectionMatrix[1][1] / distance;
+
+        size_t levels = std::min(mesh.getLodCount(), (size_t) MAX_LEVELS);
+        size_t target = 0;
+        while (target + 1 < levels && projected < getThreshold(target + 1)) target++;
+
+        // Coarser levels are taken at once, finer ones only well above the threshold so objects
+        // near it do not switch back and forth every frame
+        lod = std::min(lod, levels - 1);
+        if (target > lod) lod = target;
+        while (lod > target && projected > getThreshold(lod) * HYSTERESIS) lod--;
+
+        auto& frame = stats();
+        frame.fullTriangles += mesh.getTriangleCount(0);
+        frame.renderedTriangles += mesh.getTriangleCount(lod);
+        frame.objects++;
+        return lod;
+    }
+
+    // Level chosen by the last select, reused by the depth pass
+    size_t getLod() const { return lod; }
+
+    // Projected radius below which a level is used, levels follow the 50, 25 and 10 % triangle counts
+    static float getThreshold(size_t level) {
+        static const float thresholds[MAX_LEVELS] = {0.0f, 0.25f, 0.12f, 0.05f};
+        return thresholds[level];
+    }
+
+private:
+    static constexpr float HYSTERESIS = 1.15f;
+
+    size_t lod = 0;
+};
+
+#endif //PPGSO_LOD_SELECTOR_H
@@ -1,7 +1,16 @@
 #include "window.h"
 
-int main() {
-    auto window = ParticleWindow{};
+int main(int argc, char *argv[]) {
+    // --gpu-particles moves the rain simulation to the GPU, --gpu-culling the culling of static buildings
+    bool gpuParticles = false, gpuCulling = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--gpu-particles") gpuParticles = true;
+        if (std::string(argv[i]) == "--gpu-culling") gpuCulling = true;
+    }
+
+    // programs linked on the first start are loaded from binaries on the next ones
+    ppgso::Shader::setBinaryCache("shader_cache");
+    ParticleWindow window{gpuParticles, gpuCulling};
 
     while (window.pollEvents()) {}
 
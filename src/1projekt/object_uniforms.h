@@ -0,0 +1,26 @@
+#ifndef PPGSO_OBJECT_UNIFORMS_H
+#define PPGSO_OBJECT_UNIFORMS_H
+
+#include <ppgso/ppgso.h>
+
+
+// Per object uniforms of the scene shader, resolved once so drawing an object needs no name lookups.
+// Camera, sun and lights come from the FrameUniforms buffer.
+struct ObjectUniforms {
+    ppgso::UniformHandle modelMatrix;
+    ppgso::UniformHandle materialAmbient, materialDiffuse, materialSpecular, materialShininess;
+    ppgso::UniformHandle texture, shadowMap;
+
+    ObjectUniforms() = default;
+
+    explicit ObjectUniforms(const ppgso::Shader& shader)
+            : modelMatrix{shader.getUniform("ModelMatrix")},
+              materialAmbient{shader.getUniform("material.ambient")},
+              materialDiffuse{shader.getUniform("material.diffuse")},
+              materialSpecular{shader.getUniform("material.specular")},
+              materialShininess{shader.getUniform("material.shininess")},
+              texture{shader.getUniform("Texture")},
+              shadowMap{shader.getUniform("ShadowMap")} {}
+};
+
+#endif //PPGSO_OBJECT_UNIFORMS_H
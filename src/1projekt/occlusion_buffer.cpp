@@ -0,0 +1,252 @@
+#include "occlusion_buffer.h"
+#include <ppgso/cpu_features.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+    // Rows rasterized by one thread at a time, 8 bands at the default height
+    const int BAND_HEIGHT = 16;
+    // Objects are tested against at most 4x4 texels of the level their rectangle fits into
+    const int TEST_TEXELS = 4;
+
+    // Corners of the unit cube by bits, x in bit 0, y in bit 1 and z in bit 2, and its faces as quads
+    const int BOX_FACES[6][4] = {
+            {0, 2, 6, 4}, {1, 3, 7, 5},
+            {0, 1, 5, 4}, {2, 3, 7, 6},
+            {0, 1, 3, 2}, {4, 5, 7, 6}
+    };
+
+    typedef OcclusionBuffer::Triangle Triangle;
+
+    // Edge from p to q, points on the left of it with y going up are positive
+    glm::vec3 getEdge(const glm::vec3& p, const glm::vec3& q) {
+        float a = p.y - q.y, b = q.x - p.x;
+        return {a, b, -(a * p.x + b * p.y)};
+    }
+
+    void rasterizeScalar(const Triangle& t, float* depth, int stride, int firstRow, int lastRow) {
+        for (int y = std::max(t.minY, firstRow); y <= std::min(t.maxY, lastRow); y++) {
+            float py = y + 0.5f;
+            float* row = depth + y * stride;
+            // same order of operations as the SSE kernel, both produce the same depths
+            float c0 = t.edges[0].y * py + t.edges[0].z;
+            float c1 = t.edges[1].y * py + t.edges[1].z;
+            float c2 = t.edges[2].y * py + t.edges[2].z;
+            float cz = t.depth.y * py + t.depth.z;
+            for (int x = t.minX; x <= t.maxX; x++) {
+                float px = x + 0.5f;
+                if (t.edges[0].x * px + c0 < 0.0f || t.edges[1].x * px + c1 < 0.0f ||
+                    t.edges[2].x * px + c2 < 0.0f)
+                    continue;
+                row[x] = std::min(row[x], t.depth.x * px + cz);
+            }
+        }
+    }
+
+#ifdef PPGSO_X86
+    // 4 pixels of a row per iteration, groups start at multiples of 4 so they never cross the padded row end
+    void rasterizeSSE(const Triangle& t, float* depth, int stride, int firstRow, int lastRow) {
+        const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 a0 = _mm_set1_ps(t.edges[0].x), a1 = _mm_set1_ps(t.edges[1].x);
+        const __m128 a2 = _mm_set1_ps(t.edges[2].x), az = _mm_set1_ps(t.depth.x);
+        int startX = t.minX & ~3;
+        for (int y = std::max(t.minY, firstRow); y <= std::min(t.maxY, lastRow); y++) {
+            float py = y + 0.5f;
+            float* row = depth + y * stride;
+            __m128 c0 = _mm_set1_ps(t.edges[0].y * py + t.edges[0].z);
+            __m128 c1 = _mm_set1_ps(t.edges[1].y * py + t.edges[1].z);
+            __m128 c2 = _mm_set1_ps(t.edges[2].y * py + t.edges[2].z);
+            __m128 cz = _mm_set1_ps(t.depth.y * py + t.depth.z);
+            for (int x = startX; x <= t.maxX; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float) x), offsets);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), c0), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), c1), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), c2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 nearest = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(az, px), cz));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+            }
+        }
+    }
+#endif
+
+    typedef void (*RasterizeFunction)(const Triangle&, float*, int, int, int);
+
+    RasterizeFunction selectRasterize(OcclusionBuffer::Kernel kernel) {
+#ifdef PPGSO_X86
+        if (kernel == OcclusionBuffer::Kernel::SSE) return rasterizeSSE;
+#endif
+        return rasterizeScalar;
+    }
+
+    OcclusionBuffer::Kernel bestKernel() {
+        if (OcclusionBuffer::isSupported(OcclusionBuffer::Kernel::SSE)) return OcclusionBuffer::Kernel::SSE;
+        return OcclusionBuffer::Kernel::Scalar;
+    }
+}
+
+const int OcclusionBuffer::DEFAULT_WIDTH;
+const int OcclusionBuffer::DEFAULT_HEIGHT;
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+        : width(width), height(height), stride((width + 3) & ~3), depth(stride * height, 1.0f),
+          kernel(bestKernel()) {
+    int levelWidth = width, levelHeight = height;
+    while (true) {
+        levels.push_back({levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f)});
+        if (levelWidth == 1 && levelHeight == 1) break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+bool OcclusionBuffer::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#ifdef PPGSO_X86
+        case Kernel::SSE:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+void OcclusionBuffer::clear(const glm::mat4& newViewProjection) {
+    viewProjection = newViewProjection;
+    triangles.clear();
+    occluders = 0;
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    for (auto& level : levels) std::fill(level.depth.begin(), level.depth.end(), 1.0f);
+}
+
+void OcclusionBuffer::addOccluder(const glm::mat4& boxMatrix) {
+    glm::mat4 toClip = viewProjection * boxMatrix;
+    glm::vec3 corners[8];
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 clip = toClip * glm::vec4(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f,
+                                            corner & 4 ? 1.0f : -1.0f, 1.0f);
+        // clipping would be needed, the box is left out instead so it never hides more than it should
+        if (clip.w <= 0.0f || clip.z < -clip.w) return;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        corners[corner] = {(ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f};
+    }
+
+    occluders++;
+    for (auto& face : BOX_FACES) {
+        addTriangle(corners[face[0]], corners[face[1]], corners[face[2]]);
+        addTriangle(corners[face[0]], corners[face[2]], corners[face[3]]);
+    }
+}
+
+void OcclusionBuffer::addTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    // faces of both windings are drawn, the back ones are always farther than the front ones
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    const glm::vec3& second = area < 0.0f ? c : b;
+    const glm::vec3& third = area < 0.0f ? b : c;
+    area = std::abs(area);
+    // faces seen edge on cover nothing
+    if (area < 1e-6f) return;
+
+    Triangle triangle;
+    triangle.minX = (int) std::max(0.0f, std::floor(std::min({a.x, second.x, third.x})));
+    triangle.maxX = (int) std::min(width - 1.0f, std::floor(std::max({a.x, second.x, third.x})));
+    triangle.minY = (int) std::max(0.0f, std::floor(std::min({a.y, second.y, third.y})));
+    triangle.maxY = (int) std::min(height - 1.0f, std::floor(std::max({a.y, second.y, third.y})));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+    // every edge is the barycentric weight of the opposite corner scaled by the area
+    triangle.edges[0] = getEdge(second, third);
+    triangle.edges[1] = getEdge(third, a);
+    triangle.edges[2] = getEdge(a, second);
+    triangle.depth = (triangle.edges[0] * a.z + triangle.edges[1] * second.z + triangle.edges[2] * third.z) / area;
+    triangles.push_back(triangle);
+}
+
+void OcclusionBuffer::rasterize() {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto function = selectRasterize(kernel);
+
+    // bands of rows are independent, every triangle is clipped to the rows of the band drawing it
+    int bands = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+#ifdef _OPENMP
+    int bandThreads = threads > 0 ? threads : omp_get_max_threads();
+    #pragma omp parallel for num_threads(bandThreads) if(bands > 1 && !triangles.empty())
+#endif
+    for (int band = 0; band < bands; band++) {
+        int firstRow = band * BAND_HEIGHT;
+        int lastRow = std::min(height, firstRow + BAND_HEIGHT) - 1;
+        for (auto& triangle : triangles) {
+            if (triangle.maxY < firstRow || triangle.minY > lastRow) continue;
+            function(triangle, depth.data(), stride, firstRow, lastRow);
+        }
+    }
+
+    buildLevels();
+    rasterTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void OcclusionBuffer::buildLevels() {
+    auto& first = levels.front();
+    for (int y = 0; y < height; y++)
+        std::copy(depth.begin() + y * stride, depth.begin() + y * stride + width, first.depth.begin() + y * width);
+
+    // odd sizes repeat the last row and column of the level below
+    for (size_t index = 1; index < levels.size(); index++) {
+        const auto& below = levels[index - 1];
+        auto& level = levels[index];
+        for (int y = 0; y < level.height; y++) {
+            int y0 = y * 2, y1 = std::min(y0 + 1, below.height - 1);
+            for (int x = 0; x < level.width; x++) {
+                int x0 = x * 2, x1 = std::min(x0 + 1, below.width - 1);
+                level.depth[y * level.width + x] = std::max(
+                        std::max(below.depth[y0 * below.width + x0], below.depth[y0 * below.width + x1]),
+                        std::max(below.depth[y1 * below.width + x0], below.depth[y1 * below.width + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+    glm::vec2 rectMin{std::numeric_limits<float>::max()}, rectMax{-std::numeric_limits<float>::max()};
+    float nearest = std::numeric_limits<float>::max();
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point{corner & 1 ? boundsMax.x : boundsMin.x, corner & 2 ? boundsMax.y : boundsMin.y,
+                        corner & 4 ? boundsMax.z : boundsMin.z};
+        glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+        // boxes reaching in front of the near plane are close enough to be drawn anyway
+        if (clip.w <= 0.0f || clip.z < -clip.w) return true;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 screen{(ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height};
+        rectMin = glm::min(rectMin, screen);
+        rectMax = glm::max(rectMax, screen);
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+
+    int x0 = (int) std::max(0.0f, std::floor(rectMin.x));
+    int x1 = (int) std::min(width - 1.0f, std::floor(rectMax.x));
+    int y0 = (int) std::max(0.0f, std::floor(rectMin.y));
+    int y1 = (int) std::min(height - 1.0f, std::floor(rectMax.y));
+    if (x0 > x1 || y0 > y1) return false;
+
+    // coarsest level needed to cover the rectangle with a few texels
+    size_t index = 0;
+    while (index + 1 < levels.size() &&
+           ((x1 >> index) - (x0 >> index) >= TEST_TEXELS || (y1 >> index) - (y0 >> index) >= TEST_TEXELS))
+        index++;
+
+    const auto& level = levels[index];
+    for (int y = y0 >> index; y <= y1 >> index; y++)
+        for (int x = x0 >> index; x <= x1 >> index; x++)
+            if (nearest <= level.depth[y * level.width + x]) return true;
+    return false;
+}
@@ -0,0 +1,85 @@
+#ifndef PPGSO_OCCLUSION_BUFFER_H
+#define PPGSO_OCCLUSION_BUFFER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+
+// Low resolution depth buffer filled on the CPU with boxes of large occluders, like the walls of the nearest
+// buildings. A hierarchical version of it keeps the farthest depth of every 2x2 block of the level below, so an
+// object is tested by comparing its nearest depth with a few texels covering its screen rectangle. Everything
+// runs without OpenGL, the window uses it between the frustum query and the submission of the main pass.
+class OcclusionBuffer {
+public:
+    static const int DEFAULT_WIDTH = 256;
+    static const int DEFAULT_HEIGHT = 128;
+
+    // Instruction set of the rasterizer, the best one supported by the processor is used by default
+    enum class Kernel {
+        Scalar,
+        SSE
+    };
+
+    explicit OcclusionBuffer(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+    // Start a frame seen through viewProjection, nothing is occluded until occluders are rasterized
+    void clear(const glm::mat4& viewProjection);
+
+    // Queue the box the unit cube from -1 to 1 is mapped to by boxMatrix, it has to be completely hidden inside
+    // the object. Boxes reaching in front of the near plane are skipped.
+    void addOccluder(const glm::mat4& boxMatrix);
+
+    // Draw the queued occluders and build the hierarchical buffer
+    void rasterize();
+
+    // Conservative test of a world space box, false only when it is off screen or behind the occluders
+    bool isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // Depth from 0 at the near to 1 at the far plane of a pixel, row 0 is the bottom of the screen
+    float getDepth(int x, int y) const { return levels.front().depth[y * width + x]; }
+    // Occluders queued since the last clear, the ones crossing the near plane are not counted
+    size_t getOccluderCount() const { return occluders; }
+    // Time in ms the last rasterize took
+    double getRasterTime() const { return rasterTime; }
+
+    static bool isSupported(Kernel kernel);
+    void setKernel(Kernel newKernel) { kernel = newKernel; }
+    Kernel getKernel() const { return kernel; }
+
+    // Threads sharing the rasterization, 0 uses all of them
+    void setThreads(int newThreads) { threads = newThreads; }
+
+    // Screen space triangle with edge functions a * x + b * y + c positive inside and depth as a plane
+    struct Triangle {
+        glm::vec3 edges[3];
+        glm::vec3 depth;
+        int minX, maxX, minY, maxY;
+    };
+
+private:
+    struct Level {
+        int width, height;
+        std::vector<float> depth;
+    };
+
+    void addTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+    void buildLevels();
+
+    int width, height;
+    // Rows of the rasterized buffer are padded to whole groups of 4 pixels for the SSE kernel
+    int stride;
+    std::vector<float> depth;
+    // Level 0 has the size of the screen, every next one half of the previous
+    std::vector<Level> levels;
+
+    glm::mat4 viewProjection{1.0f};
+    std::vector<Triangle> triangles;
+    size_t occluders = 0;
+    double rasterTime = 0.0;
+    Kernel kernel;
+    int threads = 0;
+};
+
+#endif //PPGSO_OCCLUSION_BUFFER_H
@@ -0,0 +1,162 @@
+#include "particle_pool.h"
+#include <ppgso/cpu_features.h>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+    // Particles updated by one thread at a time, large enough to hide the scheduling
+    const size_t BLOCK_SIZE = 16384;
+
+    struct Streams {
+        float *x, *y, *z;
+        float *vx, *vy, *vz;
+        float *age;
+    };
+
+    // Velocity change of one step is the same for every particle
+    struct Step {
+        float dTime;
+        float dvx, dvy, dvz;
+    };
+
+    void integrateScalar(const Streams& s, size_t begin, size_t end, const Step& step) {
+        for (size_t i = begin; i < end; i++) {
+            s.vx[i] += step.dvx;
+            s.vy[i] += step.dvy;
+            s.vz[i] += step.dvz;
+            s.x[i] += s.vx[i] * step.dTime;
+            s.y[i] += s.vy[i] * step.dTime;
+            s.z[i] += s.vz[i] * step.dTime;
+            s.age[i] += step.dTime;
+        }
+    }
+
+#ifdef PPGSO_X86
+    // SSE is part of every x86-64 processor, 4 particles per iteration
+    void integrateSSE(const Streams& s, size_t begin, size_t end, const Step& step) {
+        const __m128 dTime = _mm_set1_ps(step.dTime);
+        const __m128 dvx = _mm_set1_ps(step.dvx), dvy = _mm_set1_ps(step.dvy), dvz = _mm_set1_ps(step.dvz);
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            __m128 vx = _mm_add_ps(_mm_loadu_ps(s.vx + i), dvx);
+            __m128 vy = _mm_add_ps(_mm_loadu_ps(s.vy + i), dvy);
+            __m128 vz = _mm_add_ps(_mm_loadu_ps(s.vz + i), dvz);
+            _mm_storeu_ps(s.vx + i, vx);
+            _mm_storeu_ps(s.vy + i, vy);
+            _mm_storeu_ps(s.vz + i, vz);
+            _mm_storeu_ps(s.x + i, _mm_add_ps(_mm_loadu_ps(s.x + i), _mm_mul_ps(vx, dTime)));
+            _mm_storeu_ps(s.y + i, _mm_add_ps(_mm_loadu_ps(s.y + i), _mm_mul_ps(vy, dTime)));
+            _mm_storeu_ps(s.z + i, _mm_add_ps(_mm_loadu_ps(s.z + i), _mm_mul_ps(vz, dTime)));
+            _mm_storeu_ps(s.age + i, _mm_add_ps(_mm_loadu_ps(s.age + i), dTime));
+        }
+        integrateScalar(s, i, end, step);
+    }
+
+    // Same as SSE with 8 particles per iteration
+    PPGSO_TARGET("avx2") void integrateAVX(const Streams& s, size_t begin, size_t end, const Step& step) {
+        const __m256 dTime = _mm256_set1_ps(step.dTime);
+        const __m256 dvx = _mm256_set1_ps(step.dvx), dvy = _mm256_set1_ps(step.dvy), dvz = _mm256_set1_ps(step.dvz);
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            __m256 vx = _mm256_add_ps(_mm256_loadu_ps(s.vx + i), dvx);
+            __m256 vy = _mm256_add_ps(_mm256_loadu_ps(s.vy + i), dvy);
+            __m256 vz = _mm256_add_ps(_mm256_loadu_ps(s.vz + i), dvz);
+            _mm256_storeu_ps(s.vx + i, vx);
+            _mm256_storeu_ps(s.vy + i, vy);
+            _mm256_storeu_ps(s.vz + i, vz);
+            _mm256_storeu_ps(s.x + i, _mm256_add_ps(_mm256_loadu_ps(s.x + i), _mm256_mul_ps(vx, dTime)));
+            _mm256_storeu_ps(s.y + i, _mm256_add_ps(_mm256_loadu_ps(s.y + i), _mm256_mul_ps(vy, dTime)));
+            _mm256_storeu_ps(s.z + i, _mm256_add_ps(_mm256_loadu_ps(s.z + i), _mm256_mul_ps(vz, dTime)));
+            _mm256_storeu_ps(s.age + i, _mm256_add_ps(_mm256_loadu_ps(s.age + i), dTime));
+        }
+        integrateScalar(s, i, end, step);
+    }
+#endif
+
+    typedef void (*IntegrateFunction)(const Streams&, size_t, size_t, const Step&);
+
+    IntegrateFunction selectIntegrate(ParticlePool::Kernel kernel) {
+#ifdef PPGSO_X86
+        if (kernel == ParticlePool::Kernel::AVX) return integrateAVX;
+        if (kernel == ParticlePool::Kernel::SSE) return integrateSSE;
+#endif
+        return integrateScalar;
+    }
+
+    ParticlePool::Kernel bestKernel() {
+        if (ParticlePool::isSupported(ParticlePool::Kernel::AVX)) return ParticlePool::Kernel::AVX;
+        if (ParticlePool::isSupported(ParticlePool::Kernel::SSE)) return ParticlePool::Kernel::SSE;
+        return ParticlePool::Kernel::Scalar;
+    }
+}
+
+ParticlePool::ParticlePool(size_t capacity)
+        : arrays(ARRAY_COUNT * capacity), capacity(capacity), kernel(bestKernel()) {}
+
+bool ParticlePool::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#ifdef PPGSO_X86
+        case Kernel::SSE:
+            return true;
+        case Kernel::AVX:
+            return ppgso::cpuSupportsAVX2();
+#endif
+        default:
+            return false;
+    }
+}
+
+bool ParticlePool::spawn(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color,
+                         float lifetime) {
+    if (count == capacity) return false;
+    const float values[ARRAY_COUNT] = {position.x, position.y, position.z, velocity.x, velocity.y, velocity.z,
+                                       color.r, color.g, color.b, 0.0f, lifetime};
+    for (int array = 0; array < ARRAY_COUNT; array++)
+        arrays[array * capacity + count] = values[array];
+    count++;
+    return true;
+}
+
+void ParticlePool::integrate(float dTime, const glm::vec3& acceleration) {
+    Streams streams{stream(X), stream(Y), stream(Z),
+                    stream(VELOCITY_X), stream(VELOCITY_Y), stream(VELOCITY_Z), stream(AGE)};
+    Step step{dTime, acceleration.x * dTime, acceleration.y * dTime, acceleration.z * dTime};
+    auto function = selectIntegrate(kernel);
+
+    // Blocks are independent, every thread takes whole blocks so no two threads write the same cache line
+    long blocks = (long) ((count + BLOCK_SIZE - 1) / BLOCK_SIZE);
+#ifdef _OPENMP
+    int blockThreads = threads > 0 ? threads : omp_get_max_threads();
+    #pragma omp parallel for num_threads(blockThreads) if(blocks > 1)
+#endif
+    for (long block = 0; block < blocks; block++) {
+        size_t begin = block * BLOCK_SIZE;
+        function(streams, begin, std::min(count, begin + BLOCK_SIZE), step);
+    }
+}
+
+void ParticlePool::update(float dTime, const glm::vec3& acceleration, float floor, std::vector<glm::vec3>* landed) {
+    integrate(dTime, acceleration);
+
+    const float* y = stream(Y);
+    const float* age = stream(AGE);
+    const float* lifetime = stream(LIFETIME);
+    size_t i = 0;
+    while (i < count) {
+        bool fell = y[i] < floor;
+        if (!fell && age[i] < lifetime[i]) {
+            i++;
+            continue;
+        }
+        if (fell && landed) landed->emplace_back(stream(X)[i], y[i], stream(Z)[i]);
+
+        // swap remove, the element moved here is checked in the next iteration
+        count--;
+        for (int array = 0; array < ARRAY_COUNT; array++)
+            arrays[array * capacity + i] = arrays[array * capacity + count];
+    }
+}
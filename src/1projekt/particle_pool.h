@@ -0,0 +1,66 @@
+#ifndef PPGSO_PARTICLE_POOL_H
+#define PPGSO_PARTICLE_POOL_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+
+// Fixed capacity structure of arrays storage of particles. Each attribute is one contiguous float array, so the
+// update runs over plain streams of floats and the arrays are uploaded to the GPU without repacking. A dead
+// particle is replaced by the last live one, the live particles always fill the beginning of the arrays.
+class ParticlePool {
+public:
+    enum Array {
+        X, Y, Z,
+        VELOCITY_X, VELOCITY_Y, VELOCITY_Z,
+        RED, GREEN, BLUE,
+        AGE, LIFETIME,
+        ARRAY_COUNT
+    };
+
+    // Instruction set of the update kernel, the best one supported by the processor is used by default
+    enum class Kernel {
+        Scalar,
+        SSE,
+        AVX
+    };
+
+    explicit ParticlePool(size_t capacity);
+
+    // Add a particle, returns false when the pool is full
+    bool spawn(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color, float lifetime);
+
+    // Move all particles by one step and remove the dead ones. Particles die when their age reaches the
+    // lifetime or when they fall below the floor, positions of the latter are appended to landed.
+    void update(float dTime, const glm::vec3& acceleration, float floor, std::vector<glm::vec3>* landed = nullptr);
+
+    // Only the integration of velocities, positions and ages, without removing dead particles
+    void integrate(float dTime, const glm::vec3& acceleration);
+
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    size_t getCapacity() const { return capacity; }
+
+    // First element of an array, valid up to size()
+    const float* data(Array array) const { return arrays.data() + array * capacity; }
+
+    static bool isSupported(Kernel kernel);
+    void setKernel(Kernel newKernel) { kernel = newKernel; }
+    Kernel getKernel() const { return kernel; }
+
+    // Threads sharing the update, 0 uses all of them
+    void setThreads(int newThreads) { threads = newThreads; }
+
+private:
+    float* stream(Array array) { return arrays.data() + array * capacity; }
+
+    std::vector<float> arrays;
+    size_t capacity;
+    size_t count = 0;
+    Kernel kernel;
+    int threads = 0;
+};
+
+#endif //PPGSO_PARTICLE_POOL_H
@@ -0,0 +1,11 @@
+#include "particle_system.h"
+#include "cpu_particle_system.h"
+#include "gpu_particle_system.h"
+
+constexpr float ParticleSystem::RAIN_FLOOR;
+constexpr float ParticleSystem::PARTICLE_RADIUS;
+
+std::unique_ptr<ParticleSystem> ParticleSystem::create(bool gpu, size_t rainCapacity, size_t splashCapacity) {
+    if (gpu) return std::make_unique<GpuParticleSystem>(rainCapacity + splashCapacity);
+    return std::make_unique<CpuParticleSystem>(rainCapacity, splashCapacity);
+}
@@ -0,0 +1,42 @@
+#ifndef PPGSO_PARTICLE_SYSTEM_H
+#define PPGSO_PARTICLE_SYSTEM_H
+
+#include "renderable.h"
+#include <ppgso/ppgso.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <memory>
+
+// Rain drops and their splashes drawn as round point sprites with a single draw call. Drops are pushed by the
+// wind and burst into splashes when they hit the ground, splashes fall under gravity and shrink until their
+// lifetime ends. The simulation runs either on the CPU or on the GPU, see CpuParticleSystem and GpuParticleSystem.
+class ParticleSystem : public Renderable {
+public:
+    // Drops disappear only when they reach the ground
+    static constexpr float RAIN_FLOOR = 0.5f;
+    // Radius of a new particle in world units
+    static constexpr float PARTICLE_RADIUS = 0.05f;
+
+    // Simulation on the GPU with transform feedback, or on the CPU with uploads every frame
+    static std::unique_ptr<ParticleSystem> create(bool gpu, size_t rainCapacity, size_t splashCapacity);
+
+    virtual void spawnRain(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color) = 0;
+    virtual void spawnSplash(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color,
+                             float lifetime) = 0;
+    void setWind(const glm::vec3& newWind) { wind = newWind; }
+
+    // Live particles, the GPU simulation reports them with a delay of a few frames
+    virtual size_t size() const = 0;
+    // Time in ms the last update took on the CPU
+    double getUpdateTime() const { return updateTime; }
+
+    // Particles cast no shadows
+    void renderDepth(ppgso::Shader& depthShader) override {}
+    void submitDepth(RenderQueue& queue) override {}
+
+protected:
+    glm::vec3 wind{0.0f};
+    double updateTime = 0.0;
+};
+
+#endif //PPGSO_PARTICLE_SYSTEM_H
@@ -1,18 +1,14 @@
 #include "plane.h"
+#include "render_queue.h"
 #include "camera.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <shaders/texture_vert_glsl.h>
-#include <shaders/texture_frag_glsl.h>
+#include "scene_shader.h"
 
-std::unique_ptr<ppgso::Mesh> Plane::mesh;
-std::unique_ptr<ppgso::Shader> Plane::shader;
-std::unique_ptr<ppgso::Texture> Plane::texture;
-glm::vec3 Plane::ambientLightColor = glm::vec3(0.8f, 0.7f, 0.6f);
+std::shared_ptr<ppgso::Mesh> Plane::mesh;
 
-Plane::Plane(const glm::vec3& position) : position(position) {
-    if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("quad.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("models/asphalt.bmp"));
+Plane::Plane(const std::string& textureFilename, const glm::vec3& position) : position(position) {
+    if (!mesh) mesh = ppgso::AssetCache::instance().mesh("quad.obj", ppgso::VertexFormat::Packed);
+    texture = ppgso::AssetCache::instance().texture(textureFilename);
 }
 
 bool Plane::update(float dTime, Scene &scene) {
@@ -20,43 +16,62 @@ bool Plane::update(float dTime, Scene &scene) {
 }
 
 ppgso::Shader* Plane::getShader() const {
-    return shader.get();
+    return SceneShader::get().shader;
 }
 
 void Plane::renderDepth(ppgso::Shader& depthShader) {
     depthShader.use();
 
+    depthShader.setUniform(depthModelMatrix, getDepthModelMatrix());
+
+    mesh->render();
+}
+
+glm::mat4 Plane::getModelMatrix() const {
+    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
+    modelMatrix = glm::rotate(modelMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(modelMatrix, glm::vec3(5.0f));
+}
+
+glm::mat4 Plane::getDepthModelMatrix() const {
     glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
     modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0.0f, 1.0f, 0.0f));
+    return glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0.0f, 1.0f, 0.0f));
+}
 
-    depthShader.setUniform("ModelMatrix", modelMatrix);
+void Plane::submit(RenderQueue& queue) {
+    queue.submit(this, getShader(), texture.get(), mesh.get(), position);
+}
 
-    mesh->render();
+void Plane::submitDepth(RenderQueue& queue) {
+    queue.submitDepth(this, mesh.get());
 }
 
+bool Plane::getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    // the shadow pass draws the quad somewhere else, the box covers both
+    glm::vec3 depthMin, depthMax;
+    if (!getMeshBounds(*mesh, getModelMatrix(), boundsMin, boundsMax) ||
+        !getMeshBounds(*mesh, getDepthModelMatrix(), depthMin, depthMax))
+        return false;
+    boundsMin = glm::min(boundsMin, depthMin);
+    boundsMax = glm::max(boundsMax, depthMax);
+    return true;
+}
 
 void Plane::render(const Camera& camera) {
+    auto variant = SceneShader::get();
+    auto shader = variant.shader;
+    const auto& uniforms = *variant.uniforms;
     shader->use();
-    shader->setUniform("Texture", *texture);
-
-    shader->setUniform("AmbientLightColor", ambientLightColor);
-
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
-
-    modelMatrix = glm::translate(modelMatrix, position);
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0.0f, 0.0f, 1.0f));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(5.0f));
+    shader->setUniform(uniforms.texture, *texture);
 
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("ViewMatrix", camera.viewMatrix);
-    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
+    shader->setUniform(uniforms.modelMatrix, getModelMatrix());
 
-    shader->setUniform("material.ambient", glm::vec3(1.0f, 1.0f, 1.0f));
-    shader->setUniform("material.diffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-    shader->setUniform("material.specular", glm::vec3(0.5f, 0.5f, 0.5f));
-    shader->setUniform("material.shininess", 32.0f);
+    shader->setUniform(uniforms.materialAmbient, glm::vec3(1.0f, 1.0f, 1.0f));
+    shader->setUniform(uniforms.materialDiffuse, glm::vec3(1.0f, 1.0f, 1.0f));
+    shader->setUniform(uniforms.materialSpecular, glm::vec3(0.5f, 0.5f, 0.5f));
+    shader->setUniform(uniforms.materialShininess, 32.0f);
 
     mesh->render();
 }
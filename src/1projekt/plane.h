@@ -4,23 +4,31 @@
 #include "renderable.h"
 #include <ppgso/ppgso.h>
 #include <memory>
+#include <string>
 
+// Flat quad of a grid cell, the roads and the crossings differ only in their texture
 class Plane final : public Renderable {
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    std::shared_ptr<ppgso::Texture> texture;
 
     glm::vec3 position;
     glm::vec3 scale = {1.0f, 1.0f, 1.0f};
     float rotation = 0.0f;
 
+    glm::mat4 getModelMatrix() const;
+    // The shadow pass places the quad differently from the main pass
+    glm::mat4 getDepthModelMatrix() const;
+
 public:
-    static glm::vec3 ambientLightColor;
     ppgso::Shader* getShader() const override;
     void renderDepth(ppgso::Shader& depthShader) override;
+    void submit(RenderQueue& queue) override;
+    void submitDepth(RenderQueue& queue) override;
+    bool getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const override;
+    bool isStatic() const override { return true; }
 
 
-    explicit Plane(const glm::vec3& position = {0.0f, 0.0f, 0.0f});
+    explicit Plane(const std::string& textureFilename, const glm::vec3& position = {0.0f, 0.0f, 0.0f});
 
     void setRotation(float angle) { rotation = angle; }
 
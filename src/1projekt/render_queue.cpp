@@ -0,0 +1,101 @@
+#include "render_queue.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Bit layout of the keys, the pass always takes the two highest bits
+    const unsigned PASS_SHIFT = 62;
+    const unsigned DEPTH_BITS = 24;
+    const unsigned SHADER_BITS = 12;
+    const unsigned TEXTURE_BITS = 13;
+    const unsigned MESH_BITS = 13;
+
+    std::uint64_t field(std::uint64_t value, unsigned bits, unsigned shift) {
+        return (value & ((std::uint64_t(1) << bits) - 1)) << shift;
+    }
+}
+
+void RenderQueue::clear(const Camera& camera) {
+    items.clear();
+    viewMatrix = camera.viewMatrix;
+}
+
+void RenderQueue::submit(Renderable* object, ppgso::Shader* shader, const void* texture, const void* mesh,
+                         const glm::vec3& position, RenderPass pass) {
+    std::uint64_t key = static_cast<std::uint64_t>(pass) << PASS_SHIFT;
+    std::uint64_t depth = getDepth(position);
+
+    if (pass == RenderPass::Transparent) {
+        // back to front first, state only breaks ties between items at the same depth
+        key |= field(~depth, DEPTH_BITS, SHADER_BITS + TEXTURE_BITS + MESH_BITS);
+        key |= field(getId(shader), SHADER_BITS, TEXTURE_BITS + MESH_BITS);
+        key |= field(getId(texture), TEXTURE_BITS, MESH_BITS);
+        key |= field(getId(mesh), MESH_BITS, 0);
+    } else {
+        // state groups first, front to back inside a group so early depth testing rejects hidden fragments
+        key |= field(getId(shader), SHADER_BITS, TEXTURE_BITS + MESH_BITS + DEPTH_BITS);
+        key |= field(getId(texture), TEXTURE_BITS, MESH_BITS + DEPTH_BITS);
+        key |= field(getId(mesh), MESH_BITS, DEPTH_BITS);
+        key |= field(depth, DEPTH_BITS, 0);
+    }
+
+    items.push_back({key, object, shader, texture});
+}
+
+void RenderQueue::submitDepth(Renderable* object, const void* mesh, size_t lod) {
+    items.push_back({getId(mesh) << 8 | std::min<size_t>(lod, 0xff), object, nullptr, nullptr});
+}
+
+void RenderQueue::sort() {
+    // least significant digit first, 8 bits per pass, a pass is skipped when all keys share the digit
+    scratch.resize(items.size());
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (const auto& item : items) counts[(item.key >> shift) & 0xff]++;
+        if (counts[(items.empty() ? 0 : items.front().key >> shift) & 0xff] == items.size()) continue;
+
+        size_t offset = 0;
+        for (auto& count : counts) {
+            size_t next = offset + count;
+            count = offset;
+            offset = next;
+        }
+        for (const auto& item : items) scratch[counts[(item.key >> shift) & 0xff]++] = item;
+        items.swap(scratch);
+    }
+}
+
+RenderPass RenderQueue::getPass(const Item& item) {
+    return static_cast<RenderPass>(item.key >> PASS_SHIFT);
+}
+
+void RenderQueue::countChanges() {
+    auto& frame = stats();
+    const ppgso::Shader* shader = nullptr;
+    const void* texture = nullptr;
+    for (const auto& item : items) {
+        if (item.shader != shader) frame.shaderChanges++;
+        if (item.texture != texture) frame.textureChanges++;
+        shader = item.shader;
+        texture = item.texture;
+    }
+    frame.items += items.size();
+}
+
+std::uint64_t RenderQueue::getId(const void* pointer) {
+    if (!pointer) return 0;
+    auto found = ids.find(pointer);
+    if (found != ids.end()) return found->second;
+    std::uint64_t id = ids.size() + 1;
+    ids.emplace(pointer, id);
+    return id;
+}
+
+std::uint64_t RenderQueue::getDepth(const glm::vec3& position) const {
+    // the bit pattern of a positive float grows with its value, its top bits keep the order
+    float distance = -(viewMatrix * glm::vec4(position, 1.0f)).z;
+    if (!(distance > 0.0f)) return 0;
+    std::uint32_t bits;
+    std::memcpy(&bits, &distance, sizeof(bits));
+    return bits >> (32 - DEPTH_BITS);
+}
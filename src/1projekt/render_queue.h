@@ -0,0 +1,80 @@
+#ifndef PPGSO_RENDER_QUEUE_H
+#define PPGSO_RENDER_QUEUE_H
+
+#include "camera.h"
+#include <ppgso/ppgso.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Renderable;
+
+// Passes in the order they are drawn, the pass is the most significant part of the sort key
+enum class RenderPass : std::uint64_t {
+    Opaque = 0,
+    Skybox = 1,
+    Transparent = 2
+};
+
+// Draw items of one pass collected every frame and sorted by a 64 bit key, so objects sharing a shader,
+// texture and mesh are drawn one after another. Opaque items are drawn front to back inside their state
+// group, transparent ones back to front. The depth queue only groups items by mesh.
+class RenderQueue {
+public:
+    struct Item {
+        std::uint64_t key;
+        Renderable* object;
+        ppgso::Shader* shader;
+        const void* texture;
+    };
+
+    // Items submitted, shader changes and texture changes of the main pass, accumulated until the window
+    // reports and resets them
+    struct Stats {
+        size_t items = 0;
+        size_t shaderChanges = 0;
+        size_t textureChanges = 0;
+    };
+
+    static Stats& stats() {
+        static Stats frameStats;
+        return frameStats;
+    }
+
+    // Start a new frame, depth is measured along the view direction of the camera
+    void clear(const Camera& camera);
+
+    // Main pass item, texture and mesh only identify the state and may be null
+    void submit(Renderable* object, ppgso::Shader* shader, const void* texture, const void* mesh,
+                const glm::vec3& position, RenderPass pass = RenderPass::Opaque);
+
+    // Shadow map item, all of them share the depth shader. Items of a mesh are ordered by level of detail, so
+    // instanced objects of the same level follow each other.
+    void submitDepth(Renderable* object, const void* mesh, size_t lod = 0);
+
+    // Radix sort of the items by key
+    void sort();
+
+    const std::vector<Item>& getItems() const { return items; }
+
+    // Pass of a main pass item
+    static RenderPass getPass(const Item& item);
+
+    // Count the shader and texture changes of the sorted items into the stats
+    void countChanges();
+
+private:
+    // Small ids of shaders, textures and meshes, stable across frames
+    std::uint64_t getId(const void* pointer);
+    // Distance to the camera quantized to 24 bits, larger distances give larger values
+    std::uint64_t getDepth(const glm::vec3& position) const;
+
+    std::vector<Item> items;
+    std::vector<Item> scratch;
+    std::unordered_map<const void*, std::uint64_t> ids;
+    glm::mat4 viewMatrix{1.0f};
+};
+
+#endif //PPGSO_RENDER_QUEUE_H
@@ -0,0 +1,20 @@
+#include "renderable.h"
+
+int Renderable::depthCascade = 0;
+ppgso::UniformHandle Renderable::depthModelMatrix;
+
+bool Renderable::getMeshBounds(const ppgso::MeshBase& mesh, const glm::mat4& modelMatrix,
+                               glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    glm::vec3 meshMin = mesh.getBoundsMin(), meshMax = mesh.getBoundsMax();
+    if (meshMin.x > meshMax.x) return false;
+
+    // half size along every world axis is the sum of the rotated and scaled half sizes of the mesh box
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((meshMin + meshMax) * 0.5f, 1.0f));
+    glm::vec3 halfSize = (meshMax - meshMin) * 0.5f;
+    glm::vec3 extent = glm::abs(glm::vec3(modelMatrix[0])) * halfSize.x
+                       + glm::abs(glm::vec3(modelMatrix[1])) * halfSize.y
+                       + glm::abs(glm::vec3(modelMatrix[2])) * halfSize.z;
+    boundsMin = center - extent;
+    boundsMax = center + extent;
+    return true;
+}
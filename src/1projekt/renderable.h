@@ -6,6 +6,8 @@
 #include <ppgso.h>
 
 class Camera; // Forward declaration
+class RenderQueue; // Forward declaration
+class GpuCulling; // Forward declaration
 
 class Renderable; // Forward declaration
 using Scene = std::list<std::unique_ptr<Renderable>>; // Type alias
@@ -18,10 +20,30 @@ public:
     virtual bool update(float dTime, Scene &scene) = 0;
     virtual ppgso::Shader* getShader() const = 0;
     virtual void renderDepth(ppgso::Shader& depthShader) = 0;
-
-    static glm::mat4 lightSpaceMatrix;
-    static GLuint depthMap;
-
+    // Add the object to the sorted queues of the main and depth pass, objects without shadows skip the latter
+    virtual void submit(RenderQueue& queue) = 0;
+    virtual void submitDepth(RenderQueue& queue) = 0;
+    // World space box around everything the object draws in both passes for the spatial index, false while the
+    // mesh is loading and for objects drawn from everywhere, which are never culled
+    virtual bool getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const { return false; }
+    // Bounds of static objects are indexed once, the others are refreshed after every update
+    virtual bool isStatic() const { return false; }
+    // Box completely hidden inside the object as the matrix mapping the unit cube from -1 to 1 onto it, for the
+    // occlusion culling of everything behind it. Only large solid objects have one.
+    virtual bool getOccluder(glm::mat4& boxMatrix) const { return false; }
+    // Hand the object over to the culling on the GPU, which draws it from then on. Only loaded static instanced
+    // objects can be culled there.
+    virtual bool addToGpuCulling(GpuCulling& culling) const { return false; }
+
+    // Shadow cascade the depth pass is drawing, for depth shaders other than the one passed to renderDepth
+    static int depthCascade;
+    // ModelMatrix of the depth shader passed to renderDepth
+    static ppgso::UniformHandle depthModelMatrix;
+
+protected:
+    // Box of the mesh placed by modelMatrix, the world space box around its rotated corners
+    static bool getMeshBounds(const ppgso::MeshBase& mesh, const glm::mat4& modelMatrix,
+                              glm::vec3& boundsMin, glm::vec3& boundsMax);
 };
 
 #endif //PPGSO_RENDERABLE_H
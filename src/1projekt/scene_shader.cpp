@@ -0,0 +1,106 @@
+#include "scene_shader.h"
+#include "frame_uniforms.h"
+#include "light_clusters.h"
+#include <shaders/scene_vert_glsl.h>
+#include <shaders/scene_frag_glsl.h>
+#include <shaders/gbuffer_frag_glsl.h>
+#include <map>
+#include <set>
+
+namespace {
+    // Values of POINT_LIGHTS the variants are compiled with, up to the lights of one cluster
+    const int LIGHT_COUNTS[] = {0, 4, 8, 16, LightClusters::MAX_CLUSTER_LIGHTS};
+    const size_t LIGHT_COUNT_VARIANTS = sizeof(LIGHT_COUNTS) / sizeof(LIGHT_COUNTS[0]);
+    // Levels of detail from which objects are far enough for 4 lights and no shadow filtering
+    const size_t DISTANT_LOD = 2;
+    const int DISTANT_LIGHTS = 4;
+
+    ppgso::ShaderVariants& variants() {
+        static ppgso::ShaderVariants sceneVariants{FrameUniforms::declare(scene_vert_glsl),
+                                                   FrameUniforms::declare(scene_frag_glsl), [](ppgso::Shader& shader) {
+            FrameUniforms::bindBlocks(shader);
+            LightClusters::bindSamplers(shader);
+            shader.setUniform(shader.getUniform("ShadowMap"), 1);
+        }};
+        return sceneVariants;
+    }
+
+    // Geometry pass of the deferred path, lit later by DeferredShading
+    ppgso::ShaderVariants& gBufferVariants() {
+        static ppgso::ShaderVariants variants{FrameUniforms::declare(scene_vert_glsl), gbuffer_frag_glsl,
+                                              [](ppgso::Shader& shader) { FrameUniforms::bindBlocks(shader); }};
+        return variants;
+    }
+
+    std::set<const ppgso::Shader*>& gBufferShaders() {
+        static std::set<const ppgso::Shader*> shaders;
+        return shaders;
+    }
+
+    const ObjectUniforms* getUniforms(const ppgso::Shader* shader) {
+        static std::map<const ppgso::Shader*, ObjectUniforms> uniforms;
+        auto found = uniforms.find(shader);
+        if (found == uniforms.end())
+            found = uniforms.emplace(shader, ObjectUniforms{*shader}).first;
+        return &found->second;
+    }
+}
+
+int SceneShader::activeLights = 0;
+bool SceneShader::deferred = false;
+
+void SceneShader::setActiveLights(int count) {
+    activeLights = count;
+}
+
+void SceneShader::setDeferred(bool enabled) {
+    deferred = enabled;
+}
+
+bool SceneShader::writesGBuffer(const ppgso::Shader* shader) {
+    return gBufferShaders().count(shader) > 0;
+}
+
+SceneShader::Variant SceneShader::get(size_t lod, bool shadows, bool instanced) {
+    // Lights and shadow filtering are up to the lighting pass, only what the G-buffer stores varies
+    if (deferred) {
+        static Variant gBufferCache[2][2];
+        auto& variant = gBufferCache[shadows][instanced];
+        if (!variant.shader) {
+            variant.shader = &gBufferVariants().get({{"SHADOWS", shadows ? 1 : 0},
+                                                     {"INSTANCED", instanced ? 1 : 0}});
+            variant.uniforms = getUniforms(variant.shader);
+            gBufferShaders().insert(variant.shader);
+        }
+        return variant;
+    }
+
+    // Fewest lights covering the most crowded cluster, the shader stops at the count of its cluster anyway
+    size_t lights = 0;
+    while (lights + 1 < LIGHT_COUNT_VARIANTS && LIGHT_COUNTS[lights] < activeLights) lights++;
+
+    bool distant = lod >= DISTANT_LOD;
+    if (distant) {
+        while (lights > 0 && LIGHT_COUNTS[lights] > DISTANT_LIGHTS) lights--;
+    }
+    int pcf = distant || !shadows ? 1 : 3;
+
+    // Objects draw every frame, so the variants are looked up by index instead of by their defines
+    static Variant cache[LIGHT_COUNT_VARIANTS][2][2][2];
+    auto& variant = cache[lights][shadows][distant][instanced];
+    if (!variant.shader) {
+        variant.shader = &variants().get({{"POINT_LIGHTS", LIGHT_COUNTS[lights]},
+                                          {"SHADOWS", shadows ? 1 : 0},
+                                          {"PCF", pcf},
+                                          {"INSTANCED", instanced ? 1 : 0},
+                                          {"CLUSTER_TILES_X", LightClusters::TILES_X},
+                                          {"CLUSTER_TILES_Y", LightClusters::TILES_Y},
+                                          {"CLUSTER_SLICES", LightClusters::SLICES}});
+        variant.uniforms = getUniforms(variant.shader);
+    }
+    return variant;
+}
+
+size_t SceneShader::getVariantCount() {
+    return variants().size() + gBufferVariants().size();
+}
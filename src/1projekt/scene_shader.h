@@ -0,0 +1,41 @@
+#ifndef PPGSO_SCENE_SHADER_H
+#define PPGSO_SCENE_SHADER_H
+
+#include "object_uniforms.h"
+#include <ppgso/ppgso.h>
+#include <cstddef>
+
+
+// Variants of the lit scene shader shared by all textured objects. Each object asks for the cheapest one
+// that fits how it is drawn, so fragments loop over no more lights than the fullest cluster holds and distant objects
+// use fewer lights and a smaller shadow filter.
+class SceneShader {
+public:
+    struct Variant {
+        ppgso::Shader* shader = nullptr;
+        const ObjectUniforms* uniforms = nullptr;
+    };
+
+    // Most point lights in one light cluster this frame, set by the window before objects are drawn
+    static void setActiveLights(int count);
+
+    // Hand out the G-buffer variants of the deferred path instead of the lit ones, switched between frames
+    static void setDeferred(bool enabled);
+    static bool isDeferred() { return deferred; }
+
+    // Variant writing the G-buffer, drawn before the lighting pass
+    static bool writesGBuffer(const ppgso::Shader* shader);
+
+    // Variant for an object drawn at a level of detail, objects that are never shadowed skip the shadow map.
+    // Instanced variants take the model matrix from the instance attributes instead of the uniform.
+    static Variant get(size_t lod = 0, bool shadows = true, bool instanced = false);
+
+    // Number of variants compiled so far
+    static size_t getVariantCount();
+
+private:
+    static int activeLights;
+    static bool deferred;
+};
+
+#endif //PPGSO_SCENE_SHADER_H
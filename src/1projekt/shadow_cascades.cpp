@@ -0,0 +1,113 @@
+#include "shadow_cascades.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Weight of the logarithmic split distribution, the rest is uniform
+    const float SPLIT_LAMBDA = 0.75f;
+    // Distance behind the volumes towards the sun from which buildings still cast into them
+    const float CASTER_RANGE = 100.0f;
+    const float BIAS_TEXELS = 1.5f;
+}
+
+const int ShadowCascades::CASCADES;
+const int ShadowCascades::MAP_SIZE;
+
+ShadowCascades::ShadowCascades() {
+    glGenTextures(1, &texture);
+    ppgso::GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, MAP_SIZE, MAP_SIZE, CASCADES, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // shadow samplers compare in the texture unit, with linear filtering every lookup blends four comparisons
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glGenFramebuffers(1, &framebuffer);
+    ppgso::GLState::bindFramebuffer(framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    ppgso::GLState::bindFramebuffer(0);
+
+    for (auto& matrix : matrices) matrix = glm::mat4(1.0f);
+}
+
+ShadowCascades::~ShadowCascades() {
+    ppgso::GLState::deleteFramebuffer(framebuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+    ppgso::GLState::deleteTexture(texture);
+    glDeleteTextures(1, &texture);
+}
+
+void ShadowCascades::update(const Camera& camera, const glm::vec3& sunDirection) {
+    // Perspective projection without skew, near and far come back from its depth terms
+    const glm::mat4& projection = camera.projectionMatrix;
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+
+    // Corners of the near and far plane in world space, a corner at a depth between them lies on the line
+    // joining the two
+    glm::mat4 inverseViewProjection = glm::inverse(projection * camera.viewMatrix);
+    glm::vec3 nearCorners[4], farCorners[4];
+    for (int corner = 0; corner < 4; corner++) {
+        glm::vec2 ndc{corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f};
+        glm::vec4 nearCorner = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+        glm::vec4 farCorner = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+        nearCorners[corner] = glm::vec3(nearCorner) / nearCorner.w;
+        farCorners[corner] = glm::vec3(farCorner) / farCorner.w;
+    }
+
+    glm::vec3 direction = glm::normalize(sunDirection);
+    glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    float splitNear = nearPlane;
+    for (int cascade = 0; cascade < CASCADES; cascade++) {
+        float fraction = (float) (cascade + 1) / CASCADES;
+        float splitFar = SPLIT_LAMBDA * nearPlane * std::pow(farPlane / nearPlane, fraction) +
+                         (1.0f - SPLIT_LAMBDA) * (nearPlane + (farPlane - nearPlane) * fraction);
+        splits[cascade] = splitFar;
+
+        glm::vec3 corners[8];
+        glm::vec3 center{0.0f};
+        for (int corner = 0; corner < 4; corner++) {
+            glm::vec3 ray = farCorners[corner] - nearCorners[corner];
+            corners[corner] = nearCorners[corner] + ray * ((splitNear - nearPlane) / (farPlane - nearPlane));
+            corners[corner + 4] = nearCorners[corner] + ray * ((splitFar - nearPlane) / (farPlane - nearPlane));
+            center += corners[corner] + corners[corner + 4];
+        }
+        center /= 8.0f;
+
+        // The sphere does not change with the orientation of the camera, rounding keeps it from flickering in
+        // the last bits
+        float radius = 0.0f;
+        for (auto& corner : corners) radius = std::max(radius, glm::distance(corner, center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        float depthRange = 2.0f * radius + CASTER_RANGE;
+        glm::mat4 lightView = glm::lookAt(center - direction * (radius + CASTER_RANGE), center, up);
+        glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, depthRange);
+
+        // Move the volume by whole texels, a point of the world then always falls on the same spot of a texel
+        glm::vec4 origin = lightProjection * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        glm::vec2 texels = glm::vec2(origin) * (MAP_SIZE * 0.5f);
+        glm::vec2 offset = (glm::round(texels) - texels) / (MAP_SIZE * 0.5f);
+        lightProjection[3][0] += offset.x;
+        lightProjection[3][1] += offset.y;
+
+        matrices[cascade] = lightProjection * lightView;
+        bias[cascade] = BIAS_TEXELS * (2.0f * radius / MAP_SIZE) / depthRange;
+        splitNear = splitFar;
+    }
+}
+
+void ShadowCascades::beginCascade(int cascade) {
+    ppgso::GLState::bindFramebuffer(framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, cascade);
+    ppgso::GLState::viewport(0, 0, MAP_SIZE, MAP_SIZE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
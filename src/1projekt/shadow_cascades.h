@@ -0,0 +1,48 @@
+#ifndef PPGSO_SHADOW_CASCADES_H
+#define PPGSO_SHADOW_CASCADES_H
+
+#include "camera.h"
+#include <ppgso/ppgso.h>
+#include <glm/glm.hpp>
+
+
+// Cascaded shadow maps of the sun in the layers of one depth texture array. The camera frustum is split in depth
+// between a logarithmic and a uniform distribution, and every split gets its own orthographic light volume
+// around the bounding sphere of its corners. Near splits are small, so street level gets dense texels, while the
+// last one still reaches the far plane. The volumes keep their size while the camera turns and move in whole
+// texels, so shadow edges do not shimmer. Four 512x512 layers hold as many texels as the old 1024x1024 map.
+class ShadowCascades {
+public:
+    static const int CASCADES = 4;
+    static const int MAP_SIZE = 512;
+
+    ShadowCascades();
+    ~ShadowCascades();
+    ShadowCascades(const ShadowCascades&) = delete;
+    ShadowCascades& operator=(const ShadowCascades&) = delete;
+
+    // Fit the light volumes to the splits of the camera frustum, sunDirection points from the sun to the scene
+    void update(const Camera& camera, const glm::vec3& sunDirection);
+
+    // Bind and clear the layer of a cascade for the depth pass, the viewport is set to the map
+    void beginCascade(int cascade);
+
+    // Light space matrix of a cascade, its volume also culls the casters drawn into it
+    const glm::mat4& getMatrix(int cascade) const { return matrices[cascade]; }
+    // View space depths at which the cascades end, for the FrameData block
+    glm::vec4 getSplits() const { return splits; }
+    // Depth bias of every cascade, one and a half of its texels in the depth range of its volume
+    glm::vec4 getBias() const { return bias; }
+
+    GLuint getTexture() const { return texture; }
+
+private:
+    glm::mat4 matrices[CASCADES];
+    glm::vec4 splits{0.0f};
+    glm::vec4 bias{0.0f};
+
+    GLuint framebuffer = 0;
+    GLuint texture = 0;
+};
+
+#endif //PPGSO_SHADOW_CASCADES_H
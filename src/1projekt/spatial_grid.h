@@ -0,0 +1,244 @@
+#ifndef PPGSO_SPATIAL_GRID_H
+#define PPGSO_SPATIAL_GRID_H
+
+#include "frustum.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+
+// Loose uniform grid over the ground plane indexing items by their world space bounding boxes. Cells are laid
+// out like the cells of Grid, cell (column, row) is centered at origin + (column, 0, row) * cellSize. An item
+// belongs to the cell containing the center of its box as long as the box stays within half a cell of the cell
+// border, so queries only look half a cell around their region. Larger items and items off the grid are kept
+// in an overflow cell visited by every query. Every cell keeps the box around its items and queries skip whole
+// cells by testing it first.
+template <typename T>
+class SpatialGrid {
+public:
+    using Handle = size_t;
+
+    SpatialGrid(const glm::vec3& origin, float cellSize, int columns, int rows)
+            : origin(origin), cellSize(cellSize), columns(columns), rows(rows), cells(columns * rows + 1) {}
+
+    // Add an item with its box in world space, the handle stays valid until the item is removed
+    Handle insert(const T& item, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        Handle handle;
+        if (freeHandles.empty()) {
+            handle = entries.size();
+            entries.emplace_back();
+        } else {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        }
+
+        auto& entry = entries[handle];
+        entry.item = item;
+        entry.boundsMin = boundsMin;
+        entry.boundsMax = boundsMax;
+        link(handle, getCell(boundsMin, boundsMax));
+        count++;
+        return handle;
+    }
+
+    Handle insert(const T& item, const glm::vec3& point) { return insert(item, point, point); }
+
+    // Move an item in place, it changes cells only when its box leaves the loose bounds of the current one
+    void update(Handle handle, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        auto& entry = entries[handle];
+        entry.boundsMin = boundsMin;
+        entry.boundsMax = boundsMax;
+
+        size_t cell = getCell(boundsMin, boundsMax);
+        if (cell == entry.cell) {
+            // the cell box only grows here, it shrinks again when an item leaves the cell
+            grow(cells[cell], boundsMin, boundsMax);
+            return;
+        }
+        unlink(handle);
+        link(handle, cell);
+    }
+
+    void update(Handle handle, const glm::vec3& point) { update(handle, point, point); }
+
+    void remove(Handle handle) {
+        unlink(handle);
+        freeHandles.push_back(handle);
+        count--;
+    }
+
+    const T& get(Handle handle) const { return entries[handle].item; }
+    size_t size() const { return count; }
+
+    // Visit the items whose boxes intersect the frustum, cells are searched in the box around its corners
+    template <typename Visitor>
+    void queryFrustum(const Frustum& frustum, Visitor visit) const {
+        auto test = [&](const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+            return frustum.intersects(boundsMin, boundsMax);
+        };
+        visitRegion(frustum.getBoundsMin(), frustum.getBoundsMax(), test,
+                    [&](const Entry& entry) { visit(entry.item); });
+    }
+
+    // Visit the items whose boxes intersect the box
+    template <typename Visitor>
+    void queryBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, Visitor visit) const {
+        auto test = [&](const glm::vec3& otherMin, const glm::vec3& otherMax) {
+            return glm::all(glm::lessThanEqual(boundsMin, otherMax)) &&
+                   glm::all(glm::lessThanEqual(otherMin, boundsMax));
+        };
+        visitRegion(boundsMin, boundsMax, test, [&](const Entry& entry) { visit(entry.item); });
+    }
+
+    // Visit the items whose boxes intersect the sphere
+    template <typename Visitor>
+    void querySphere(const glm::vec3& center, float radius, Visitor visit) const {
+        auto test = [&](const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+            glm::vec3 nearest = glm::clamp(center, boundsMin, boundsMax);
+            glm::vec3 offset = nearest - center;
+            return glm::dot(offset, offset) <= radius * radius;
+        };
+        visitRegion(center - radius, center + radius, test, [&](const Entry& entry) { visit(entry.item); });
+    }
+
+    // Visit the items whose boxes the ray hits within maxDistance, together with the distance along the ray
+    // where it enters the box. Items are visited by cells, not ordered by distance.
+    template <typename Visitor>
+    void queryRay(const glm::vec3& start, const glm::vec3& direction, float maxDistance, Visitor visit) const {
+        glm::vec3 end = start + direction * maxDistance;
+        float distance = 0.0f;
+        auto test = [&](const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+            return intersectRay(start, direction, maxDistance, boundsMin, boundsMax, distance);
+        };
+        visitRegion(glm::min(start, end), glm::max(start, end), test,
+                    [&](const Entry& entry) { visit(entry.item, distance); });
+    }
+
+private:
+    struct Entry {
+        T item{};
+        glm::vec3 boundsMin{0.0f}, boundsMax{0.0f};
+        size_t cell = 0;
+        // Position in the handles of the cell
+        size_t slot = 0;
+    };
+
+    struct Cell {
+        std::vector<Handle> handles;
+        glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+        glm::vec3 boundsMax{-std::numeric_limits<float>::max()};
+    };
+
+    size_t getOverflow() const { return cells.size() - 1; }
+
+    int getColumn(float x) const { return getIndex((x - origin.x) / cellSize, columns); }
+    int getRow(float z) const { return getIndex((z - origin.z) / cellSize, rows); }
+
+    // Cell of a coordinate in cells, -1 or count when it is off the grid, infinite values included
+    static int getIndex(float position, int count) {
+        float index = std::floor(position + 0.5f);
+        return (int) std::max(-1.0f, std::min(index, (float) count));
+    }
+
+    size_t getCell(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        int column = getColumn(center.x), row = getRow(center.z);
+        if (column < 0 || column >= columns || row < 0 || row >= rows) return getOverflow();
+
+        // loose bounds of the cell reach half a cell beyond its border, the center is always inside them
+        glm::vec3 half = (boundsMax - boundsMin) * 0.5f;
+        if (half.x > cellSize * 0.5f || half.z > cellSize * 0.5f) return getOverflow();
+        return (size_t) (row * columns + column);
+    }
+
+    static void grow(Cell& cell, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        cell.boundsMin = glm::min(cell.boundsMin, boundsMin);
+        cell.boundsMax = glm::max(cell.boundsMax, boundsMax);
+    }
+
+    void link(Handle handle, size_t cellIndex) {
+        auto& entry = entries[handle];
+        auto& cell = cells[cellIndex];
+        entry.cell = cellIndex;
+        entry.slot = cell.handles.size();
+        cell.handles.push_back(handle);
+        grow(cell, entry.boundsMin, entry.boundsMax);
+    }
+
+    void unlink(Handle handle) {
+        auto& entry = entries[handle];
+        auto& cell = cells[entry.cell];
+
+        // swap remove, the last handle of the cell takes the slot
+        Handle last = cell.handles.back();
+        cell.handles[entry.slot] = last;
+        entries[last].slot = entry.slot;
+        cell.handles.pop_back();
+
+        // refit the box to the remaining items
+        cell.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        cell.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+        for (auto other : cell.handles) grow(cell, entries[other].boundsMin, entries[other].boundsMax);
+    }
+
+    // Cells whose loose bounds may hold items intersecting the region, plus the overflow cell
+    template <typename Test, typename Visitor>
+    void visitRegion(const glm::vec3& regionMin, const glm::vec3& regionMax, Test test, Visitor visit) const {
+        float margin = cellSize * 0.5f;
+        int firstColumn = std::max(getColumn(regionMin.x - margin), 0);
+        int lastColumn = std::min(getColumn(regionMax.x + margin), columns - 1);
+        int firstRow = std::max(getRow(regionMin.z - margin), 0);
+        int lastRow = std::min(getRow(regionMax.z + margin), rows - 1);
+        visitCells(firstColumn, lastColumn, firstRow, lastRow, test, visit);
+    }
+
+    template <typename Test, typename Visitor>
+    void visitCells(int firstColumn, int lastColumn, int firstRow, int lastRow, Test test, Visitor visit) const {
+        for (int row = firstRow; row <= lastRow; row++)
+            for (int column = firstColumn; column <= lastColumn; column++)
+                visitCell(cells[row * columns + column], test, visit);
+        visitCell(cells[getOverflow()], test, visit);
+    }
+
+    template <typename Test, typename Visitor>
+    void visitCell(const Cell& cell, Test test, Visitor visit) const {
+        if (cell.handles.empty() || !test(cell.boundsMin, cell.boundsMax)) return;
+        for (auto handle : cell.handles) {
+            const auto& entry = entries[handle];
+            if (test(entry.boundsMin, entry.boundsMax)) visit(entry);
+        }
+    }
+
+    // Slab test, distance is where the ray enters the box or 0 when it starts inside
+    static bool intersectRay(const glm::vec3& start, const glm::vec3& direction, float maxDistance,
+                             const glm::vec3& boundsMin, const glm::vec3& boundsMax, float& distance) {
+        float enter = 0.0f, leave = maxDistance;
+        for (int axis = 0; axis < 3; axis++) {
+            if (direction[axis] == 0.0f) {
+                if (start[axis] < boundsMin[axis] || start[axis] > boundsMax[axis]) return false;
+                continue;
+            }
+            float first = (boundsMin[axis] - start[axis]) / direction[axis];
+            float second = (boundsMax[axis] - start[axis]) / direction[axis];
+            enter = std::max(enter, std::min(first, second));
+            leave = std::min(leave, std::max(first, second));
+            if (enter > leave) return false;
+        }
+        distance = enter;
+        return true;
+    }
+
+    glm::vec3 origin;
+    float cellSize;
+    int columns, rows;
+    // Cells by rows, the last one is the overflow cell
+    std::vector<Cell> cells;
+    std::vector<Entry> entries;
+    std::vector<Handle> freeHandles;
+    size_t count = 0;
+};
+
+#endif //PPGSO_SPATIAL_GRID_H
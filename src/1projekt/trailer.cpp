@@ -1,21 +1,16 @@
 #include "trailer.h"
+#include "render_queue.h"
 #include "camera.h"
 #include "renderable.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <shaders/texture_vert_glsl.h>
-#include <shaders/texture_frag_glsl.h>
+#include "scene_shader.h"
 
-std::unique_ptr<ppgso::Shader> Trailer::shader;
 glm::vec3 Trailer::ambientLightColor = glm::vec3(0.8f, 0.7f, 0.6f);
 
 Trailer::Trailer(const std::string& objFilename, const glm::vec3& initialPosition, const std::string& textureFilename)
         : direction(1.0f, 0.0f, 0.0f), boundingBox(glm::vec3(1.0f)), position(initialPosition) {
-    if (!shader) {
-        shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-    }
-
-    mesh = std::make_unique<ppgso::Mesh>(objFilename);
-    texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP(textureFilename));
+    mesh = ppgso::AssetCache::instance().mesh(objFilename, ppgso::VertexFormat::Packed);
+    texture = ppgso::AssetCache::instance().texture(textureFilename);
 
 }
 
@@ -59,42 +54,54 @@ bool Trailer::update(float dTime, Scene& scene) {
 
 void Trailer::render(const Camera& camera) {
     if (crashed) return;
-    shader->use();
+    glm::mat4 modelMatrix = getModelMatrix();
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0, 1, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
-
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("ViewMatrix", camera.viewMatrix);
-    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
+    size_t lod = lodSelector.select(*mesh, modelMatrix, camera);
+    auto variant = SceneShader::get(lod);
+    auto shader = variant.shader;
+    const auto& uniforms = *variant.uniforms;
+    shader->use();
 
-    shader->setUniform("ambientLight", ambientLightColor);
+    shader->setUniform(uniforms.modelMatrix, modelMatrix);
 
-    shader->setUniform("material.ambient", glm::vec3(1.0f));
-    shader->setUniform("material.diffuse", glm::vec3(1.0f));
-    shader->setUniform("material.specular", glm::vec3(1.0f));
-    shader->setUniform("material.shininess", 64.0f);
+    shader->setUniform(uniforms.materialAmbient, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialDiffuse, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialSpecular, glm::vec3(1.0f));
+    shader->setUniform(uniforms.materialShininess, 64.0f);
 
-    shader->setUniform("Texture", *texture);
-    mesh->render();
+    shader->setUniform(uniforms.texture, *texture);
+    mesh->render(lod);
 }
 
 void Trailer::renderDepth(ppgso::Shader& depthShader) {
     if (crashed) return;
     depthShader.use();
 
+    depthShader.setUniform(depthModelMatrix, getModelMatrix());
+    mesh->render(lodSelector.getLod());
+}
+
+glm::mat4 Trailer::getModelMatrix() const {
     glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
     modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation), glm::vec3(0, 1, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+    return glm::scale(modelMatrix, glm::vec3(scale));
+}
 
-    depthShader.setUniform("ModelMatrix", modelMatrix);
-    mesh->render();
+void Trailer::submit(RenderQueue& queue) {
+    queue.submit(this, getShader(), texture.get(), mesh.get(), position);
 }
 
+void Trailer::submitDepth(RenderQueue& queue) {
+    queue.submitDepth(this, mesh.get(), lodSelector.getLod());
+}
+
+
+bool Trailer::getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    return getMeshBounds(*mesh, getModelMatrix(), boundsMin, boundsMax);
+}
 
 ppgso::Shader* Trailer::getShader() const {
-    return shader.get();
+    return SceneShader::get(lodSelector.getLod()).shader;
 }
 
 Car* Trailer::getParentCar() {
@@ -2,6 +2,8 @@
 #define TRAILER_H
 
 #include "renderable.h"
+#include "lod_selector.h"
+#include "scene_shader.h"
 #include "camera.h"
 #include "building.h"
 #include <ppgso/ppgso.h>
@@ -17,12 +19,14 @@ class Trailer : public Renderable {
     bool crashed = false;
     glm::vec3 boundingBox;
 
+    glm::mat4 getModelMatrix() const;
+
 public:
-    std::unique_ptr<ppgso::Mesh> mesh;
-    std::unique_ptr<ppgso::Texture> texture;
+    std::shared_ptr<ppgso::Mesh> mesh;
+    std::shared_ptr<ppgso::Texture> texture;
+    LodSelector lodSelector;
     float scale = 1.0f;
     float rotation = 0.0f;
-    static std::unique_ptr<ppgso::Shader> shader;
     glm::vec3 position;
     static glm::vec3 ambientLightColor;
     bool atIntersection = false;
@@ -35,6 +39,9 @@ public:
 
     void render(const Camera& camera) override;
     void renderDepth(ppgso::Shader& depthShader) override;
+    void submit(RenderQueue& queue) override;
+    void submitDepth(RenderQueue& queue) override;
+    bool getBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const override;
     bool update(float dTime, Scene& scene) override;
 
     ppgso::Shader* getShader() const override;
@@ -45,7 +52,7 @@ public:
     void setScale(float newScale) { scale = newScale; }
     void setRotation(float angle) { rotation = angle; }
     void attachToCar(Car* car) { parentCar = car; }
-    void attachTrashBin(Building* bin) { trashBin = bin; }
+    void attachTrashBin(Building* bin) { trashBin = bin; bin->setStatic(false); }
     Car* getParentCar();
 };
 
@@ -1,26 +1,44 @@
 #include "window.h"
+#include <algorithm>
+#include <limits>
 
 #define SIZEx 1280
 #define SIZEy 720
-#define NR_POINT_LIGHTS 15
-const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
-static std::vector<Car*> Cars;
-
-ParticleWindow::ParticleWindow()
+// time in ms spent uploading streamed assets each frame
+const double ASSET_UPLOAD_BUDGET = 4.0;
+// live particles the particle system has room for
+const size_t RAIN_CAPACITY = 1 << 16, SPLASH_CAPACITY = 1 << 20;
+// spatial indices use the 10 m cells of the city grid, cars drive up to the cell at 100 m
+const float INDEX_CELL_SIZE = 10.0f;
+const int INDEX_CELLS = 11;
+// nearest buildings in the view drawn into the occlusion buffer
+const size_t MAX_OCCLUDERS = 32;
+// distance at which street lamps and headlights fade out, lights are assigned to the clusters within it
+const float POINT_LIGHT_RADIUS = 25.0f;
+
+ParticleWindow::ParticleWindow(bool gpuParticles, bool gpuCulling)
         : Window{"Project_Matuska_Pacuta", SIZEx, SIZEy},
+          carIndex{glm::vec3(0.0f), INDEX_CELL_SIZE, INDEX_CELLS, INDEX_CELLS},
+          lampIndex{glm::vec3(0.0f), INDEX_CELL_SIZE, INDEX_CELLS, INDEX_CELLS},
+          sceneIndex{glm::vec3(0.0f), INDEX_CELL_SIZE, INDEX_CELLS, INDEX_CELLS},
           camera{60.0f, (float)width / (float)height, 0.1f, 100.0f},
           lastX(width / 2.0f), lastY(height / 2.0f), firstMouse(true), sensitivity(0.1f),
           wind(0.0f, 0.0f, 0.0f),
-          depthShader(depth_vert_glsl, depth_frag_glsl){
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+          depthShader(FrameUniforms::declare(depth_vert_glsl), depth_frag_glsl){
+    loadStartTime = glfwGetTime();
+    FrameUniforms::bindBlocks(depthShader);
+    Renderable::depthModelMatrix = depthShader.getUniform("ModelMatrix");
+    depthCascade = depthShader.getUniform("Cascade");
+    ppgso::GLState::setEnabled(GL_DEPTH_TEST, true);
+    ppgso::GLState::depthFunc(GL_LESS);
     glEnable(GL_LINE_SMOOTH);
     glLineWidth(1.0f);
 
     // init postprocessing, sun, shadow, camera animation
     postProcessor = std::make_unique<PostProcessor>(SIZEx, SIZEy);
+    deferredShading = std::make_unique<DeferredShading>(*postProcessor, SIZEx, SIZEy);
+    glGenQueries(2, mainPassQueries);
     sunDirection = glm::normalize(glm::vec3(-0.5f, -0.1f, 0.3f));
-    initShadowMap();
     initializeCameraAnimation();
 
     std::vector<std::string> skyboxFaces = {
@@ -38,6 +56,18 @@ ParticleWindow::ParticleWindow()
     auto grassTile = std::make_unique<GrassTile>(glm::vec3(0.0f, -0.1f, 0.0f), glm::vec3(200.0f));
     scene.push_back(std::move(grassTile));
 
+    // rain, splashes and collision debris
+    if (gpuCulling) this->gpuCulling = std::make_unique<GpuCulling>();
+
+    auto particleSystem = ParticleSystem::create(gpuParticles, RAIN_CAPACITY, SPLASH_CAPACITY);
+    particles = particleSystem.get();
+    Car::particles = particles;
+    Car::index = &carIndex;
+    scene.push_back(std::move(particleSystem));
+
+    // skybox and ground are needed for the first frame, everything else streams in while rendering
+    ppgso::AssetCache::instance().setLoader(&loader);
+
     auto airplane = std::make_unique<Airplane>();
     scene.push_back(std::move(airplane));
 
@@ -82,7 +112,6 @@ ParticleWindow::ParticleWindow()
         shader->use();
         addCarLights(*shader, gridcars.getCellPosition(spawnPositions[i][0], spawnPositions[i][1]));
 
-        Cars.push_back(car.get());
         scene.push_back(std::move(car));
     }
 
@@ -128,7 +157,7 @@ ParticleWindow::ParticleWindow()
                     if (row == 1 || col == 1) {
 
                         if (!(row == 1 && col == 1)){
-                            auto road = std::make_unique<Plane>(cellPosition);
+                            auto road = std::make_unique<Plane>("models/asphalt.bmp", cellPosition);
                             if (row == 1 && col != 1) {
                                 road->setRotation(90.0f);
                             }
@@ -188,7 +217,7 @@ ParticleWindow::ParticleWindow()
 
                         // intersection road textures
                         if (row == 1 && col == 1) {
-                            auto cross = std::make_unique<PlaneCross>(cellPosition);
+                            auto cross = std::make_unique<Plane>("models/cross.bmp", cellPosition);
                             scene.push_back(std::move(cross));
                             continue;
                         }
@@ -204,8 +233,8 @@ ParticleWindow::ParticleWindow()
                         if (row == 1) {
                             glm::vec3 leftLampPos = cellPosition + glm::vec3(0.0f, 0.0f, -lampOffset);
                             glm::vec3 rightLampPos = cellPosition + glm::vec3(0.0f, 0.0f, lampOffset);
-                            lampPositions.push_back(leftLampPos);
-                            lampPositions.push_back(rightLampPos);
+                            lampIndex.insert(leftLampPos, leftLampPos);
+                            lampIndex.insert(rightLampPos, rightLampPos);
 
                             auto leftLamp = std::make_unique<Building>("models/lamp.obj", leftLampPos, "models/lamp.bmp");
                             leftLamp->setScale(0.002f);
@@ -236,8 +265,8 @@ ParticleWindow::ParticleWindow()
                         if (col == 1) {
                             glm::vec3 topLampPos = cellPosition + glm::vec3(-lampOffset, 0.0f, 0.0f);
                             glm::vec3 bottomLampPos = cellPosition + glm::vec3(lampOffset, 0.0f, 0.0f);
-                            lampPositions.push_back(topLampPos);
-                            lampPositions.push_back(bottomLampPos);
+                            lampIndex.insert(topLampPos, topLampPos);
+                            lampIndex.insert(bottomLampPos, bottomLampPos);
 
                             auto topLamp = std::make_unique<Building>("models/lamp.obj", topLampPos, "models/lamp.bmp");
                             topLamp->setScale(0.002f);
@@ -332,14 +361,137 @@ ParticleWindow::ParticleWindow()
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 }
 
-void ParticleWindow::setLightingUniforms(ppgso::Shader& shader) {
-    shader.setUniform("viewPos", camera.position);
+ParticleWindow::~ParticleWindow() {
+    ppgso::AssetCache::instance().setLoader(nullptr);
+    glDeleteQueries(2, mainPassQueries);
+}
+
+void ParticleWindow::reportAssets() {
+    std::cout << "All assets loaded after " << (glfwGetTime() - loadStartTime) * 1000.0 << " ms\n";
+
+    // assets are loaded once per file, report how much sharing saved
+    const auto& meshStats = ppgso::AssetCache::instance().getMeshStats();
+    const auto& textureStats = ppgso::AssetCache::instance().getTextureStats();
+    std::cout << "Meshes: " << meshStats.misses << " loaded (" << meshStats.bytes / 1024 << " KB), "
+              << meshStats.hits << " shared (" << meshStats.bytesSaved / 1024 << " KB saved)\n";
+    std::cout << "Textures: " << textureStats.misses << " loaded (" << textureStats.bytes / 1024 << " KB), "
+              << textureStats.hits << " shared (" << textureStats.bytesSaved / 1024 << " KB saved)\n";
+
+    // a cold start compiles every program, a warm one loads them from the binary cache
+    const auto& linkStats = ppgso::Shader::getLinkStats();
+    std::cout << "Programs: " << linkStats.compiled << " compiled in " << linkStats.compileTime << " ms, "
+              << linkStats.cached << " loaded from cache in " << linkStats.cacheTime << " ms";
+    if (linkStats.rejected > 0) std::cout << ", " << linkStats.rejected << " cached binaries rejected";
+    std::cout << "\n";
+}
+
+void ParticleWindow::reportFrameStats(float dTime) {
+    frameReportFrames++;
+    frameReportTimer += dTime;
+    if (frameReportTimer < frameReportInterval) return;
+
+    auto& lodStats = LodSelector::stats();
+    std::cout << "LOD: " << lodStats.renderedTriangles / frameReportFrames << " of "
+              << lodStats.fullTriangles / frameReportFrames << " triangles per frame in "
+              << lodStats.objects / frameReportFrames << " objects\n";
+
+    // elided calls are the location queries made before uniforms were cached
+    auto& shaderStats = ppgso::Shader::getCallStats();
+    std::cout << "Shaders: " << shaderStats.issued / frameReportFrames << " GL calls per frame, "
+              << (shaderStats.issued + shaderStats.elided) / frameReportFrames << " without caching, "
+              << SceneShader::getVariantCount() << " scene shader variants\n";
+
+    // elided calls are binds and state changes that would not have changed anything
+    auto& stateStats = ppgso::GLState::getCallStats();
+    std::cout << "State: " << stateStats.issued / frameReportFrames << " GL calls per frame, "
+              << (stateStats.issued + stateStats.elided) / frameReportFrames << " without caching\n";
+
+    // changes between consecutive items of the sorted main pass
+    auto& queueStats = RenderQueue::stats();
+    std::cout << "Queue: " << queueStats.items / frameReportFrames << " items per frame, "
+              << queueStats.shaderChanges / frameReportFrames << " shader and "
+              << queueStats.textureChanges / frameReportFrames << " texture changes\n";
+
+    // both passes, instanced props count one call per batch
+    auto& drawStats = ppgso::MeshBase::getDrawStats();
+    std::cout << "Draws: " << drawStats.drawCalls / frameReportFrames << " calls per frame, "
+              << drawStats.instances / frameReportFrames << " instances\n";
+
+    // objects with bounds found by the camera and the light volume in the scene index, the rest is always drawn
+    std::cout << "Culling: " << mainCull.visible / frameReportFrames << " visible, "
+              << mainCull.culled / frameReportFrames << " culled and "
+              << mainCull.occluded / frameReportFrames << " occluded per frame, shadow pass "
+              << depthCull.visible / frameReportFrames << " visible and "
+              << depthCull.culled / frameReportFrames << " culled\n";
+
+    // casters drawn into every cascade, the near ones cover a few metres of street and hold few objects
+    std::cout << "Shadows:";
+    for (int cascade = 0; cascade < ShadowCascades::CASCADES; cascade++) {
+        std::cout << " cascade " << cascade << " to " << shadowCascades.getSplits()[cascade] << " m "
+                  << cascadeCasters[cascade] / frameReportFrames << " casters"
+                  << (cascade + 1 < ShadowCascades::CASCADES ? "," : "\n");
+        cascadeCasters[cascade] = 0;
+    }
+
+    // the last frame is enough, occluders change slowly while the camera moves
+    std::cout << "Occlusion: " << occlusionBuffer.getOccluderCount() << " occluders rasterized in "
+              << occlusionBuffer.getRasterTime() << " ms\n";
+
+    // the last frame as well, the most crowded cluster picks the scene shader variants
+    std::cout << "Lights: " << lightClusters.getVisibleLights() << " in view, "
+              << lightClusters.getIndexCount() << " cluster entries, at most "
+              << lightClusters.getMaxClusterLights() << " in one cluster\n";
+
+    // GPU time from binding the HDR target to the last object, the part the shading path changes
+    std::cout << "Shading: " << (SceneShader::isDeferred() ? "deferred" : "forward") << ", main pass "
+              << mainPassTime / frameReportFrames << " ms on the GPU\n";
+
+    std::cout << "Particles: " << particles->size() << " live, update " << particles->getUpdateTime() << " ms\n";
+
+    lodStats = LodSelector::Stats{};
+    drawStats = ppgso::MeshBase::DrawStats{};
+    queueStats = RenderQueue::Stats{};
+    mainCull = CullStats{};
+    depthCull = CullStats{};
+    mainPassTime = 0.0;
+    shaderStats = ppgso::Shader::CallStats{};
+    stateStats = ppgso::GLState::CallStats{};
+    frameReportTimer = 0.0f;
+    frameReportFrames = 0;
+}
+
+void ParticleWindow::cullOccluded(std::vector<Renderable*>& objects) {
+    occlusionBuffer.clear(camera.projectionMatrix * camera.viewMatrix);
+
+    // only buildings in the view can hide anything, the nearest ones cover the most of it
+    std::vector<std::pair<float, glm::mat4>> occluders;
+    glm::mat4 boxMatrix;
+    for (auto object : objects) {
+        if (object->getOccluder(boxMatrix))
+            occluders.emplace_back(glm::distance(glm::vec3(boxMatrix[3]), camera.position), boxMatrix);
+    }
+    size_t count = std::min(occluders.size(), MAX_OCCLUDERS);
+    std::partial_sort(occluders.begin(), occluders.begin() + count, occluders.end(),
+                      [](const std::pair<float, glm::mat4>& a, const std::pair<float, glm::mat4>& b) {
+                          return a.first < b.first;
+                      });
+    for (size_t i = 0; i < count; i++) occlusionBuffer.addOccluder(occluders[i].second);
+    occlusionBuffer.rasterize();
+
+    glm::vec3 boundsMin, boundsMax;
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [&](Renderable* object) {
+        return object->getBounds(boundsMin, boundsMax) && !occlusionBuffer.isVisible(boundsMin, boundsMax);
+    }), objects.end());
+}
+
+void ParticleWindow::setLightingUniforms(FrameData& frame) {
+    frame.viewPosition = glm::vec4(camera.position, 1.0f);
 
     // sun light
-    shader.setUniform("dirLight.direction", sunDirection);
-    shader.setUniform("dirLight.ambient", glm::vec3(0.4f, 0.35f, 0.3f));
-    shader.setUniform("dirLight.diffuse", glm::vec3(0.8f, 0.7f, 0.6f));
-    shader.setUniform("dirLight.specular", glm::vec3(1.0f, 0.9f, 0.8f));
+    frame.sunDirection = glm::vec4(sunDirection, 0.0f);
+    frame.sunAmbient = glm::vec4(0.4f, 0.35f, 0.3f, 0.0f);
+    frame.sunDiffuse = glm::vec4(0.8f, 0.7f, 0.6f, 0.0f);
+    frame.sunSpecular = glm::vec4(1.0f, 0.9f, 0.8f, 0.0f);
 }
 
 void ParticleWindow::addCarLights(ppgso::Shader& shader, const glm::vec3& carPosition) {
@@ -363,84 +515,133 @@ void ParticleWindow::addCarLights(ppgso::Shader& shader, const glm::vec3& carPos
     shader.setUniform("carLightRight.quadratic", 0.032f);
 }
 
-void ParticleWindow::updateDynamicLights(ppgso::Shader& shader) {
-    std::vector<glm::vec3> activeLights;
-    float activationRadius = 25.0f;
-
-    for (const auto &lampPos: lampPositions) {
-        if (glm::distance(camera.position, lampPos) <= activationRadius) {
-            activeLights.push_back(lampPos);
-        }
+void ParticleWindow::updateDynamicLights() {
+    // Every lamp and headlight whose light may reach into the view, the clusters drop the ones that do not
+    glm::mat4 inverseViewProjection = glm::inverse(camera.projectionMatrix * camera.viewMatrix);
+    glm::vec3 boundsMin{std::numeric_limits<float>::max()}, boundsMax{-std::numeric_limits<float>::max()};
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 ndc{corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 1.0f};
+        glm::vec4 world = inverseViewProjection * ndc;
+        boundsMin = glm::min(boundsMin, glm::vec3(world) / world.w);
+        boundsMax = glm::max(boundsMax, glm::vec3(world) / world.w);
     }
+    boundsMin -= glm::vec3(POINT_LIGHT_RADIUS);
+    boundsMax += glm::vec3(POINT_LIGHT_RADIUS);
+
+    auto addLight = [this](const glm::vec3& position) {
+        PointLightData light;
+        light.position = glm::vec4(position, POINT_LIGHT_RADIUS);
+        light.ambient = glm::vec4(glm::vec3(0.05f), 0.0f);
+        light.diffuse = glm::vec4(0.8f, 0.8f, 0.7f, 0.0f);
+        light.specular = glm::vec4(glm::vec3(1.0f), 0.0f);
+        light.attenuation = glm::vec4(1.0f, 0.045f, 0.0075f, 0.0f);
+        lightClusters.add(light);
+    };
 
-    for (const auto& car : Cars) {
+    lightClusters.clear();
+    lampIndex.queryBox(boundsMin, boundsMax, [&](const glm::vec3& lampPos) {
+        addLight(lampPos);
+    });
+    carIndex.queryBox(boundsMin, boundsMax, [&](Car* car) {
         glm::vec3 carPos = car->getPosition();
-        if (glm::distance(camera.position, carPos) <= activationRadius) {
-            activeLights.push_back(carPos + glm::vec3(0.5f, -1.0f, 1.4f));
-            activeLights.push_back(carPos + glm::vec3(-0.5f, -1.0f, 1.4f));
-        }
-    }
-
-    int lightCount = 0;
-    for (const auto& activeLight : activeLights) {
-        if (lightCount >= NR_POINT_LIGHTS) break;
-
-        std::string index = "pointLights[" + std::to_string(lightCount) + "].";
-        shader.setUniform(index + "position", activeLight);
-        shader.setUniform(index + "ambient", glm::vec3(0.05f));
-        shader.setUniform(index + "diffuse", glm::vec3(0.8f, 0.8f, 0.7f));
-        shader.setUniform(index + "specular", glm::vec3(1.0f));
-        shader.setUniform(index + "constant", 1.0f);
-        shader.setUniform(index + "linear", 0.045f);
-        shader.setUniform(index + "quadratic", 0.0075f);
+        addLight(carPos + glm::vec3(0.5f, -1.0f, 1.4f));
+        addLight(carPos + glm::vec3(-0.5f, -1.0f, 1.4f));
+    });
 
-        lightCount++;
-    }
+    lightClusters.update(camera);
+    SceneShader::setActiveLights(lightClusters.getMaxClusterLights());
 }
 
+void ParticleWindow::updateFrameUniforms() {
+    FrameData frame{};
+    frame.viewMatrix = camera.viewMatrix;
+    frame.projectionMatrix = camera.projectionMatrix;
+    setLightingUniforms(frame);
+
+    updateDynamicLights();
+    frame.clusterSlices = lightClusters.getSliceParameters();
 
-void ParticleWindow::initShadowMap() {
-    glGenFramebuffers(1, &depthMapFBO);
+    shadowCascades.update(camera, sunDirection);
+    for (int cascade = 0; cascade < ShadowCascades::CASCADES; cascade++)
+        frame.cascadeMatrices[cascade] = shadowCascades.getMatrix(cascade);
+    frame.cascadeSplits = shadowCascades.getSplits();
+    frame.cascadeBias = shadowCascades.getBias();
 
-    // depth texture
-    glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-                 SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    frameUniforms.update(frame);
+}
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 
-    float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+void ParticleWindow::updateSceneIndex(Renderable& object) {
+    auto found = sceneHandles.find(&object);
+    if (found != sceneHandles.end() && object.isStatic()) return;
+    if (gpuCulling && found == sceneHandles.end()) {
+        if (gpuCulledObjects.count(&object)) return;
+        if (object.addToGpuCulling(*gpuCulling)) {
+            gpuCulledObjects.insert(&object);
+            return;
+        }
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+    // objects get bounds once their mesh is loaded, until then they are drawn like objects without them
+    glm::vec3 boundsMin, boundsMax;
+    if (!object.getBounds(boundsMin, boundsMax)) {
+        if (found == sceneHandles.end()) unindexedObjects.push_back(&object);
+        return;
+    }
 
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
+    if (found == sceneHandles.end())
+        sceneHandles.emplace(&object, sceneIndex.insert(&object, boundsMin, boundsMax));
+    else
+        sceneIndex.update(found->second, boundsMin, boundsMax);
+}
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+void ParticleWindow::removeFromSceneIndex(Renderable& object) {
+    auto found = sceneHandles.find(&object);
+    if (found == sceneHandles.end()) return;
+    sceneIndex.remove(found->second);
+    sceneHandles.erase(found);
 }
 
 void ParticleWindow::renderDepthMap() {
-    Renderable::depthMap = depthMap;
-
-    glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
-
     depthShader.use();
-    depthShader.setUniform("LightSpaceMatrix", lightSpaceMatrix);
 
-    for (auto& object : scene) {
-        object->renderDepth(depthShader);
+    // every cascade draws only the casters inside its own volume, all items share the depth shader and sorting
+    // by mesh keeps the same vertex arrays together. The depth shaders pick the matrix of the cascade from the
+    // FrameData block, so only their cascade index changes between the passes.
+    for (int cascade = 0; cascade < ShadowCascades::CASCADES; cascade++) {
+        const glm::mat4& lightSpace = shadowCascades.getMatrix(cascade);
+        depthShader.setUniform(depthCascade, cascade);
+        Renderable::depthCascade = cascade;
+        shadowCascades.beginCascade(cascade);
+
+        depthQueue.clear(camera);
+        for (auto object : unindexedObjects) {
+            object->submitDepth(depthQueue);
+        }
+        size_t visible = 0;
+        sceneIndex.queryFrustum(Frustum{lightSpace}, [&](Renderable* object) {
+            object->submitDepth(depthQueue);
+            visible++;
+        });
+        depthQueue.sort();
+        for (auto& item : depthQueue.getItems()) {
+            item.object->renderDepth(depthShader);
+        }
+        Building::flushInstances();
+
+        if (gpuCulling) {
+            gpuCulling->cull(GpuCulling::SHADOW, lightSpace, camera, cascade);
+            gpuCulling->render(GpuCulling::SHADOW, cascade);
+            visible += gpuCulling->getVisible(GpuCulling::SHADOW, cascade);
+        }
+        size_t total = sceneIndex.size() + (gpuCulling ? gpuCulling->size() : 0);
+        depthCull.visible += visible;
+        depthCull.culled += total - visible;
+        cascadeCasters[cascade] += visible;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, width, height);
+    ppgso::GLState::bindFramebuffer(0);
+    ppgso::GLState::viewport(0, 0, width, height);
 }
 
 void ParticleWindow::initializeCameraAnimation() {
@@ -587,11 +788,20 @@ void ParticleWindow::onKey(int key, int scanCode, int action, int mods) {
             glm::vec3 speed = glm::sphericalRand(spd);
             float lt = glm::linearRand(0.1f, 1.5f);
 
-            auto particle = std::make_unique<SplashParticle>(position, speed, color, lt);
-            scene.push_back(std::move(particle));
+            particles->spawnSplash(position, speed, color, lt);
         }
     }
 
+    if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+        SceneShader::setDeferred(!SceneShader::isDeferred());
+        std::cout << "Shading " << (SceneShader::isDeferred() ? "Deferred" : "Forward") << ".\n";
+    }
+
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        occlusionCulling = !occlusionCulling;
+        std::cout << "Occlusion Culling " << (occlusionCulling ? "Enabled" : "Disabled") << ".\n";
+    }
+
      if (key == GLFW_KEY_R && action == GLFW_PRESS) {
         isCameraAnimating = !isCameraAnimating;
         if (isCameraAnimating) {
@@ -670,6 +880,18 @@ void ParticleWindow::onIdle() {
     float dTime = (float)glfwGetTime() - time;
     time = (float)glfwGetTime();
 
+    if (!firstFrameReported) {
+        firstFrameReported = true;
+        std::cout << "First frame after " << (glfwGetTime() - loadStartTime) * 1000.0 << " ms\n";
+    }
+
+    // upload assets finished by the loader threads, objects without them are skipped until then
+    loader.update(ASSET_UPLOAD_BUDGET);
+    if (!assetsReported && loader.getPending() == 0) {
+        assetsReported = true;
+        reportAssets();
+    }
+
     // wind changes direction every 5s
     windChangeTimer += dTime;
     if (windChangeTimer >= windChangeInterval) {
@@ -693,29 +915,12 @@ void ParticleWindow::onIdle() {
         glm::vec3 speed = glm::vec3(0.0f, -7.0f, 0.0f);
         glm::vec3 color = glm::vec3(0.0f, 0.0f, 1.0f);
 
-        auto particle = std::make_unique<Particle>(position, speed, color);
-        scene.push_back(std::move(particle));
+        particles->spawnRain(position, speed, color);
     }
 
     updateCameraAnimation(dTime);
     updateSunPosition(dTime);
 
-    // setup the light space matrix for shadows
-    glm::vec3 lightPos = -sunDirection * 150.0f;
-    float near_plane = 1.0f, far_plane = 200.0f;
-    glm::mat4 lightProjection = glm::ortho(-150.0f, 150.0f, -150.0f, 150.0f, near_plane, far_plane);
-    glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    lightSpaceMatrix = lightProjection * lightView;
-
-    Renderable::lightSpaceMatrix = lightSpaceMatrix;
-
-    renderDepthMap();
-
-    postProcessor->BeginRender();
-
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
     float cameraSpeed = 10.0f;
     glm::vec3 forward = glm::normalize(camera.target - camera.position);
     glm::vec3 right = glm::normalize(glm::cross(forward, camera.up));
@@ -728,40 +933,103 @@ void ParticleWindow::onIdle() {
     camera.update();
 
     // update objects
+    particles->setWind(wind);
+    unindexedObjects.clear();
     for (auto it = scene.begin(); it != scene.end();) {
-        auto* particle = dynamic_cast<Particle*>(it->get());
-        if (particle) {
-            particle->setWind(wind);
-            if (!particle->update(dTime, scene))
-                it = scene.erase(it);
-            else
-                ++it;
+        if (!(*it)->update(dTime, scene)) {
+            removeFromSceneIndex(**it);
+            it = scene.erase(it);
         } else {
-            if (!(*it)->update(dTime, scene))
-                it = scene.erase(it);
-            else
-                ++it;
+            updateSceneIndex(**it);
+            ++it;
         }
     }
 
-    // lighting uniforms for all shaders
-    std::set<ppgso::Shader*> processedShaders;
-    for (auto& object : scene) {
-        auto shader = object->getShader();
-        if (processedShaders.find(shader) == processedShaders.end()) {
-            shader->use();
-            setLightingUniforms(*shader);
-            updateDynamicLights(*shader);
-            shader->setUniform("LightSpaceMatrix", lightSpaceMatrix);
-            shader->setUniform("ShadowMap", 1);
-            processedShaders.insert(shader);
+    // camera, sun, lights and shadow cascades for all shaders, used by the depth pass as well
+    updateFrameUniforms();
+
+    renderDepthMap();
+
+    // the query of the previous frame is read while this one runs, so the read does not wait for the GPU
+    mainPassQuery = 1 - mainPassQuery;
+    glBeginQuery(GL_TIME_ELAPSED, mainPassQueries[mainPassQuery]);
+
+    postProcessor->BeginRender();
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // all scene shaders sample the shadow cascades from texture unit 1 and the light clusters from the units after it
+    ppgso::GLState::bindTexture(1, GL_TEXTURE_2D_ARRAY, shadowCascades.getTexture());
+    lightClusters.bind();
+
+    // scene shader objects and GPU culled buildings draw into the G-buffer in the deferred path
+    bool deferred = SceneShader::isDeferred();
+    if (deferred) deferredShading->beginGeometry();
+
+    // render all objects to the HDR buffer, opaque ones front to back, then the sky, then transparent ones
+    renderQueue.clear(camera);
+    for (auto object : unindexedObjects) {
+        object->submit(renderQueue);
+    }
+    visibleObjects.clear();
+    sceneIndex.queryFrustum(camera.getFrustum(), [&](Renderable* object) { visibleObjects.push_back(object); });
+    size_t inFrustum = visibleObjects.size();
+    if (occlusionCulling) cullOccluded(visibleObjects);
+    for (auto object : visibleObjects) {
+        object->submit(renderQueue);
+    }
+    mainCull.visible += visibleObjects.size();
+    mainCull.culled += sceneIndex.size() - inFrustum;
+    mainCull.occluded += inFrustum - visibleObjects.size();
+
+    // buildings culled on the GPU go first, they are opaque and cover most of the screen
+    if (gpuCulling) {
+        gpuCulling->cull(GpuCulling::MAIN, camera.projectionMatrix * camera.viewMatrix, camera);
+        gpuCulling->render(GpuCulling::MAIN);
+        mainCull.visible += gpuCulling->getVisible(GpuCulling::MAIN);
+        mainCull.culled += gpuCulling->size() - gpuCulling->getVisible(GpuCulling::MAIN);
+    }
+    renderQueue.sort();
+    renderQueue.countChanges();
+    ppgso::Shader* shader = nullptr;
+    if (deferred) {
+        // G-buffer items are opaque, they keep their sorted order and are lit together by one pass
+        for (auto& item : renderQueue.getItems()) {
+            if (!SceneShader::writesGBuffer(item.shader)) continue;
+            if (item.shader != shader) {
+                shader = item.shader;
+                shader->use();
+            }
+            item.object->render(camera);
+        }
+        Building::flushInstances();
+        deferredShading->light(camera);
+        shader = nullptr;
+    }
+    auto pass = RenderPass::Opaque;
+    for (auto& item : renderQueue.getItems()) {
+        if (deferred && SceneShader::writesGBuffer(item.shader)) continue;
+        // instanced buildings are drawn when their run ends, at the latest before the next pass starts
+        if (RenderQueue::getPass(item) != pass) {
+            pass = RenderQueue::getPass(item);
+            Building::flushInstances();
+        }
+        if (item.shader != shader) {
+            shader = item.shader;
+            if (shader) shader->use();
         }
+        item.object->render(camera);
     }
+    Building::flushInstances();
 
-    // render all objects to the HDR buffer
-    for (auto& object : scene) {
-        object->render(camera);
+    glEndQuery(GL_TIME_ELAPSED);
+    if (mainPassFrames++ > 0) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(mainPassQueries[1 - mainPassQuery], GL_QUERY_RESULT, &elapsed);
+        mainPassTime += elapsed / 1e6;
     }
+    reportFrameStats(dTime);
 
     postProcessor->EndRender();
 
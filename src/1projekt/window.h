@@ -12,9 +12,7 @@
 #include "animation_curve.h"
 #include "keyframe.h"
 #include "plane.h"
-#include "planeCross.h"
-#include "particle.h"
-#include "splash_particle.h"
+#include "particle_system.h"
 #include "building.h"
 #include "grid.h"
 #include "GrassTile.h"
@@ -30,9 +28,33 @@
 #include <random>
 #include "trailer.h"
 #include "airplane.h"
+#include "frame_uniforms.h"
+#include "render_queue.h"
+#include "spatial_grid.h"
+#include "occlusion_buffer.h"
+#include "gpu_culling.h"
+#include "light_clusters.h"
+#include "deferred_shading.h"
+#include "shadow_cascades.h"
+#include <unordered_map>
+#include <unordered_set>
 
 class ParticleWindow : public ppgso::Window {
 private:
+    // cars remove themselves from their index when the scene is destroyed, so the indices are declared first
+    SpatialGrid<Car*> carIndex;
+    SpatialGrid<glm::vec3> lampIndex;
+    // objects with bounds for culling, the ones without bounds are drawn every frame
+    SpatialGrid<Renderable*> sceneIndex;
+    std::unordered_map<Renderable*, SpatialGrid<Renderable*>::Handle> sceneHandles;
+    std::vector<Renderable*> unindexedObjects;
+    // static buildings culled and drawn by the GPU instead of the index, set by --gpu-culling. Buildings are never
+    // removed from the scene, so they stay there until the window is destroyed.
+    std::unique_ptr<GpuCulling> gpuCulling;
+    std::unordered_set<Renderable*> gpuCulledObjects;
+    void updateSceneIndex(Renderable& object);
+    void removeFromSceneIndex(Renderable& object);
+
     Scene scene;
     Camera camera;
     Scenegl scenegl;
@@ -43,6 +65,8 @@ private:
     bool firstMouse;
     float sensitivity;
 
+    // owned by the scene like every other object
+    ParticleSystem* particles = nullptr;
     float particleSpawnTimer = 0.0f;
     const float particleSpawnInterval = 0.1f;
     const float spawnRadius = 10.0f;
@@ -50,14 +74,27 @@ private:
     float windChangeTimer = 0.0f;
     const float windChangeInterval = 5.0f;
 
-    GLuint depthMapFBO;
-    GLuint depthMap;
+    // cascades of the sun fitted to the camera every frame, drawn with the depth shader
+    ShadowCascades shadowCascades;
     ppgso::Shader depthShader;
-    glm::mat4 lightSpaceMatrix;
-    void initShadowMap();
+    ppgso::UniformHandle depthCascade;
     void renderDepthMap();
-    void updateDynamicLights(ppgso::Shader& shader);
-    std::vector<glm::vec3> lampPositions;
+    void updateDynamicLights();
+
+    // camera and sun uploaded once per frame for all shaders, street lamps and headlights sorted into clusters
+    FrameUniforms frameUniforms;
+    LightClusters lightClusters;
+    void updateFrameUniforms();
+
+    // draw items of the main and depth pass sorted by state every frame
+    RenderQueue renderQueue;
+    RenderQueue depthQueue;
+
+    // objects found in the camera frustum, the ones hidden behind the nearest buildings are dropped, O toggles it
+    OcclusionBuffer occlusionBuffer;
+    bool occlusionCulling = true;
+    std::vector<Renderable*> visibleObjects;
+    void cullOccluded(std::vector<Renderable*>& objects);
 
     bool isCameraAnimating = false;
     float cameraAnimationTime = 0.0f;
@@ -66,13 +103,42 @@ private:
     void initializeCameraAnimation();
     void updateCameraAnimation(float dTime);
 
+    ppgso::AssetLoader loader;
+    double loadStartTime;
+    bool firstFrameReported = false;
+    bool assetsReported = false;
+    void reportAssets();
+
+    // per frame triangles with and without levels of detail and shader calls, reported every few seconds
+    float frameReportTimer = 0.0f;
+    int frameReportFrames = 0;
+    const float frameReportInterval = 5.0f;
+    // indexed objects drawn and culled by the main and the shadow pass, only the main pass tests occlusion
+    struct CullStats {
+        size_t visible = 0;
+        size_t culled = 0;
+        size_t occluded = 0;
+    };
+    CullStats mainCull, depthCull;
+    size_t cascadeCasters[ShadowCascades::CASCADES] = {};
+    // GPU time of the main pass in ms, two queries so the previous frame is read, G toggles forward and deferred
+    GLuint mainPassQueries[2] = {};
+    int mainPassQuery = 0;
+    size_t mainPassFrames = 0;
+    double mainPassTime = 0.0;
+    void reportFrameStats(float dTime);
+
 public:
-    ParticleWindow();
+    // particles are simulated on the GPU with transform feedback when gpuParticles is set, static buildings are
+    // culled on the GPU when gpuCulling is set
+    explicit ParticleWindow(bool gpuParticles = false, bool gpuCulling = false);
+    ~ParticleWindow() override;
     glm::vec3 sunDirection;
     std::unique_ptr<PostProcessor> postProcessor;
+    std::unique_ptr<DeferredShading> deferredShading;
 
     void updateSunPosition(float dTime);
-    void setLightingUniforms(ppgso::Shader& shader);
+    void setLightingUniforms(FrameData& frame);
     void onKey(int key, int scanCode, int action, int mods) override;
     void onCursorPos(double xpos, double ypos) override;
     void onIdle() override;
@@ -0,0 +1,32 @@
+#ifndef PPGSO_BENCH_H
+#define PPGSO_BENCH_H
+
+// Timing shared by the benchmarks
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Best of a few runs hides disk cache warm up and page faults of the first touch
+const int RUNS = 5;
+
+/*!
+ * Run a function a few times and measure the fastest run.
+ *
+ * @param run - Work to measure.
+ * @param runs - Number of runs.
+ * @return - Time of the fastest run in milliseconds.
+ */
+inline double bestTime(const std::function<void()> &run, int runs = RUNS) {
+  double best = 0;
+  for (int i = 0; i < runs; i++) {
+    auto start = Clock::now();
+    run();
+    double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    best = i == 0 ? time : std::min(best, time);
+  }
+  return best;
+}
+
+#endif //PPGSO_BENCH_H
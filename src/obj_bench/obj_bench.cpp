@@ -0,0 +1,80 @@
+// Benchmark of the obj loaders
+// - Loads every model with tinyobj::LoadObj and with tinyobj::LoadObjFast on one thread and on all cores
+// - Checks that the fast loader produces exactly the same shapes
+// - Usage: obj_bench [model.obj ...], without arguments all models used by 1projekt are loaded
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include <ppgso/ppgso.h>
+#include <ppgso/mapped_file.h>
+
+#include "../bench/bench.h"
+
+const char *MODELS[] = {
+        "models/building.obj", "models/building2.obj", "models/building3.obj", "models/building4.obj",
+        "models/building5.obj", "models/building6.obj", "models/building7.obj", "models/car.obj",
+        "models/lamp.obj", "models/plane.obj", "models/roadblock.obj", "models/trailer.obj",
+        "models/trashbin.obj", "models/truck.obj"
+};
+
+bool sameShapes(const std::vector<tinyobj::shape_t> &a, const std::vector<tinyobj::shape_t> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    auto &x = a[i].mesh;
+    auto &y = b[i].mesh;
+    if (a[i].name != b[i].name || x.positions != y.positions || x.normals != y.normals ||
+        x.texcoords != y.texcoords || x.indices != y.indices || x.material_ids != y.material_ids)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) files.emplace_back(argv[i]);
+  if (files.empty()) files.assign(std::begin(MODELS), std::end(MODELS));
+
+  std::cout << std::left << std::setw(24) << "file" << std::right
+            << std::setw(10) << "KB" << std::setw(12) << "LoadObj" << std::setw(12) << "fast x1"
+            << std::setw(12) << "fast xN" << std::setw(10) << "speedup" << "  output\n";
+
+  double totalSize = 0, totalSlow = 0, totalFast = 0, totalParallel = 0;
+  bool allSame = true;
+  for (auto &file : files) {
+    std::vector<tinyobj::shape_t> reference, shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string err;
+
+    double slow = bestTime([&] { err = tinyobj::LoadObj(reference, materials, file.c_str()); });
+    if (!err.empty()) {
+      std::cerr << err;
+      continue;
+    }
+    double fast = bestTime([&] { tinyobj::LoadObjFast(shapes, materials, file.c_str(), nullptr, 1); });
+    bool same = sameShapes(reference, shapes);
+    double parallel = bestTime([&] { tinyobj::LoadObjFast(shapes, materials, file.c_str()); });
+    same = same && sameShapes(reference, shapes);
+    allSame = allSame && same;
+
+    double size = ppgso::MappedFile{file}.size() / 1024.0;
+    totalSize += size;
+    totalSlow += slow;
+    totalFast += fast;
+    totalParallel += parallel;
+
+    std::cout << std::left << std::setw(24) << file << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << size << std::setw(12) << slow << std::setw(12) << fast
+              << std::setw(12) << parallel << std::setw(9) << slow / std::min(fast, parallel) << "x"
+              << (same ? "  same" : "  DIFFERENT") << "\n";
+  }
+
+  std::cout << std::left << std::setw(24) << "total" << std::right << std::setw(10) << totalSize
+            << std::setw(12) << totalSlow << std::setw(12) << totalFast << std::setw(12) << totalParallel
+            << std::setw(9) << totalSlow / std::min(totalFast, totalParallel) << "x\n";
+  std::cout << "Times are best of " << RUNS << " runs in ms, throughput "
+            << totalSize / 1024.0 / (totalSlow / 1000.0) << " MB/s -> "
+            << totalSize / 1024.0 / (std::min(totalFast, totalParallel) / 1000.0) << " MB/s\n";
+
+  return allSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,179 @@
+// Benchmark of the occlusion culling used by 1projekt
+// - Checks a wall against boxes in front of it, behind it and beside it
+// - Draws a city of box buildings seen from the street with every rasterizer kernel, on one thread and on all cores
+// - Checks that the SIMD kernel fills exactly the same depths as the scalar one
+// - Counts the props found in the frustum and the ones left after occlusion culling
+// - Usage: occlusion_bench [city size in cells]
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../1projekt/frustum.h"
+#include "../1projekt/occlusion_buffer.h"
+#include "../bench/bench.h"
+
+// More runs than the default for the drawing of the views
+const int DRAW_RUNS = 20;
+const float CELL_SIZE = 10.0f;
+const size_t MAX_OCCLUDERS = 32;
+const int VIEWS = 16;
+
+struct Box {
+  glm::vec3 min, max;
+};
+
+glm::mat4 toBoxMatrix(const Box &box) {
+  glm::mat4 matrix = glm::translate(glm::mat4(1.0f), (box.min + box.max) * 0.5f);
+  return glm::scale(matrix, (box.max - box.min) * 0.5f);
+}
+
+glm::mat4 getView(const glm::vec3 &eye, float angle) {
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  glm::vec3 target = eye + glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+  return projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// A wall 4 m high 10 m in front of the camera looking down -z
+bool checkWall() {
+  OcclusionBuffer buffer;
+  buffer.clear(getView(glm::vec3(0.0f, 2.0f, 0.0f), -glm::half_pi<float>()));
+  buffer.addOccluder(toBoxMatrix({{-5.0f, 0.0f, -11.0f}, {5.0f, 4.0f, -10.0f}}));
+  buffer.rasterize();
+
+  bool behind = buffer.isVisible({-1.0f, 0.0f, -21.0f}, {1.0f, 2.0f, -20.0f});
+  bool front = buffer.isVisible({-1.0f, 0.0f, -6.0f}, {1.0f, 2.0f, -5.0f});
+  bool beside = buffer.isVisible({8.0f, 0.0f, -21.0f}, {10.0f, 2.0f, -20.0f});
+  bool above = buffer.isVisible({-1.0f, 12.0f, -31.0f}, {1.0f, 14.0f, -30.0f});
+  bool passed = !behind && front && beside && above;
+  std::cout << "wall: behind " << (behind ? "visible" : "occluded") << ", in front "
+            << (front ? "visible" : "occluded") << ", beside " << (beside ? "visible" : "occluded")
+            << ", above " << (above ? "visible" : "occluded") << (passed ? "" : "  WRONG") << "\n";
+  return passed;
+}
+
+int main(int argc, char *argv[]) {
+  int cells = argc > 1 ? std::atoi(argv[1]) : 11;
+  bool passed = checkWall();
+
+  // Blocks of buildings with streets every third cell and small props along the streets, like 1projekt
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> height(8.0f, 30.0f);
+  std::uniform_real_distribution<float> offset(-4.0f, 4.0f);
+  std::vector<Box> buildings, props;
+  for (int row = 0; row < cells; row++) {
+    for (int column = 0; column < cells; column++) {
+      glm::vec3 center{column * CELL_SIZE, 0.0f, row * CELL_SIZE};
+      if (row % 3 == 0 || column % 3 == 0) {
+        for (int i = 0; i < 8; i++) {
+          glm::vec3 position = center + glm::vec3(offset(gen), 0.0f, offset(gen));
+          props.push_back({position - glm::vec3(0.3f, 0.0f, 0.3f), position + glm::vec3(0.3f, 1.5f, 0.3f)});
+        }
+      } else {
+        buildings.push_back({center - glm::vec3(4.0f, 0.0f, 4.0f), center + glm::vec3(4.0f, height(gen), 4.0f)});
+      }
+    }
+  }
+
+  // Street level views at a crossing in the middle of the city
+  glm::vec3 eye{(cells / 2 / 3 * 3) * CELL_SIZE, 1.7f, (cells / 2 / 3 * 3) * CELL_SIZE};
+  std::vector<glm::mat4> views;
+  for (int i = 0; i < VIEWS; i++) views.push_back(getView(eye, glm::two_pi<float>() * i / VIEWS + 0.1f));
+
+  // Nearest buildings in every view
+  std::vector<std::vector<glm::mat4>> occluders(VIEWS);
+  for (int i = 0; i < VIEWS; i++) {
+    Frustum frustum{views[i]};
+    std::vector<std::pair<float, glm::mat4>> found;
+    for (auto &box : buildings)
+      if (frustum.intersects(box.min, box.max))
+        found.emplace_back(glm::distance((box.min + box.max) * 0.5f, eye), toBoxMatrix(box));
+    size_t count = std::min(found.size(), MAX_OCCLUDERS);
+    std::partial_sort(found.begin(), found.begin() + count, found.end(),
+                      [](const std::pair<float, glm::mat4> &a, const std::pair<float, glm::mat4> &b) {
+                        return a.first < b.first;
+                      });
+    for (size_t j = 0; j < count; j++) occluders[i].push_back(found[j].second);
+  }
+
+  std::cout << buildings.size() << " buildings and " << props.size() << " props, " << VIEWS
+            << " views with up to " << MAX_OCCLUDERS << " occluders\n";
+  std::cout << "  " << std::left << std::setw(8) << "kernel" << std::right << std::setw(14) << "1 thread ms"
+            << std::setw(16) << "all threads ms" << "  result\n";
+
+  // Depths of the scalar kernel on one thread are the reference
+  OcclusionBuffer reference;
+  std::vector<std::vector<float>> referenceDepths(VIEWS);
+  reference.setKernel(OcclusionBuffer::Kernel::Scalar);
+  reference.setThreads(1);
+  for (int i = 0; i < VIEWS; i++) {
+    reference.clear(views[i]);
+    for (auto &occluder : occluders[i]) reference.addOccluder(occluder);
+    reference.rasterize();
+    for (int y = 0; y < reference.getHeight(); y++)
+      for (int x = 0; x < reference.getWidth(); x++) referenceDepths[i].push_back(reference.getDepth(x, y));
+  }
+
+  const std::pair<OcclusionBuffer::Kernel, const char *> kernels[] = {
+          {OcclusionBuffer::Kernel::Scalar, "scalar"},
+          {OcclusionBuffer::Kernel::SSE, "SSE"}
+  };
+  for (auto &kernel : kernels) {
+    if (!OcclusionBuffer::isSupported(kernel.first)) continue;
+    OcclusionBuffer buffer;
+    buffer.setKernel(kernel.first);
+    auto drawViews = [&] {
+      for (int i = 0; i < VIEWS; i++) {
+        buffer.clear(views[i]);
+        for (auto &occluder : occluders[i]) buffer.addOccluder(occluder);
+        buffer.rasterize();
+      }
+    };
+    buffer.setThreads(1);
+    double single = bestTime(drawViews, DRAW_RUNS);
+    buffer.setThreads(0);
+    double all = bestTime(drawViews, DRAW_RUNS);
+
+    // the last view is still in the buffer, draw the others again one by one for the comparison
+    bool same = true;
+    for (int i = 0; i < VIEWS && same; i++) {
+      buffer.clear(views[i]);
+      for (auto &occluder : occluders[i]) buffer.addOccluder(occluder);
+      buffer.rasterize();
+      for (int y = 0; y < buffer.getHeight() && same; y++)
+        for (int x = 0; x < buffer.getWidth() && same; x++)
+          same = buffer.getDepth(x, y) == referenceDepths[i][y * buffer.getWidth() + x];
+    }
+    passed = passed && same;
+    std::cout << "  " << std::left << std::setw(8) << kernel.second << std::right << std::fixed
+              << std::setprecision(3) << std::setw(14) << single / VIEWS << std::setw(16) << all / VIEWS << "  "
+              << (same ? "same" : "DIFFERENT") << "\n";
+  }
+
+  // Everything in the frustum is drawn without occlusion culling
+  size_t inFrustum = 0, visible = 0;
+  OcclusionBuffer buffer;
+  for (int i = 0; i < VIEWS; i++) {
+    Frustum frustum{views[i]};
+    buffer.clear(views[i]);
+    for (auto &occluder : occluders[i]) buffer.addOccluder(occluder);
+    buffer.rasterize();
+    for (auto *boxes : {&buildings, &props}) {
+      for (auto &box : *boxes) {
+        if (!frustum.intersects(box.min, box.max)) continue;
+        inFrustum++;
+        visible += buffer.isVisible(box.min, box.max);
+      }
+    }
+  }
+  std::cout << "objects per view: " << inFrustum / VIEWS << " in the frustum, " << visible / VIEWS
+            << " after occlusion culling\n";
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,143 @@
+// Check of the mesh optimizer on the models in data/
+// - Runs the vertex cache, overdraw and vertex fetch passes on every shape, prints ACMR/ATVR after each of them
+// - Checks that the triangles keep their vertices and winding, only their order and the vertex order change
+// - Checks that the vertex cache pass does not add cache misses and that vertices end up in first use order
+// - The overdraw pass trades some of the cache gain for drawing order, its ACMR is only reported
+// - Usage: optimizer_bench [model.obj ...], without arguments all models used by 1projekt are checked
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include <ppgso/ppgso.h>
+#include <ppgso/mesh_optimizer.h>
+
+#include "../bench/bench.h"
+
+const char *MODELS[] = {
+        "models/building.obj", "models/building2.obj", "models/building3.obj", "models/building4.obj",
+        "models/building5.obj", "models/building6.obj", "models/building7.obj", "models/car.obj",
+        "models/lamp.obj", "models/plane.obj", "models/roadblock.obj", "models/trailer.obj",
+        "models/trashbin.obj", "models/truck.obj"
+};
+
+using Vertex = std::vector<float>;
+using Triangle = std::vector<Vertex>;
+
+Vertex getVertex(const ppgso::ShapeData &shape, unsigned int index) {
+  Vertex vertex(shape.positions.begin() + index * 3, shape.positions.begin() + index * 3 + 3);
+  if (!shape.texcoords.empty())
+    vertex.insert(vertex.end(), shape.texcoords.begin() + index * 2, shape.texcoords.begin() + index * 2 + 2);
+  if (!shape.normals.empty())
+    vertex.insert(vertex.end(), shape.normals.begin() + index * 3, shape.normals.begin() + index * 3 + 3);
+  return vertex;
+}
+
+/*!
+ * Triangles of a shape by the attributes of their vertices, sorted so shapes with the same triangles compare equal.
+ * Every triangle starts with its smallest vertex, which keeps the winding.
+ */
+std::vector<Triangle> getTriangles(const ppgso::ShapeData &shape) {
+  std::vector<Triangle> triangles;
+  for (size_t i = 0; i + 2 < shape.indices.size(); i += 3) {
+    Triangle triangle;
+    for (size_t corner = 0; corner < 3; corner++)
+      triangle.push_back(getVertex(shape, shape.indices[i + corner]));
+    std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+    triangles.push_back(std::move(triangle));
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+bool indicesValid(const ppgso::ShapeData &shape) {
+  size_t vertexCount = shape.positions.size() / 3;
+  return std::all_of(shape.indices.begin(), shape.indices.end(),
+                     [vertexCount](unsigned int index) { return index < vertexCount; });
+}
+
+// Every index is at most one past the largest index before it
+bool inFirstUseOrder(const ppgso::ShapeData &shape) {
+  unsigned int next = 0;
+  for (auto index : shape.indices) {
+    if (index > next) return false;
+    if (index == next) next++;
+  }
+  return next == shape.positions.size() / 3;
+}
+
+ppgso::VertexCacheStats analyze(const ppgso::ShapeData &shape) {
+  return ppgso::analyzeVertexCache(shape.indices, shape.positions.size() / 3);
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) files.emplace_back(argv[i]);
+  if (files.empty()) files.assign(std::begin(MODELS), std::end(MODELS));
+
+  std::cout << std::left << std::setw(24) << "file" << std::right << std::setw(10) << "triangles"
+            << std::setw(12) << "file order" << std::setw(12) << "cache" << std::setw(12) << "overdraw"
+            << std::setw(12) << "fetch" << std::setw(10) << "ms" << "  output\n";
+
+  bool allValid = true;
+  for (auto &file : files) {
+    std::vector<ppgso::ShapeData> shapes;
+    try {
+      shapes = ppgso::Mesh::loadShapes(file);
+    } catch (const std::exception &e) {
+      std::cerr << e.what();
+      allValid = false;
+      continue;
+    }
+
+    // ACMR of every pass weighted by the triangles of the shapes, ATVR of the last one by their vertices
+    double acmr[4] = {}, atvr[2] = {};
+    size_t triangles = 0, verticesBefore = 0, verticesAfter = 0;
+    double time = 0;
+    bool valid = true;
+    for (auto &shape : shapes) {
+      auto reference = getTriangles(shape);
+      size_t count = shape.indices.size() / 3;
+      size_t vertexCount = shape.positions.size() / 3;
+      auto fileOrder = analyze(shape);
+
+      auto start = Clock::now();
+      ppgso::optimizeVertexCache(shape.indices, vertexCount);
+      auto cache = analyze(shape);
+      ppgso::optimizeOverdraw(shape.indices, shape.positions);
+      auto overdraw = analyze(shape);
+      ppgso::optimizeVertexFetch(shape);
+      auto fetch = analyze(shape);
+      time += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+      // Renaming vertices does not change which of them hit the cache
+      valid = valid && indicesValid(shape) && inFirstUseOrder(shape) && getTriangles(shape) == reference &&
+              cache.acmr <= fileOrder.acmr + 1e-9 &&
+              std::abs(fetch.acmr - overdraw.acmr) < 1e-9;
+
+      acmr[0] += fileOrder.acmr * count;
+      acmr[1] += cache.acmr * count;
+      acmr[2] += overdraw.acmr * count;
+      acmr[3] += fetch.acmr * count;
+      atvr[0] += fileOrder.atvr * vertexCount;
+      atvr[1] += fetch.atvr * (shape.positions.size() / 3);
+      triangles += count;
+      verticesBefore += vertexCount;
+      verticesAfter += shape.positions.size() / 3;
+    }
+    allValid = allValid && valid;
+
+    std::cout << std::left << std::setw(24) << file << std::right << std::setw(10) << triangles
+              << std::fixed << std::setprecision(3);
+    for (auto value : acmr)
+      std::cout << std::setw(12) << (triangles ? value / triangles : 0.0);
+    std::cout << std::setprecision(2) << std::setw(10) << time << (valid ? "  valid" : "  INVALID") << "\n";
+    std::cout << std::left << std::setw(24) << "" << std::right << std::setprecision(3) << "  ATVR "
+              << (verticesBefore ? atvr[0] / verticesBefore : 0.0) << " -> "
+              << (verticesAfter ? atvr[1] / verticesAfter : 0.0) << "\n";
+  }
+  std::cout << "ACMR per pass, 0.5 is the best possible for large meshes\n";
+
+  return allValid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
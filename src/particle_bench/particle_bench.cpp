@@ -0,0 +1,91 @@
+// Benchmark of the particle update used by 1projekt
+// - Integrates 1M particles with every update kernel the processor supports, on one thread and on all cores
+// - Checks that the SIMD kernels produce exactly the same positions as the scalar one
+// - Usage: particle_bench [particle count]
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include "../1projekt/particle_pool.h"
+#include "../bench/bench.h"
+
+// Best of more runs than the default hides page faults of the first touch
+const int UPDATE_RUNS = 10;
+const float TIME_STEP = 1.0f / 60.0f;
+
+// Same random particles for every kernel, they never die so every run updates all of them
+void fill(ParticlePool &pool, size_t count) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+  pool.clear();
+  for (size_t i = 0; i < count; i++) {
+    glm::vec3 position{dist(gen), dist(gen), dist(gen)};
+    glm::vec3 velocity{dist(gen), dist(gen), dist(gen)};
+    pool.spawn(position, velocity, glm::vec3(0.0f, 0.0f, 1.0f), std::numeric_limits<float>::infinity());
+  }
+}
+
+bool samePositions(const ParticlePool &a, const ParticlePool &b) {
+  for (auto array : {ParticlePool::X, ParticlePool::Y, ParticlePool::Z})
+    if (!std::equal(a.data(array), a.data(array) + a.size(), b.data(array)))
+      return false;
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  const glm::vec3 gravity{0.0f, -9.8f, 0.0f};
+
+  ParticlePool reference{count};
+  fill(reference, count);
+  reference.setKernel(ParticlePool::Kernel::Scalar);
+  reference.setThreads(1);
+  reference.integrate(TIME_STEP, gravity);
+
+  std::cout << count << " particles\n";
+  std::cout << std::left << std::setw(10) << "kernel" << std::right << std::setw(12) << "x1 ms"
+            << std::setw(12) << "xN ms" << std::setw(14) << "M/s xN" << "  output\n";
+
+  bool allSame = true;
+  const std::pair<ParticlePool::Kernel, const char *> kernels[] = {
+          {ParticlePool::Kernel::Scalar, "scalar"},
+          {ParticlePool::Kernel::SSE, "sse"},
+          {ParticlePool::Kernel::AVX, "avx"}
+  };
+  ParticlePool pool{count};
+  for (auto &kernel : kernels) {
+    if (!ParticlePool::isSupported(kernel.first)) {
+      std::cout << std::left << std::setw(10) << kernel.second << "not supported\n";
+      continue;
+    }
+    pool.setKernel(kernel.first);
+
+    // One step from the same start has to match the scalar kernel bit for bit
+    fill(pool, count);
+    pool.setThreads(0);
+    pool.integrate(TIME_STEP, gravity);
+    bool same = samePositions(reference, pool);
+    allSame = allSame && same;
+
+    pool.setThreads(1);
+    double single = bestTime([&] { pool.integrate(TIME_STEP, gravity); }, UPDATE_RUNS);
+    pool.setThreads(0);
+    double parallel = bestTime([&] { pool.integrate(TIME_STEP, gravity); }, UPDATE_RUNS);
+
+    std::cout << std::left << std::setw(10) << kernel.second << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << single << std::setw(12) << parallel
+              << std::setw(14) << std::setprecision(1) << count / parallel / 1000.0
+              << "  " << (same ? "same" : "DIFFERENT") << "\n";
+  }
+
+  // Whole update with the best kernel, including the removal of particles that fell below the floor
+  pool.setKernel(ParticlePool{0}.getKernel());
+  fill(pool, count);
+  double update = bestTime([&] { pool.update(TIME_STEP, gravity, -9.0f); }, UPDATE_RUNS);
+  std::cout << "update with removal: " << std::setprecision(3) << update << " ms, " << pool.size() << " left\n";
+
+  return allSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,138 @@
+// Offline converter from Wavefront .obj files to binary .ppmesh files
+// - Parses each obj file with the same loader the ppgso library is built with
+// - Writes the GPU ready geometry next to it, ppgso::Mesh picks it up automatically when it is newer than the obj
+// - Optimizes triangle and vertex order for the vertex cache, overdraw and vertex fetch, prints ACMR/ATVR per pass
+// - Generates levels of detail at 50 %, 25 % and 10 % of the triangles with quadric edge collapses
+// - Reports the GPU memory of the float and the packed vertex format
+// - Usage: ppmesh_convert [--no-optimize] model.obj [model2.obj ...]
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <ppgso/ppgso.h>
+#include <ppgso/mesh_file.h>
+#include <ppgso/mesh_optimizer.h>
+#include <ppgso/mesh_simplifier.h>
+
+using Clock = std::chrono::high_resolution_clock;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/*!
+ * Vertex cache statistics of all shapes of a model, weighted by their triangle and vertex counts.
+ */
+ppgso::VertexCacheStats analyzeShapes(const std::vector<ppgso::ShapeData> &shapes) {
+  ppgso::VertexCacheStats total;
+  size_t triangles = 0, vertices = 0;
+  for (auto &shape : shapes) {
+    auto stats = ppgso::analyzeVertexCache(shape.indices, shape.positions.size() / 3);
+    total.acmr += stats.acmr * (shape.indices.size() / 3);
+    total.atvr += stats.atvr * (shape.positions.size() / 3);
+    triangles += shape.indices.size() / 3;
+    vertices += shape.positions.size() / 3;
+  }
+  if (triangles) total.acmr /= triangles;
+  if (vertices) total.atvr /= vertices;
+  return total;
+}
+
+void printStats(const char *pass, const ppgso::VertexCacheStats &stats) {
+  std::cout << "  " << pass << ": ACMR " << stats.acmr << ", ATVR " << stats.atvr << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  bool optimize = true;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--no-optimize") == 0)
+      optimize = false;
+    else
+      files.emplace_back(argv[i]);
+  }
+
+  if (files.empty()) {
+    std::cerr << "Usage: " << argv[0] << " [--no-optimize] model.obj [model2.obj ...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int failed = 0;
+  for (auto &obj : files) {
+    auto ppmesh = ppgso::MeshFile::getBinaryPath(obj);
+
+    try {
+      auto start = Clock::now();
+      auto shapes = ppgso::Mesh::loadShapes(obj);
+      auto parseTime = millisecondsSince(start);
+
+      std::cout << obj << std::endl;
+      if (optimize) {
+        printStats("file order", analyzeShapes(shapes));
+
+        start = Clock::now();
+        for (auto &shape : shapes)
+          ppgso::optimizeVertexCache(shape.indices, shape.positions.size() / 3);
+        printStats("vertex cache", analyzeShapes(shapes));
+
+        for (auto &shape : shapes)
+          ppgso::optimizeOverdraw(shape.indices, shape.positions);
+        printStats("overdraw", analyzeShapes(shapes));
+
+        for (auto &shape : shapes)
+          ppgso::optimizeVertexFetch(shape);
+        printStats("vertex fetch", analyzeShapes(shapes));
+        std::cout << "  optimized in " << millisecondsSince(start) << " ms" << std::endl;
+      }
+
+      // Levels of detail come last, they index the final vertex order
+      start = Clock::now();
+      size_t lodCount = 1;
+      for (auto &shape : shapes) {
+        ppgso::generateLods(shape);
+        lodCount = std::max(lodCount, shape.lodIndexCounts.size());
+      }
+      auto generateTime = millisecondsSince(start);
+
+      // Shapes with fewer levels keep drawing their coarsest one
+      std::vector<size_t> lodTriangles(lodCount, 0);
+      for (auto &shape : shapes) {
+        auto view = shape.view();
+        for (size_t i = 0; i < lodCount; i++) {
+          auto indices = view.lodCount ? view.lodIndexCounts[std::min(i, view.lodCount - 1)] : view.indicesSize;
+          lodTriangles[i] += indices / 3;
+        }
+      }
+      std::cout << "  levels of detail:";
+      for (auto count : lodTriangles)
+        std::cout << " " << count;
+      std::cout << " triangles in " << generateTime << " ms" << std::endl;
+
+      std::vector<ppgso::ShapeView> views;
+      size_t vertices = 0, triangles = 0, floatSize = 0, packedSize = 0;
+      for (auto &shape : shapes) {
+        views.push_back(shape.view());
+        vertices += shape.positions.size() / 3;
+        triangles += (shape.lodIndexCounts.empty() ? shape.indices.size() : shape.lodIndexCounts[0]) / 3;
+        floatSize += ppgso::MeshBase::getByteSize(views.back(), ppgso::VertexFormat::Float);
+        packedSize += ppgso::MeshBase::getByteSize(views.back(), ppgso::VertexFormat::Packed);
+      }
+      ppgso::MeshFile::save(ppmesh, views);
+
+      // Mapping and validating is all the work left for the binary file at load time
+      start = Clock::now();
+      ppgso::MeshFile file{ppmesh};
+      auto mapTime = millisecondsSince(start);
+
+      std::cout << obj << " -> " << ppmesh << ": " << shapes.size() << " shapes, " << vertices << " vertices, "
+                << triangles << " triangles, parse " << parseTime << " ms, map " << mapTime << " ms, float "
+                << floatSize / 1024 << " KB, packed " << packedSize / 1024 << " KB" << std::endl;
+    } catch (std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      failed++;
+    }
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+// Offline converter from BMP images to .pptex textures with precomputed mipmaps
+// - Filters the full mipmap chain on the CPU and block compresses it with BC1 by default
+// - Reads the written file back and compares every decoded level with its uncompressed version by PSNR
+// - ppgso::AssetCache picks the .pptex up automatically when it is newer than the BMP
+// - Usage: pptex_convert [--rgb|--bc1|--bc3] [--min-psnr dB] texture.bmp [texture2.bmp ...]
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#include <ppgso/ppgso.h>
+#include <ppgso/image_mipmap.h>
+#include <ppgso/texture_file.h>
+
+using Clock = std::chrono::high_resolution_clock;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  auto format = ppgso::TextureFile::BC1;
+  // Noisy textures like grass end up around 25 dB with BC1, a broken encoder falls far below this
+  double minPSNR = 22.0;
+
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--rgb") == 0) {
+      format = ppgso::TextureFile::RGB8;
+    } else if (std::strcmp(argv[i], "--bc1") == 0) {
+      format = ppgso::TextureFile::BC1;
+    } else if (std::strcmp(argv[i], "--bc3") == 0) {
+      format = ppgso::TextureFile::BC3;
+    } else if (std::strcmp(argv[i], "--min-psnr") == 0 && i + 1 < argc) {
+      minPSNR = std::atof(argv[++i]);
+    } else {
+      files.emplace_back(argv[i]);
+    }
+  }
+
+  if (files.empty()) {
+    std::cerr << "Usage: " << argv[0] << " [--rgb|--bc1|--bc3] [--min-psnr dB] texture.bmp [texture2.bmp ...]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int failed = 0;
+  size_t totalRGB = 0, totalFile = 0;
+  for (auto &bmp : files) {
+    auto pptex = ppgso::TextureFile::getBinaryPath(bmp);
+
+    try {
+      auto start = Clock::now();
+      auto levels = ppgso::image::generateMipmaps(ppgso::image::loadBMP(bmp));
+      auto filterTime = millisecondsSince(start);
+
+      start = Clock::now();
+      ppgso::TextureFile::save(pptex, format, levels);
+      auto encodeTime = millisecondsSince(start);
+
+      // Round trip through the written file, the error of all levels weighted by their pixel count decides
+      // whether the conversion passes, the few pixels of the smallest levels alone say little
+      ppgso::TextureFile file{pptex};
+      double basePSNR = ppgso::image::psnr(levels[0], file.decode(0));
+      double squaredError = 0.0;
+      size_t pixels = 0, rgbSize = 0, fileSize = 0;
+      for (size_t level = 0; level < levels.size(); level++) {
+        auto count = levels[level].getFramebuffer().size();
+        auto levelPSNR = ppgso::image::psnr(levels[level], file.decode(level));
+        squaredError += count * 255.0 * 255.0 / std::pow(10.0, levelPSNR / 10.0);
+        pixels += count;
+        rgbSize += count * sizeof(ppgso::Image::Pixel);
+        fileSize += file.getLevels()[level].size;
+      }
+      double chainPSNR = squaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 * pixels / squaredError)
+                                            : std::numeric_limits<double>::infinity();
+      totalRGB += rgbSize;
+      totalFile += fileSize;
+
+      std::cout << bmp << " -> " << pptex << ": " << levels[0].width << "x" << levels[0].height << ", "
+                << levels.size() << " levels, " << rgbSize / 1024 << " KB RGB -> " << fileSize / 1024 << " KB ("
+                << (double) rgbSize / fileSize << "x), PSNR base " << basePSNR << " dB, all levels " << chainPSNR << " dB, filter " << filterTime
+                << " ms, encode " << encodeTime << " ms" << std::endl;
+
+      if (chainPSNR < minPSNR) {
+        std::cerr << bmp << ": PSNR " << chainPSNR << " dB is below " << minPSNR << " dB" << std::endl;
+        failed++;
+      }
+    } catch (std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      failed++;
+    }
+  }
+
+  if (totalFile)
+    std::cout << "Total: " << totalRGB / 1024 << " KB RGB -> " << totalFile / 1024 << " KB ("
+              << (double) totalRGB / totalFile << "x)" << std::endl;
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
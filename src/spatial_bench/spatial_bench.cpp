@@ -0,0 +1,192 @@
+// Benchmark of the spatial index used by 1projekt
+// - Fills a city sized to the object count with boxes, a few of them moving like cars
+// - Runs the frustum, sphere, box and ray queries of the window and the cars against linear scans of all boxes
+// - Checks that both find the same number of objects
+// - Usage: spatial_bench [largest object count]
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../1projekt/spatial_grid.h"
+#include "../bench/bench.h"
+
+const float CELL_SIZE = 10.0f;
+// Objects per 10 m cell, about as dense as the props and buildings of 1projekt
+const int OBJECTS_PER_CELL = 4;
+// Every tenth object moves, the cars
+const int MOVING_EVERY = 10;
+const int QUERIES = 1000;
+const float LIGHT_RADIUS = 25.0f;
+const float RAY_LENGTH = 100.0f;
+
+struct Box {
+  glm::vec3 min, max;
+};
+
+bool overlaps(const Box &a, const Box &b) {
+  return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::lessThanEqual(b.min, a.max));
+}
+
+bool inSphere(const Box &box, const glm::vec3 &center, float radius) {
+  glm::vec3 offset = glm::clamp(center, box.min, box.max) - center;
+  return glm::dot(offset, offset) <= radius * radius;
+}
+
+bool hitByRay(const Box &box, const glm::vec3 &start, const glm::vec3 &direction, float maxDistance) {
+  float enter = 0.0f, leave = maxDistance;
+  for (int axis = 0; axis < 3; axis++) {
+    if (direction[axis] == 0.0f) {
+      if (start[axis] < box.min[axis] || start[axis] > box.max[axis]) return false;
+      continue;
+    }
+    float first = (box.min[axis] - start[axis]) / direction[axis];
+    float second = (box.max[axis] - start[axis]) / direction[axis];
+    enter = std::max(enter, std::min(first, second));
+    leave = std::min(leave, std::max(first, second));
+    if (enter > leave) return false;
+  }
+  return true;
+}
+
+void printRow(const char *query, double linear, double grid, size_t linearHits, size_t gridHits) {
+  std::cout << "  " << std::left << std::setw(10) << query << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << linear << std::setw(12) << grid << std::setw(10) << std::setprecision(1)
+            << linear / grid << "x  " << (linearHits == gridHits ? "same" : "DIFFERENT") << "\n";
+}
+
+// Returns false when the grid and the scan disagree
+bool run(size_t count) {
+  int cells = std::max(1, (int) std::ceil(std::sqrt((double) count / OBJECTS_PER_CELL)));
+  float size = cells * CELL_SIZE;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> position(-CELL_SIZE * 0.5f, size - CELL_SIZE * 0.5f);
+  std::uniform_real_distribution<float> halfSize(0.3f, 4.0f);
+  std::uniform_real_distribution<float> height(1.0f, 30.0f);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+  std::vector<Box> boxes(count);
+  SpatialGrid<size_t> grid{glm::vec3(0.0f), CELL_SIZE, cells, cells};
+  std::vector<SpatialGrid<size_t>::Handle> handles(count);
+  for (size_t i = 0; i < count; i++) {
+    glm::vec3 center{position(gen), 0.0f, position(gen)};
+    glm::vec3 half{halfSize(gen), 0.0f, halfSize(gen)};
+    boxes[i] = {center - half, center + half + glm::vec3(0.0f, height(gen), 0.0f)};
+    handles[i] = grid.insert(i, boxes[i].min, boxes[i].max);
+  }
+
+  std::vector<glm::vec3> points(QUERIES), directions(QUERIES);
+  for (int i = 0; i < QUERIES; i++) {
+    points[i] = {position(gen), 2.0f, position(gen)};
+    directions[i] = glm::normalize(glm::vec3(unit(gen), unit(gen) * 0.1f, unit(gen)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+  }
+
+  std::cout << count << " objects in " << cells << "x" << cells << " cells\n";
+  std::cout << "  " << std::left << std::setw(10) << "query" << std::right << std::setw(12) << "linear ms"
+            << std::setw(12) << "grid ms" << std::setw(11) << "speedup" << "  result\n";
+  bool allSame = true;
+  size_t linearHits = 0, gridHits = 0;
+
+  // Street level camera in the middle of the city, the main pass of 1projekt
+  glm::vec3 eye{size * 0.5f, 2.0f, size * 0.5f};
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  std::vector<Frustum> frustums;
+  for (int i = 0; i < 16; i++) {
+    float angle = glm::two_pi<float>() * i / 16;
+    glm::vec3 target = eye + glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+    frustums.emplace_back(projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+  }
+  double linear = bestTime([&] {
+    linearHits = 0;
+    for (auto &frustum : frustums)
+      for (auto &box : boxes) linearHits += frustum.intersects(box.min, box.max);
+  });
+  double indexed = bestTime([&] {
+    gridHits = 0;
+    for (auto &frustum : frustums) grid.queryFrustum(frustum, [&](size_t) { gridHits++; });
+  });
+  printRow("frustum", linear, indexed, linearHits, gridHits);
+  allSame = allSame && linearHits == gridHits;
+
+  // Lights around the camera
+  linear = bestTime([&] {
+    linearHits = 0;
+    for (auto &point : points)
+      for (auto &box : boxes) linearHits += inSphere(box, point, LIGHT_RADIUS);
+  });
+  indexed = bestTime([&] {
+    gridHits = 0;
+    for (auto &point : points) grid.querySphere(point, LIGHT_RADIUS, [&](size_t) { gridHits++; });
+  });
+  printRow("sphere", linear, indexed, linearHits, gridHits);
+  allSame = allSame && linearHits == gridHits;
+
+  // Collision tests of the moving objects against everything around them
+  linear = bestTime([&] {
+    linearHits = 0;
+    for (size_t i = 0; i < count; i += MOVING_EVERY) {
+      Box area{boxes[i].min - 1.0f, boxes[i].max + 1.0f};
+      for (auto &box : boxes) linearHits += overlaps(box, area);
+    }
+  });
+  indexed = bestTime([&] {
+    gridHits = 0;
+    for (size_t i = 0; i < count; i += MOVING_EVERY)
+      grid.queryBox(boxes[i].min - 1.0f, boxes[i].max + 1.0f, [&](size_t) { gridHits++; });
+  });
+  printRow("box", linear, indexed, linearHits, gridHits);
+  allSame = allSame && linearHits == gridHits;
+
+  linear = bestTime([&] {
+    linearHits = 0;
+    for (int i = 0; i < QUERIES; i++)
+      for (auto &box : boxes) linearHits += hitByRay(box, points[i], directions[i], RAY_LENGTH);
+  });
+  indexed = bestTime([&] {
+    gridHits = 0;
+    for (int i = 0; i < QUERIES; i++)
+      grid.queryRay(points[i], directions[i], RAY_LENGTH, [&](size_t, float) { gridHits++; });
+  });
+  printRow("ray", linear, indexed, linearHits, gridHits);
+  allSame = allSame && linearHits == gridHits;
+
+  // One frame of moving objects updated in place, a car drives about 8 cm per frame
+  glm::vec3 step{0.08f, 0.0f, 0.0f};
+  double update = bestTime([&] {
+    for (size_t i = 0; i < count; i += MOVING_EVERY) {
+      boxes[i].min += step;
+      boxes[i].max += step;
+      grid.update(handles[i], boxes[i].min, boxes[i].max);
+    }
+  });
+  std::cout << "  update of " << (count + MOVING_EVERY - 1) / MOVING_EVERY << " moving objects: "
+            << std::setprecision(3) << update << " ms\n";
+
+  // The moved objects have to be found where they are now
+  gridHits = 0;
+  grid.queryFrustum(frustums.front(), [&](size_t) { gridHits++; });
+  linearHits = 0;
+  for (auto &box : boxes) linearHits += frustums.front().intersects(box.min, box.max);
+  if (linearHits != gridHits) {
+    std::cout << "  frustum after update: DIFFERENT\n";
+    allSame = false;
+  }
+  return allSame;
+}
+
+int main(int argc, char *argv[]) {
+  size_t largest = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+  bool allSame = true;
+  for (size_t count = 1000; count <= largest; count *= 10)
+    allSame = run(count) && allSame;
+
+  return allSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}